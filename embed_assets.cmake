@@ -0,0 +1,48 @@
+# embed_assets.cmake
+#
+# Script mode (cmake -P) helper invoked by embed_assets() in functions.cmake.
+# Converts each asset into a constexpr byte array and writes an indexed table
+# consumed by src/utils/assets.cpp.
+#
+# Inputs:
+#   OUTPUT_FILE  Path of the generated C++ source file
+#   BASE_DIR     Directory the asset names are made relative to
+#   ASSET_FILES  '|' separated list of absolute asset paths
+
+string(REPLACE "|" ";" ASSET_FILES "${ASSET_FILES}")
+
+set(content "// Generated by embed_assets.cmake, do not edit.\n")
+string(APPEND content "#include \"assets.hpp\"\n\n")
+string(APPEND content "namespace {\n\n")
+
+# 64 hex digits (32 bytes) per line
+string(REPEAT "[0-9a-f]" 64 line_pattern)
+
+set(table "")
+set(index 0)
+foreach(asset_file ${ASSET_FILES})
+    file(RELATIVE_PATH asset_name "${BASE_DIR}" "${asset_file}")
+    file(READ "${asset_file}" hex HEX)
+
+    # 32 bytes per line keeps the generated source readable for compilers and diffs
+    string(REGEX REPLACE "(${line_pattern})" "\\1\n" hex "${hex}")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+
+    string(APPEND content "// ${asset_name}\n")
+    string(APPEND content "constexpr unsigned char asset_${index}[] = {\n${bytes}\n};\n\n")
+    string(APPEND table "    {\"${asset_name}\", asset_${index}, sizeof(asset_${index})},\n")
+    math(EXPR index "${index} + 1")
+endforeach()
+
+string(APPEND content "} // namespace\n\n")
+string(APPEND content "const Assets::Asset Assets::embedded[] = {\n${table}};\n\n")
+string(APPEND content "const size_t Assets::embeddedCount = ${index};\n")
+
+# Only touch the output when it changed to avoid needless recompiles
+if(EXISTS "${OUTPUT_FILE}")
+    file(READ "${OUTPUT_FILE}" previous)
+    if(previous STREQUAL content)
+        return()
+    endif()
+endif()
+file(WRITE "${OUTPUT_FILE}" "${content}")
@@ -29,3 +29,24 @@ function(copy_dirs_post_build project_name source_dirs target_dir)
         )
     endforeach()
 endfunction()
+
+
+# Function to compile asset files into the executable as constexpr byte arrays
+function(embed_assets project_name asset_files base_dir)
+    set(output_file "${CMAKE_CURRENT_BINARY_DIR}/generated/embedded_assets.cpp")
+    # Lists cannot be passed through -D as-is, the script splits on '|'
+    string(REPLACE ";" "|" asset_list "${asset_files}")
+
+    add_custom_command(
+        OUTPUT ${output_file}
+        COMMAND ${CMAKE_COMMAND}
+            -DOUTPUT_FILE=${output_file}
+            -DBASE_DIR=${base_dir}
+            -DASSET_FILES=${asset_list}
+            -P ${CMAKE_SOURCE_DIR}/embed_assets.cmake
+        DEPENDS ${asset_files} ${CMAKE_SOURCE_DIR}/embed_assets.cmake
+        COMMENT "Embedding assets into ${project_name}"
+        VERBATIM
+    )
+    target_sources(${project_name} PRIVATE ${output_file})
+endfunction()
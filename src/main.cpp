@@ -1,11 +1,34 @@
 #include "main.hpp"
 
-int main() {
-    const char iniFilename[] = "settings.ini";
-    std::unique_ptr<CSimpleIniA> ini = LoadConfig(iniFilename);
-    const WindowParams windowParams = GetWindowParams(ini);
+int main(int argc, char *argv[]) {
+    // Render at native resolution on every monitor instead of being bitmap-stretched. First,
+    // the process awareness must be set before any window or the browser process is created.
+    ImGui_ImplWin32_EnableDpiAwareness();
+
+    const long long configStart = Tracer::Now();
+    const ConfigOverrides overrides = GetConfigOverrides(argc, argv);
+    if (overrides.traceFile) Tracer::Enable(*overrides.traceFile);
+
+    const std::string iniFilename = overrides.configFile.value_or("settings.ini");
+    std::unique_ptr<CSimpleIniA> ini = LoadConfig(iniFilename.c_str());
+    const WindowParams windowParams = GetWindowParams(ini, overrides);
+    SettingsArgs settingsArgs = GetSettingsArgs(ini, overrides);
+    Tracer::Complete("Config Load", configStart, Tracer::Now());
+
+    // Start the WebView2 environment (browser process launch) first so it
+    // runs concurrently with D3D device creation, font and icon loading.
+    WebView webview(settingsArgs.env_options, settingsArgs.profile);
+    // Decode toolbar icons on worker threads while the device is created
+    std::vector<std::future<Utils::ImageData>> omniBarImages = DecodeOmniBarImagesAsync();
 
     Window window(windowParams);
+    // Keep the decoded sources so the icons can be re-rasterized on DPI change.
+    // The first font atlas bake in Init() waits for the decoding workers.
+    std::vector<Utils::ImageData> omniBarIcons;
+    window.SetAtlasImages([&omniBarImages, &omniBarIcons](float dpiScale) {
+        if (omniBarIcons.empty()) omniBarIcons = Utils::WaitForImages(omniBarImages);
+        return ScaleOmniBarIcons(omniBarIcons, dpiScale);
+    });
 
     if (!window.Init()) {
         Log::Critical("Failed to initialize window");
@@ -13,6 +36,7 @@ int main() {
     }
 
     const HWND hwnd = window.GetWindowHandle();
+    Widgets::SetDpiScale(window.GetDpiScale());
 
     RECT winRect = {
         windowParams.posX, windowParams.posY,
@@ -27,32 +51,45 @@ int main() {
     Log::SetWindowName(windowParams.windowName);
     // Set Log filename, if empty MessageBox will be used.
     Log::SetLogFile(ini->GetValue("Logging", "Filename", ""));
+    for (const std::string &warning : overrides.warnings) Log::Warning("%s", warning.c_str());
 
-    SettingsArgs settingsArgs = GetSettingsArgs(ini);
     SettingsCallbacks settingsCallbacks = GetSettingsCallbacks(ini, hwnd);
     ApplyInitialSettings(settingsCallbacks, settingsArgs);
     // Install and Register keybinds
     KeybindListener::InstallHook();
     RegisterKeybinds(settingsArgs, window, hwnd);
 
-    WebView webview(hwnd, settingsArgs.env_options);
-    // Find WebView2 window handle attached to the main ImGui window
-    HWND webviewHwnd = FindWindowEx(hwnd, nullptr, "Chrome_WidgetWin_0", nullptr);
+    // Create the controller as soon as the environment is ready
+    webview.Attach(hwnd);
+    // WebView2 window handle attached to the main ImGui window, set once initialized
+    HWND webviewHwnd = nullptr;
+
+    ScreenshotManager screenshotManager(window.GetDevice(), GetScreenshotSettings(ini));
+    screenshotManager.SetWindows(hwnd, webviewHwnd);
+    screenshotManager.SetPageCapture([&webview](std::function<void(std::vector<unsigned char>)> pngCallback) {
+        return webview.CapturePreview(std::move(pngCallback));
+    });
+    screenshotManager.SetScriptRunner([&webview](std::string script, std::function<void(std::string)> resultCallback) {
+        webview.ExecuteScript(std::move(script), std::move(resultCallback));
+    });
 
-    constexpr float omniBarHeight = 28.0f;
+    float omniBarHeight = Widgets::Scaled(28.0f);
     std::string website_url = settingsArgs.website_url;
     RECT bounds = {0, 0, 0, 0};  // ImGui window bounds
     RECT wBounds = {0, 0, 0, 0}; // WebView window bounds
 
     window.OnResize([&webview, &hwnd, &bounds, &omniBarHeight, &webviewHwnd, &wBounds]() {
         GetClientRect(hwnd, &bounds);
-        bounds.top += static_cast<LONG>(omniBarHeight + 4.8f);
+        bounds.top += static_cast<LONG>(omniBarHeight + Widgets::Scaled(4.8f));
         webview.Resize(bounds);
         // Update WebView window bounds
         GetClientRect(webviewHwnd, &wBounds);
     });
 
-    webview.OnInitialized([&window, &webview, &website_url]() {
+    webview.OnInitialized([&window, &webview, &website_url, &hwnd, &webviewHwnd, &screenshotManager]() {
+        // Find WebView2 window handle attached to the main ImGui window
+        webviewHwnd = FindWindowEx(hwnd, nullptr, "Chrome_WidgetWin_0", nullptr);
+        screenshotManager.SetWindows(hwnd, webviewHwnd);
         webview.Navigate(website_url);
         window.TriggerResizeCallback();
     });
@@ -61,13 +98,75 @@ int main() {
         website_url = url;
     });
 
-    ScreenshotManager screenshotManager(window.GetDevice());
+    KeybindListener::RegisterKeybind(settingsArgs.screenshotHotKey, [&screenshotManager]() {
+        screenshotManager.CaptureToFile();
+    });
+    settingsCallbacks.diagnosticsCallback = [&screenshotManager]() {
+        const ScreenshotManager::Stats &stats = screenshotManager.GetStats();
+        ImGui::Text("Screenshots: %llu, last allocated %.2f MB, total %.2f MB",
+                    static_cast<unsigned long long>(stats.captures),
+                    stats.lastCaptureBytes / (1024.0 * 1024.0), stats.totalAllocatedBytes / (1024.0 * 1024.0));
+        ImGui::Text("Screenshot reuse: %llu buffers, %llu textures, %.2f MB retained",
+                    static_cast<unsigned long long>(stats.bufferReuses),
+                    static_cast<unsigned long long>(stats.textureReuses),
+                    screenshotManager.GetRetainedBytes() / (1024.0 * 1024.0));
+        const ScreenshotHistory::Stats history = screenshotManager.GetHistoryStats();
+        ImGui::Text("Screenshot history: %zu entries, %zu/%zu tiles shared, %.2f MB (%.2f MB raw)",
+                    history.entries, history.tileReferences - history.uniqueTiles, history.tileReferences,
+                    history.compressedBytes / (1024.0 * 1024.0), history.rawBytes / (1024.0 * 1024.0));
+        ImGui::Text("Near-duplicates: %llu collapsed in history, %llu hotkey saves skipped",
+                    static_cast<unsigned long long>(stats.collapsedDuplicates),
+                    static_cast<unsigned long long>(stats.skippedDuplicateSaves));
+        const ScreenRecorder::Stats recording = screenshotManager.GetRecordingStats();
+        if (recording.captured > 0) {
+            ImGui::Text("Recording: %.1f s, %llu frames encoded, %llu unchanged, %llu dropped, %.2f MB queued, %.2f MB written",
+                        recording.seconds, static_cast<unsigned long long>(recording.encoded),
+                        static_cast<unsigned long long>(recording.unchanged), static_cast<unsigned long long>(recording.dropped),
+                        recording.queuedBytes / (1024.0 * 1024.0), recording.fileBytes / (1024.0 * 1024.0));
+        }
+        const FullPageCapture::Stats &fullPage = screenshotManager.GetFullPageStats();
+        if (fullPage.frames > 0) {
+            ImGui::Text("Last full page: %d viewports, %d px tall, %d placed by scroll position, %.2f s",
+                        fullPage.frames, fullPage.height, fullPage.inexactFrames, fullPage.seconds);
+        }
+        if (stats.lastRedactMilliseconds > 0.0) {
+            ImGui::Text("Last redaction: %.2f ms, %llu preview texels uploaded", stats.lastRedactMilliseconds,
+                        static_cast<unsigned long long>(stats.lastRedactUploadPixels));
+        }
+        if (stats.lastDiffMilliseconds > 0.0) {
+            ImGui::Text("Last diff: %.2f ms, %.0f MB/s (%s), %zu tiles changed", stats.lastDiffMilliseconds,
+                        stats.lastDiffBytes / (stats.lastDiffMilliseconds * 1000.0),
+                        PixelConvert::GetIsaName(PixelConvert::GetActiveIsa()), stats.lastChangedTiles);
+        }
+    };
     ScreenshotCallbacks screenshotCallbacks = {
-        [&screenshotManager]() { screenshotManager.CopyToClipboard(); }
+        [&screenshotManager]() { screenshotManager.CopyToClipboard(); },
+        [&screenshotManager]() { screenshotManager.Save(); },
+        [&screenshotManager, &ini](CaptureMode mode) {
+            screenshotManager.SetCaptureMode(mode);
+            ini->SetValue("Screenshot", "Mode", GetCaptureModeName(mode));
+            screenshotManager.Capture();
+        },
+        [&screenshotManager]() { screenshotManager.Capture(); },
+        [&screenshotManager](int step) { screenshotManager.ShowHistory(step); },
+        [&screenshotManager](bool highlight) { screenshotManager.SetHighlightChanges(highlight); },
+        [&screenshotManager](RedactTool tool) { screenshotManager.SetRedactTool(tool); },
+        [&screenshotManager](RECT area) { screenshotManager.Redact(area); },
+        [&screenshotManager](int x, int y) { return screenshotManager.GetPixel(x, y); },
+        [&screenshotManager](bool record) { screenshotManager.SetRecording(record); },
+        [&screenshotManager]() { screenshotManager.CaptureFullPage(); },
+        [&screenshotManager](std::string selector) { screenshotManager.SetElementSelector(std::move(selector)); },
+        [&screenshotManager]() { screenshotManager.PickElement(); }
     };
 
-    const OmniBarImageTextures omniBarTextures =
-        LoadOmniBarImageTextures(window.GetDevice());
+    OmniBarImageTextures omniBarTextures = GetOmniBarImageTextures(window.GetAtlasImages());
+
+    window.OnDpiChange([&](float dpiScale) {
+        Widgets::SetDpiScale(dpiScale);
+        omniBarHeight = Widgets::Scaled(28.0f);
+        omniBarTextures = GetOmniBarImageTextures(window.GetAtlasImages());
+        window.TriggerResizeCallback();
+    });
 
     bool showSettings = false;   // settings visibility flag
     bool showScreenshot = false; // screenshot visibility flag
@@ -88,6 +187,7 @@ int main() {
 
     while (window.IsRunning()) {
         if (!window.Draw()) continue;
+        screenshotManager.Update();
 
         constexpr ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize |
                                                  ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollbar |
@@ -97,7 +197,7 @@ int main() {
         // Set full width and fixed height
         ImGui::SetNextWindowSize(ImVec2(io.DisplaySize.x, omniBarHeight));
 
-        ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(10, 2));
+        ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, Widgets::Scaled(ImVec2(10, 2)));
         ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
         ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.18f, 0.18f, 0.18f, 1.0f)); // Slightly lighter gray background
 
@@ -113,15 +213,24 @@ int main() {
         static RECT screenshotClipRect = RECT{0, 0, 0, 0};
         static RECT settingsClipRect = RECT{0, 0, 0, 0};
 
-        if (showScreenshot) {
+        // Hold the panel back until the screen is grabbed so it never shows up in the capture,
+        // and give the WebView its full region meanwhile so the page fills the panel's hole
+        const bool grabbing = screenshotManager.IsGrabbing();
+        if (grabbing && clipped) {
+            SetWindowRgn(webviewHwnd, nullptr, TRUE);
+            clipped = false;
+        }
+        if (showScreenshot && !grabbing) {
             if (!initialScreenshotSizeSet) {
                 // Center horizontally
-                ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x / 2, omniBarHeight + 10), ImGuiCond_Always, ImVec2(0.5f, 0.0f));
+                ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x / 2, omniBarHeight + Widgets::Scaled(10.0f)), ImGuiCond_Always, ImVec2(0.5f, 0.0f));
                 // Set initial window width and height
-                ImGui::SetNextWindowSize(ImVec2(600, 391));
+                ImGui::SetNextWindowSize(Widgets::Scaled(ImVec2(600, 391)));
                 initialScreenshotSizeSet = true;
             }
             ImGui::Begin("Screenshot", &showScreenshot, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoScrollbar);
+            const ImVec2 previewArea = ImGui::GetContentRegionAvail();
+            screenshotManager.SetPreviewSize(static_cast<int>(previewArea.x), static_cast<int>(previewArea.y));
             Widgets::Screenshot(screenshotManager.GetImage(), screenshotCallbacks);
             { // Update clipping rectangle and reset clipped flag on window move or resize
                 const ImVec2 pos = ImGui::GetWindowPos();
@@ -148,8 +257,8 @@ int main() {
         }
 
         if (showSettings) {
-            constexpr float settingsWidth = 500.0F;
-            constexpr float spacing = omniBarHeight + 4.5F;
+            const float settingsWidth = Widgets::Scaled(500.0F);
+            const float spacing = omniBarHeight + Widgets::Scaled(4.5F);
             constexpr ImGuiWindowFlags flags = ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove;
             // Set position at the top-left corner
             ImGui::SetNextWindowPos(ImVec2(min(io.DisplaySize.x, io.DisplaySize.x - settingsWidth), spacing + 0.5F));
@@ -178,7 +287,7 @@ int main() {
             ImGui::End(); // End Settings
         }
 
-        if ((showSettings || showScreenshot) && !clipped) {
+        if ((showSettings || showScreenshot) && !clipped && !grabbing) {
             // Create full region covering the child window
             HRGN fullRegion = CreateRectRgn(wBounds.top, wBounds.left, wBounds.right, wBounds.bottom);
             const LONG heightDelta = bounds.bottom - wBounds.bottom;
@@ -258,9 +367,16 @@ int main() {
         }
 
         window.Render();
+        if (grabbing) screenshotManager.ScreenCleared();
     }
 
     KeybindListener::UninstallHook();
-    SaveWindowPosition(ini, winRect);
-    return ini->SaveFile(iniFilename);
+    // Hand a copied screenshot over to the system before exiting
+    Clipboard::Shutdown();
+    // Write the trace even if the first navigation never completed
+    Tracer::Flush();
+    SaveWindowPosition(ini, overrides, winRect);
+    // Typed or picked, the selector is kept for the next session
+    ini->SetValue("Screenshot", "ElementSelector", screenshotManager.GetElementSelector().c_str());
+    return ini->SaveFile(iniFilename.c_str());
 }
\ No newline at end of file
@@ -1,5 +1,14 @@
 #include <SimpleIni.h>
 #include <memory> // For std::unique_ptr
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <optional>
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+#include <filesystem>
+#include <shlobj.h>
 #include "window.hpp"
 #include "widgets.hpp"
 #include "webview.hpp"
@@ -7,8 +16,95 @@
 #include "keybind_listener.hpp"
 #include "string_utils.hpp"
 #include "utils.hpp"
+#include "screenshot_manager.hpp"
+#include "clipboard.hpp"
+#include "pixel_convert.hpp"
+#include "tracer.hpp"
 #include "Log.hpp"
 
+// Values that take precedence over settings.ini for a single run. They are
+// applied to the structs built from the INI and never stored back into it.
+struct ConfigOverrides {
+    std::optional<std::string> configFile;
+    std::optional<std::string> url;
+    std::optional<std::string> size;
+    std::optional<std::string> position;
+    std::optional<std::string> profile;
+    std::optional<std::string> traceFile;
+    // Problems with the arguments, logged by the caller once the logger is set up
+    std::vector<std::string> warnings;
+
+    bool HasWindowGeometry() const { return size.has_value() || position.has_value(); }
+};
+
+/**
+ * @brief Collects configuration overrides in a single pass.
+ *
+ * Precedence (lowest to highest): built-in defaults, settings.ini,
+ * WEBFRAME_* environment variables, command line arguments.
+ * Arguments are accepted as `--name value` or `--name=value`, flags that
+ * have a default value (e.g. `--trace-startup`) may omit it.
+ */
+inline ConfigOverrides GetConfigOverrides(int argc, char *argv[]) {
+    ConfigOverrides overrides;
+
+    struct Option {
+        std::string_view name;
+        const char *envVar;
+        std::optional<std::string> *value;
+        const char *flagValue = nullptr; // Used when given without a value
+    };
+    const Option options[] = {
+        {"config", "WEBFRAME_CONFIG", &overrides.configFile},
+        {"url", "WEBFRAME_URL", &overrides.url},
+        {"size", "WEBFRAME_SIZE", &overrides.size},
+        {"pos", "WEBFRAME_POS", &overrides.position},
+        {"profile", "WEBFRAME_PROFILE", &overrides.profile},
+        {"trace-startup", "WEBFRAME_TRACE_STARTUP", &overrides.traceFile, "startup_trace.json"},
+    };
+
+    for (const Option &option : options) {
+        const char *value = std::getenv(option.envVar);
+        if (value != nullptr && *value != '\0') *option.value = value;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (!arg.starts_with("--")) {
+            overrides.warnings.push_back("Ignoring unexpected argument: " + std::string(argv[i]));
+            continue;
+        }
+        arg.remove_prefix(2);
+
+        std::string_view name = arg;
+        std::optional<std::string_view> value;
+        if (const size_t eq = arg.find('='); eq != std::string_view::npos) {
+            name = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        }
+
+        const auto it = std::find_if(std::begin(options), std::end(options), [&name](const Option &option) {
+            return option.name == name;
+        });
+        if (it == std::end(options)) {
+            overrides.warnings.push_back("Ignoring unknown option: " + std::string(argv[i]));
+            continue;
+        }
+        if (!value && it->flagValue != nullptr) {
+            value = it->flagValue;
+        } else if (!value) {
+            if (i + 1 >= argc) {
+                overrides.warnings.push_back("Missing value for option: " + std::string(argv[i]));
+                continue;
+            }
+            value = argv[++i];
+        }
+        *it->value = std::string(*value);
+    }
+
+    return overrides;
+}
+
 inline std::unique_ptr<CSimpleIniA> LoadConfig(const char *filename) {
     auto ini = std::make_unique<CSimpleIniA>();
     ini->SetUnicode(); // Use UTF-8 encoding
@@ -19,28 +115,57 @@ inline std::unique_ptr<CSimpleIniA> LoadConfig(const char *filename) {
     return ini;
 }
 
-inline OmniBarImageTextures LoadOmniBarImageTextures(ID3D11Device *device) {
-    const std::vector<ImTextureID> imageTextures = Utils::LoadImageTextures(
-        {
-            {"icons/backward.png"},
-            {"icons/forward.png"},
-            {"icons/refresh.png"},
-            {"icons/settings.png"},
-            {"icons/screenshot.png"},
-        },
-        device
-    );
+// Order matches the fields read back in GetOmniBarImageTextures
+inline std::vector<std::future<Utils::ImageData>> DecodeOmniBarImagesAsync() {
+    return Utils::DecodeImagesAsync({
+        Assets::Get("icons/backward.png"),
+        Assets::Get("icons/forward.png"),
+        Assets::Get("icons/refresh.png"),
+        Assets::Get("icons/settings.png"),
+        Assets::Get("icons/screenshot.png"),
+    });
+}
+
+// Resample each icon to the exact pixel size it is drawn at for the given DPI
+// scale, so the sampler never has to minify a large source at draw time.
+inline std::vector<Utils::ImageData> ScaleOmniBarIcons(const std::vector<Utils::ImageData> &icons, float dpiScale) {
+    TRACE_SCOPE("ScaleOmniBarIcons");
+    const ButtonProperties sizes[] = {
+        OmniBarButton::Arrow, OmniBarButton::Arrow, OmniBarButton::Refresh,
+        OmniBarButton::Settings, OmniBarButton::Screenshot
+    };
+
+    std::vector<Utils::ImageData> scaled;
+    scaled.reserve(icons.size());
+    for (size_t i = 0; i < icons.size(); i++) {
+        const ImVec2 size = i < std::size(sizes) ? sizes[i].size : ImVec2(32, 32);
+        const int width = std::max(1, static_cast<int>(std::lround(size.x * dpiScale)));
+        const int height = std::max(1, static_cast<int>(std::lround(size.y * dpiScale)));
+        scaled.push_back(Utils::ResizeImage(icons[i], width, height));
+    }
+    return scaled;
+}
+
+// The icons are packed into the font atlas, read again whenever its texture is recreated
+inline OmniBarImageTextures GetOmniBarImageTextures(const std::vector<Utils::AtlasRegion> &regions) {
+    const ImTextureID fontTexture = ImGui::GetIO().Fonts->TexID;
+
+    // Icons that failed to load show the whole font atlas texture
+    const auto image = [&regions, &fontTexture](size_t index) -> ImageRegion {
+        if (index >= regions.size() || !regions[index].valid) return {fontTexture};
+        return {fontTexture, regions[index].uv0, regions[index].uv1};
+    };
 
     return {
-        .backward_button = imageTextures.at(0),
-        .forward_button = imageTextures.at(1),
-        .refresh_button = imageTextures.at(2),
-        .settings_button = imageTextures.at(3),
-        .screenshot_button = imageTextures.at(4),
+        .backward_button = image(0),
+        .forward_button = image(1),
+        .refresh_button = image(2),
+        .settings_button = image(3),
+        .screenshot_button = image(4),
     };
 }
 
-inline WindowParams GetWindowParams(const std::unique_ptr<CSimpleIniA> &ini) {
+inline WindowParams GetWindowParams(const std::unique_ptr<CSimpleIniA> &ini, const ConfigOverrides &overrides) {
     constexpr int default_width = 800;
     constexpr int default_height = 600;
     constexpr int default_posX = 100;
@@ -51,8 +176,10 @@ inline WindowParams GetWindowParams(const std::unique_ptr<CSimpleIniA> &ini) {
     const std::string default_windowPos = std::to_string(default_posX) + ", " + std::to_string(default_posY);
 
     const std::string windowName = ini->GetValue("Window", "Name", default_windowName);
-    const std::string windowSize = ini->GetValue("Window", "Size", default_windowSize.c_str());
-    const std::string windowPos = ini->GetValue("Window", "Position", default_windowPos.c_str());
+    std::string windowSize = overrides.size.value_or(ini->GetValue("Window", "Size", default_windowSize.c_str()));
+    std::string windowPos = overrides.position.value_or(ini->GetValue("Window", "Position", default_windowPos.c_str()));
+    // Allow the "800x600" form commonly used on the command line
+    std::replace(windowSize.begin(), windowSize.end(), 'x', ',');
 
     std::vector<std::string> windowSizes = StringUtils::Split(windowSize, ',');
     std::vector<std::string> windowPositions = StringUtils::Split(windowPos, ',');
@@ -69,7 +196,10 @@ inline WindowParams GetWindowParams(const std::unique_ptr<CSimpleIniA> &ini) {
     };
 }
 
-inline void SaveWindowPosition(const std::unique_ptr<CSimpleIniA> &ini, const RECT &winRect) {
+inline void SaveWindowPosition(const std::unique_ptr<CSimpleIniA> &ini, const ConfigOverrides &overrides, const RECT &winRect) {
+    // Geometry given as an override belongs to this run only
+    if (overrides.HasWindowGeometry()) return;
+
     if (ini->GetBoolValue("Window", "RestorePosition", false)) {
         const LONG width = winRect.right - winRect.left;
         const LONG height = winRect.bottom - winRect.top;
@@ -84,10 +214,11 @@ inline void SaveWindowPosition(const std::unique_ptr<CSimpleIniA> &ini, const RE
     }
 }
 
-inline SettingsArgs GetSettingsArgs(const std::unique_ptr<CSimpleIniA> &ini) {
+inline SettingsArgs GetSettingsArgs(const std::unique_ptr<CSimpleIniA> &ini, const ConfigOverrides &overrides) {
     return {
-        .website_url = ini->GetValue("Webview", "Homepage", "https://www.google.com"),
+        .website_url = overrides.url.value_or(ini->GetValue("Webview", "Homepage", "https://www.google.com")),
         .env_options = ini->GetValue("Webview", "EnvironmentOptions", ""),
+        .profile = overrides.profile.value_or(ini->GetValue("Webview", "Profile", "")),
         .topmost = ini->GetBoolValue("WindowProps", "Topmost", false),
         .borderless = ini->GetBoolValue("WindowProps", "Borderless", false),
         .toolWindow = ini->GetBoolValue("WindowProps", "ToolWindow", false),
@@ -95,10 +226,83 @@ inline SettingsArgs GetSettingsArgs(const std::unique_ptr<CSimpleIniA> &ini) {
         .transparency = ini->GetLongValue("WindowProps", "Transparency", 255),
         .quitHotKey = ini->GetValue("HotKeys", "Quit", ""),
         .visibilityHotKey = ini->GetValue("HotKeys", "Visibility", ""),
-        .clickThroughHotKey = ini->GetValue("HotKeys", "ClickThrough", "")
+        .clickThroughHotKey = ini->GetValue("HotKeys", "ClickThrough", ""),
+        .screenshotHotKey = ini->GetValue("HotKeys", "Screenshot", "")
     };
 }
 
+// Screenshots are saved to Pictures\WebFrame unless a directory is configured
+inline std::filesystem::path GetDefaultScreenshotDirectory() {
+    PWSTR pictures = nullptr;
+    std::filesystem::path directory = "Screenshots";
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_Pictures, 0, nullptr, &pictures))) {
+        directory = std::filesystem::path(pictures) / "WebFrame";
+    }
+    CoTaskMemFree(pictures);
+    return directory;
+}
+
+inline ScreenshotManager::Settings GetScreenshotSettings(const std::unique_ptr<CSimpleIniA> &ini) {
+    // Memory the screenshot buffers may keep for reuse while the panel is closed
+    const long budgetMB = ini->GetLongValue("Screenshot", "MemoryBudgetMB", 32);
+    const std::string saveDirectory = ini->GetValue("Screenshot", "SaveDirectory", "");
+    const std::string_view format = ini->GetValue("Screenshot", "Format", "png");
+    const std::string_view mode = ini->GetValue("Screenshot", "Mode", "webview");
+    const long historyEntries = ini->GetLongValue("Screenshot", "HistoryEntries", 10);
+    const long historyBudgetMB = ini->GetLongValue("Screenshot", "HistoryBudgetMB", 64);
+    const long diffTileSize = ini->GetLongValue("Screenshot", "DiffTileSize", 16);
+    const long diffTolerance = ini->GetLongValue("Screenshot", "DiffTolerance", 8);
+    const long duplicateThreshold = ini->GetLongValue("Screenshot", "DuplicateThreshold", 2);
+    const long blurRadius = ini->GetLongValue("Screenshot", "RedactBlurRadius", 12);
+    const long pixelateBlockSize = ini->GetLongValue("Screenshot", "RedactBlockSize", 16);
+    const long recordFrameRate = ini->GetLongValue("Screenshot", "RecordFrameRate", 5);
+    const long recordQueueMB = ini->GetLongValue("Screenshot", "RecordQueueMB", 32);
+    const long fullPageMaxViewports = ini->GetLongValue("Screenshot", "FullPageMaxViewports", 50);
+    const char *elementSelector = ini->GetValue("Screenshot", "ElementSelector", "");
+
+    return {
+        .memoryBudget = static_cast<size_t>(std::max(0L, budgetMB)) * 1024 * 1024,
+        .saveDirectory = saveDirectory.empty() ? GetDefaultScreenshotDirectory() : std::filesystem::path(saveDirectory),
+        .fileFormat = format == "qoi" ? ScreenshotManager::FileFormat::Qoi : ScreenshotManager::FileFormat::Png,
+        .captureMode = mode == "window"    ? CaptureMode::Window
+                       : mode == "region"  ? CaptureMode::Region
+                       : mode == "screen"  ? CaptureMode::Screen
+                       : mode == "element" ? CaptureMode::Element
+                                           : CaptureMode::WebView,
+        .historyEntries = static_cast<size_t>(std::max(0L, historyEntries)),
+        .historyBudget = static_cast<size_t>(std::max(0L, historyBudgetMB)) * 1024 * 1024,
+        .diffOptions = {
+            .tileSize = static_cast<int>(std::clamp(diffTileSize, 1L, 1024L)),
+            .tolerance = static_cast<uint8_t>(std::clamp(diffTolerance, 0L, 255L)),
+        },
+        .duplicateThreshold = static_cast<int>(std::clamp(duplicateThreshold, -1L, 64L)),
+        .blurRadius = static_cast<int>(std::clamp(blurRadius, 1L, 256L)),
+        .pixelateBlockSize = static_cast<int>(std::clamp(pixelateBlockSize, 2L, 256L)),
+        .recording = {
+            .frameRate = static_cast<int>(std::clamp(recordFrameRate, 1L, 60L)),
+            .queueBudget = static_cast<size_t>(std::max(0L, recordQueueMB)) * 1024 * 1024,
+            .diffOptions = {
+                .tileSize = static_cast<int>(std::clamp(diffTileSize, 1L, 1024L)),
+                .tolerance = 0, // Lossless, every change is kept
+            },
+        },
+        .fullPage = {
+            .maxFrames = static_cast<int>(std::clamp(fullPageMaxViewports, 1L, 1000L)),
+        },
+        .elementSelector = elementSelector,
+    };
+}
+
+inline const char *GetCaptureModeName(CaptureMode mode) {
+    switch (mode) {
+    case CaptureMode::Window: return "window";
+    case CaptureMode::Region: return "region";
+    case CaptureMode::Screen: return "screen";
+    case CaptureMode::Element: return "element";
+    default: return "webview";
+    }
+}
+
 inline SettingsCallbacks GetSettingsCallbacks(const std::unique_ptr<CSimpleIniA> &ini, const HWND &hwnd) {
     // clang-format off
     return {
@@ -151,63 +355,4 @@ inline void RegisterKeybinds(const SettingsArgs &settingsArgs, Window &window, c
         static bool enable = false;
         WndCtrl::EnableClickThrough(hwnd, enable = !enable);
     });
-}
-
-class ScreenshotManager {
-  public:
-    ScreenshotManager(ID3D11Device *device) : device(device) {}
-    ~ScreenshotManager() { Release(); }
-
-    void Capture() {
-        Release();
-
-        if (!Utils::CaptureScreenshot(buffer, width, height)) {
-            Log::Error("Failed to capture screenshot");
-            return;
-        }
-        textureView = Utils::CreateDx11TextureBGRA(
-            buffer.data(), width,
-            height, device
-        );
-    }
-
-    void Capture(bool value) {
-        if (value)
-            Capture();
-        else
-            Release();
-    }
-
-    void CopyToClipboard() {
-        if (textureView == nullptr) {
-            Log::Error("No screenshot captured");
-            return;
-        }
-
-        if (!Utils::CopyImageToClipboard(buffer, width, height)) {
-            Log::Error("Failed to copy screenshot to clipboard");
-        }
-    }
-
-    void Release() {
-        if (textureView != nullptr) {
-            textureView->Release();
-            textureView = nullptr;
-        }
-    }
-
-    ScreenshotImage GetImage() const {
-        return {
-            .width = width,
-            .height = height,
-            .textureView = textureView
-        };
-    }
-
-  private:
-    std::vector<BYTE> buffer;
-    int width;
-    int height;
-    ID3D11Device *device = nullptr;
-    ID3D11ShaderResourceView *textureView = nullptr;
-};
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "duplicate_index.hpp"
+#include "perceptual_hash.hpp"
+
+#include <algorithm>
+
+DuplicateIndex::DuplicateIndex(size_t capacity, int threshold) : capacity(capacity), threshold(threshold) {}
+
+bool DuplicateIndex::CheckAndInsert(uint64_t hash) {
+    if (threshold < 0 || capacity == 0) return false;
+
+    std::lock_guard lock(mutex);
+    const bool duplicate = std::any_of(hashes.begin(), hashes.end(), [this, hash](uint64_t known) {
+        return PerceptualHash::Distance(known, hash) <= threshold;
+    });
+    if (duplicate) return true;
+
+    hashes.push_back(hash);
+    if (hashes.size() > capacity) hashes.pop_front();
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <cstdint>
+
+// The perceptual hashes of the last few captures, to recognise a capture that
+// looks like one of them. Thread-safe, file saves check it on workers.
+class DuplicateIndex {
+  public:
+    /**
+     * @param capacity   Hashes remembered, the oldest is forgotten first.
+     * @param threshold  Largest Hamming distance counted as a duplicate, negative disables matching.
+     */
+    DuplicateIndex(size_t capacity, int threshold);
+
+    // Returns true when hash is a near-duplicate, otherwise remembers it.
+    // One locked step, so two parallel saves of the same image cannot both pass.
+    bool CheckAndInsert(uint64_t hash);
+
+  private:
+    size_t capacity;
+    int threshold;
+    std::deque<uint64_t> hashes;
+    std::mutex mutex;
+};
\ No newline at end of file
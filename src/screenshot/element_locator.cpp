@@ -0,0 +1,239 @@
+#include "element_locator.hpp"
+#include "Log.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+
+namespace {
+
+// The rect is read after scrolling; comparing it with the one before tells whether
+// anything moved, including scroll containers inside the page
+constexpr const char *boundsScriptBegin = R"((() => {
+    let element;
+    try {
+        element = document.querySelector()";
+constexpr const char *boundsScriptEnd = R"();
+    } catch {
+        return null;
+    }
+    if (!element) return null;
+    const before = element.getBoundingClientRect();
+    element.scrollIntoView({block: 'nearest', inline: 'nearest', behavior: 'instant'});
+    const rect = element.getBoundingClientRect();
+    const scrolled = rect.left !== before.left || rect.top !== before.top;
+    return [rect.left, rect.top, rect.right, rect.bottom, devicePixelRatio, scrolled ? 1 : 0];
+})())";
+
+// Outlines the element under the mouse and swallows the click that picks it. The
+// selector is built from the nearest id and the position among same-tag siblings,
+// so it finds the same element again on a later capture of the same page.
+constexpr const char *pickScript = R"((() => {
+    if (window.__webframePicker) return;
+    const box = document.createElement('div');
+    box.style.cssText = 'position: fixed; z-index: 2147483647; pointer-events: none; display: none;' +
+        'background: rgba(66, 133, 244, 0.25); outline: 2px solid rgb(66, 133, 244);';
+    document.documentElement.appendChild(box);
+
+    const selectorOf = (element) => {
+        const parts = [];
+        for (; element && element !== document.documentElement; element = element.parentElement) {
+            if (element.id) {
+                parts.unshift('#' + CSS.escape(element.id));
+                break;
+            }
+            let index = 1;
+            for (let sibling = element.previousElementSibling; sibling; sibling = sibling.previousElementSibling) {
+                if (sibling.localName === element.localName) ++index;
+            }
+            parts.unshift(`${element.localName}:nth-of-type(${index})`);
+        }
+        return parts.join(' > ') || 'html';
+    };
+    const over = (event) => {
+        const rect = event.target.getBoundingClientRect();
+        Object.assign(box.style, {display: 'block', left: rect.left + 'px', top: rect.top + 'px',
+                                  width: rect.width + 'px', height: rect.height + 'px'});
+    };
+    const click = (event) => {
+        event.preventDefault();
+        event.stopPropagation();
+        finish(selectorOf(event.target));
+    };
+    const key = (event) => {
+        if (event.key === 'Escape') finish('');
+    };
+    const picker = window.__webframePicker = {result: null, cancel: () => finish('')};
+    const finish = (result) => {
+        picker.result = result;
+        box.remove();
+        removeEventListener('mouseover', over, true);
+        removeEventListener('click', click, true);
+        removeEventListener('keydown', key, true);
+    };
+    addEventListener('mouseover', over, true);
+    addEventListener('click', click, true);
+    addEventListener('keydown', key, true);
+})())";
+
+// null while picking; a page that navigated away has lost the picker, which cancels it
+constexpr const char *pollScript = R"((() => {
+    const picker = window.__webframePicker;
+    if (!picker) return '';
+    if (picker.result === null) return null;
+    delete window.__webframePicker;
+    return picker.result;
+})())";
+
+constexpr const char *cancelScript = R"((() => {
+    window.__webframePicker?.cancel();
+    delete window.__webframePicker;
+})())";
+
+constexpr std::chrono::milliseconds pollInterval{100};
+
+void AppendUtf8(std::string &out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+} // namespace
+
+// A JSON string is also a valid JavaScript string literal, so the selector cannot break out of the script
+std::string ElementLocator::ToJsonString(const std::string &text) {
+    std::string json = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            json += escaped;
+        } else {
+            json += c;
+        }
+    }
+    return json + '"';
+}
+
+std::optional<std::string> ElementLocator::FromJsonString(const std::string &json) {
+    if (json.size() < 2 || json.front() != '"' || json.back() != '"') return std::nullopt;
+
+    std::string text;
+    for (size_t i = 1; i + 1 < json.size(); ++i) {
+        if (json[i] != '\\') {
+            text += json[i];
+            continue;
+        }
+        if (++i + 1 >= json.size()) return std::nullopt;
+        switch (json[i]) {
+        case 'b': text += '\b'; break;
+        case 'f': text += '\f'; break;
+        case 'n': text += '\n'; break;
+        case 'r': text += '\r'; break;
+        case 't': text += '\t'; break;
+        case 'u': {
+            unsigned int unit = 0;
+            if (i + 5 >= json.size() || sscanf(json.c_str() + i + 1, "%4x", &unit) != 1) return std::nullopt;
+            i += 4;
+            uint32_t codePoint = unit;
+            // A surrogate pair encodes one code point outside the basic plane
+            unsigned int low = 0;
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 7 < json.size() && json[i + 1] == '\\' && json[i + 2] == 'u' &&
+                sscanf(json.c_str() + i + 3, "%4x", &low) == 1 && low >= 0xDC00 && low < 0xE000) {
+                codePoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            }
+            AppendUtf8(text, codePoint);
+            break;
+        }
+        default: text += json[i]; break; // \" \\ and \/
+        }
+    }
+    return text;
+}
+
+std::string ElementLocator::MakeBoundsScript(const std::string &selector) {
+    return boundsScriptBegin + ToJsonString(selector) + boundsScriptEnd;
+}
+
+std::optional<ElementLocator::Bounds> ElementLocator::ParseBounds(const std::string &json, const RECT &webviewRect) {
+    double left, top, right, bottom, pixelRatio;
+    int scrolled;
+    if (sscanf(json.c_str(), "[%lf,%lf,%lf,%lf,%lf,%d]", &left, &top, &right, &bottom, &pixelRatio, &scrolled) != 6) {
+        return std::nullopt;
+    }
+    if (pixelRatio <= 0.0) return std::nullopt;
+
+    // CSS pixels of the viewport to device pixels, covering every pixel the element touches.
+    // The slack keeps a rounding error in the ratio from adding a row.
+    constexpr double slack = 1e-3;
+    const RECT element = {
+        webviewRect.left + static_cast<LONG>(std::floor(left * pixelRatio + slack)),
+        webviewRect.top + static_cast<LONG>(std::floor(top * pixelRatio + slack)),
+        webviewRect.left + static_cast<LONG>(std::ceil(right * pixelRatio - slack)),
+        webviewRect.top + static_cast<LONG>(std::ceil(bottom * pixelRatio - slack)),
+    };
+    Bounds bounds;
+    // Hidden and zero-sized elements, or ones scrolled out of a container, leave nothing to capture
+    if (!IntersectRect(&bounds.rect, &element, &webviewRect)) return std::nullopt;
+    bounds.scrolled = scrolled != 0;
+    bounds.clipped = !EqualRect(&bounds.rect, &element);
+    return bounds;
+}
+
+bool ElementLocator::StartPicking(ScriptRunner runScript) {
+    if (picking || !runScript) return false;
+    this->runScript = std::move(runScript);
+    this->runScript(pickScript);
+    picking = true;
+    lastPoll = std::chrono::steady_clock::now();
+    return true;
+}
+
+void ElementLocator::CancelPicking() {
+    if (!picking) return;
+    runScript(cancelScript);
+    pendingPoll = {};
+    picking = false;
+}
+
+std::optional<std::string> ElementLocator::Update() {
+    if (!picking) return std::nullopt;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!pendingPoll.valid()) {
+        if (now - lastPoll < pollInterval) return std::nullopt;
+        pendingPoll = runScript(pollScript);
+        lastPoll = now;
+        return std::nullopt;
+    }
+    if (pendingPoll.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return std::nullopt;
+
+    const std::string json = pendingPoll.get();
+    if (json == "null") return std::nullopt;
+
+    picking = false;
+    std::optional<std::string> selector = FromJsonString(json);
+    if (!selector) {
+        Log::Error("Element picker stopped, the page did not answer");
+        return std::nullopt;
+    }
+    // Escape or a navigation cancels
+    if (selector->empty()) return std::nullopt;
+    return selector;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <functional>
+#include <windows.h>
+
+// Finds page elements for Element mode captures. A CSS selector is resolved
+// in the page to its bounding box, which is mapped to screen pixels so only
+// that area is cropped from the page's render. The picker lets the user click an
+// element instead, highlighting the one under the mouse; it is polled from
+// Update() on the UI thread, where script results arrive.
+class ElementLocator {
+  public:
+    // Runs a script in the page, the future holds its JSON result (empty on failure)
+    using ScriptRunner = std::function<std::future<std::string>(const std::string &)>;
+
+    struct Bounds {
+        RECT rect = {};        // Screen pixels, clipped to the WebView
+        bool scrolled = false; // Scrolled into view, the page needs a moment to repaint
+        bool clipped = false;  // Larger than the WebView, only the visible part is in rect
+    };
+
+    // Script scrolling the first element matching the selector into view and returning its bounds
+    static std::string MakeBoundsScript(const std::string &selector);
+    // Maps the bounds script's result into the WebView's screen rectangle, nullopt if the element is not shown
+    static std::optional<Bounds> ParseBounds(const std::string &json, const RECT &webviewRect);
+
+    bool StartPicking(ScriptRunner runScript);
+    void CancelPicking();
+    // The selector of the clicked element, once. Nothing while picking or after a cancel.
+    std::optional<std::string> Update();
+    bool IsPicking() const { return picking; }
+
+  private:
+    static std::string ToJsonString(const std::string &text);
+    static std::optional<std::string> FromJsonString(const std::string &json);
+
+  private:
+    ScriptRunner runScript;
+    bool picking = false;
+    std::future<std::string> pendingPoll;
+    std::chrono::steady_clock::time_point lastPoll;
+};
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "full_page_capture.hpp"
+#include "utils.hpp"
+#include "Log.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+namespace {
+
+// Each script returns the metrics the next step needs, the scrollbar is hidden
+// so it does not move between viewports and break the row matching
+constexpr const char *prepareScript = R"((() => {
+    const root = document.documentElement;
+    window.__webframeRestore = {x: scrollX, y: scrollY, scrollbar: root.style.scrollbarWidth};
+    root.style.scrollbarWidth = 'none';
+    scrollTo({left: 0, top: 0, behavior: 'instant'});
+    return [scrollY, innerHeight, root.scrollHeight];
+})())";
+
+constexpr const char *scrollScript = R"((() => {
+    scrollTo({top: %.1f, behavior: 'instant'});
+    return [scrollY, innerHeight, document.documentElement.scrollHeight];
+})())";
+
+constexpr const char *restoreScript = R"((() => {
+    const restore = window.__webframeRestore;
+    if (!restore) return;
+    document.documentElement.style.scrollbarWidth = restore.scrollbar;
+    scrollTo({left: restore.x, top: restore.y, behavior: 'instant'});
+    delete window.__webframeRestore;
+})())";
+
+// A step waiting longer than this is abandoned, the WebView dropped the request
+constexpr std::chrono::seconds stepTimeout{10};
+
+template <typename T>
+bool IsReady(const std::future<T> &future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // namespace
+
+bool FullPageCapture::Start(const std::filesystem::path &path, const Settings &settings, ScriptRunner runScript, PageCapture capturePage) {
+    if (IsActive() || !runScript || !capturePage) return false;
+
+    this->path = path;
+    this->settings = settings;
+    this->runScript = std::move(runScript);
+    this->capturePage = std::move(capturePage);
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    stitcher.Begin(path, settings.compressionLevel);
+    stats = {};
+    scrolledBy = 0.0;
+    startTime = stepTime = std::chrono::steady_clock::now();
+
+    pendingScript = this->runScript(prepareScript);
+    step = Step::Scrolling;
+    return true;
+}
+
+std::optional<FullPageCapture::Metrics> FullPageCapture::ParseMetrics(const std::string &json) {
+    Metrics metrics;
+    if (sscanf(json.c_str(), "[%lf,%lf,%lf]", &metrics.scrollY, &metrics.viewportHeight, &metrics.pageHeight) != 3) {
+        return std::nullopt;
+    }
+    if (metrics.viewportHeight <= 0.0) return std::nullopt;
+    return metrics;
+}
+
+void FullPageCapture::ScrollTo(double y) {
+    char script[256];
+    snprintf(script, sizeof(script), scrollScript, y);
+    pendingScript = runScript(script);
+    step = Step::Scrolling;
+    stepTime = std::chrono::steady_clock::now();
+}
+
+void FullPageCapture::Update() {
+    const auto now = std::chrono::steady_clock::now();
+    if (step != Step::Idle && step != Step::Stitching && now - stepTime > stepTimeout) {
+        Log::Error("Full-page capture timed out");
+        Finish(false);
+        return;
+    }
+
+    switch (step) {
+    case Step::Idle:
+        return;
+
+    case Step::Scrolling: {
+        if (!IsReady(pendingScript)) return;
+        const std::optional<Metrics> next = ParseMetrics(pendingScript.get());
+        if (!next) {
+            Log::Error("Full-page capture could not read the page's scroll position");
+            Finish(false);
+            return;
+        }
+        // The page could not scroll further, the last viewport is already stitched
+        if (stats.frames > 0 && next->scrollY <= metrics.scrollY + 0.5) {
+            Finish(true);
+            return;
+        }
+        scrolledBy = stats.frames > 0 ? next->scrollY - metrics.scrollY : 0.0;
+        metrics = *next;
+        step = Step::Settling;
+        stepTime = now;
+        return;
+    }
+
+    case Step::Settling: {
+        if (now - stepTime < settings.settleTime) return;
+        std::optional<std::future<std::vector<unsigned char>>> png = capturePage();
+        if (!png) {
+            Log::Error("Full-page capture could not capture the WebView");
+            Finish(false);
+            return;
+        }
+        pendingPng = std::move(*png);
+        step = Step::Capturing;
+        stepTime = now;
+        return;
+    }
+
+    case Step::Capturing: {
+        if (!IsReady(pendingPng)) return;
+        // The stitcher is only touched by this worker until it is collected below
+        pendingStitch = std::async(std::launch::async, [this, png = pendingPng.get(), scrolledBy = scrolledBy,
+                                                        viewportHeight = metrics.viewportHeight]() {
+            std::vector<BYTE> pixels;
+            int width = 0, height = 0;
+            if (!Utils::DecodePng(png.data(), png.size(), pixels, width, height)) return false;
+            // The capture is in device pixels, the scroll position in CSS pixels
+            const int expectedShift = static_cast<int>(std::lround(scrolledBy * height / viewportHeight));
+            return stitcher.AddFrame(std::move(pixels), width, height, expectedShift) >= 0;
+        });
+        step = Step::Stitching;
+        return;
+    }
+
+    case Step::Stitching: {
+        if (!IsReady(pendingStitch)) return;
+        if (!pendingStitch.get()) {
+            Log::Error("Full-page capture failed to stitch a viewport");
+            Finish(false);
+            return;
+        }
+        stats.frames = stitcher.GetFrames();
+        stats.height = stitcher.GetHeight();
+        stats.inexactFrames = stitcher.GetInexactFrames();
+
+        const bool atBottom = metrics.scrollY + metrics.viewportHeight >= metrics.pageHeight - 1.0;
+        if (atBottom || stats.frames >= settings.maxFrames) {
+            Finish(true);
+            return;
+        }
+        // A quarter of the scrolling rows overlaps for the match. Header and footer
+        // are only known from the second frame, the first step is half a viewport.
+        const double cssPerRow = metrics.viewportHeight / stitcher.GetFrameHeight();
+        const double stepRows = stats.frames == 1 ? stitcher.GetFrameHeight() * 0.5 : stitcher.GetScrollingRows() * 0.75;
+        ScrollTo(metrics.scrollY + std::max(1.0, stepRows * cssPerRow));
+        return;
+    }
+    }
+}
+
+void FullPageCapture::Finish(bool success) {
+    if (runScript) runScript(restoreScript);
+    // A worker may still hold the stitcher
+    if (pendingStitch.valid()) pendingStitch.wait();
+    pendingScript = {};
+    pendingPng = {};
+    pendingStitch = {};
+
+    const bool written = stitcher.Finish();
+    stats.frames = stitcher.GetFrames();
+    stats.height = stitcher.GetHeight();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    step = Step::Idle;
+
+    if (!written) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        Log::Error("Failed to save full-page screenshot");
+        return;
+    }
+    // A partial page is kept, it is still useful
+    if (!success) Log::Error("Full-page capture stopped early, saved %d viewports to %s", stats.frames, path.string().c_str());
+    else Log::Debug("Saved full-page screenshot to %s", path.string().c_str());
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include "page_stitcher.hpp"
+
+// Captures a whole page by scrolling the WebView from top to bottom and
+// stitching the viewports into one PNG in the save directory. Driven by
+// Update() on the UI thread, where scripts and page captures complete; each
+// viewport is decoded and stitched on a worker while the next step waits.
+// The page's scroll position and scrollbar are restored afterwards.
+class FullPageCapture {
+  public:
+    // Runs a script in the page, the future holds its JSON result (empty on failure)
+    using ScriptRunner = std::function<std::future<std::string>(const std::string &)>;
+    // Starts a PNG capture of the viewport, nullopt if it could not be started
+    using PageCapture = std::function<std::optional<std::future<std::vector<unsigned char>>>()>;
+
+    struct Settings {
+        int maxFrames = 50; // Stops endless pages
+        std::chrono::milliseconds settleTime{150}; // After scrolling, for the page to repaint
+        int compressionLevel = 6;
+    };
+
+    struct Stats {
+        int frames = 0;
+        int height = 0;
+        int inexactFrames = 0; // Placed by scroll position, no exact overlap was found
+        double seconds = 0.0;
+    };
+
+    bool Start(const std::filesystem::path &path, const Settings &settings, ScriptRunner runScript, PageCapture capturePage);
+    void Update();
+    bool IsActive() const { return step != Step::Idle; }
+    const Stats &GetStats() const { return stats; }
+
+  private:
+    enum class Step {
+        Idle,
+        Scrolling, // Waiting for the scroll script's metrics
+        Settling,
+        Capturing, // Waiting for the viewport PNG
+        Stitching
+    };
+
+    struct Metrics {
+        double scrollY = 0.0;
+        double viewportHeight = 0.0;
+        double pageHeight = 0.0;
+    };
+
+    static std::optional<Metrics> ParseMetrics(const std::string &json);
+    void ScrollTo(double y);
+    void Finish(bool success);
+
+  private:
+    Step step = Step::Idle;
+    Settings settings;
+    ScriptRunner runScript;
+    PageCapture capturePage;
+    std::filesystem::path path;
+    PageStitcher stitcher;
+    Metrics metrics;
+    double scrolledBy = 0.0; // CSS pixels since the previous frame
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point stepTime; // When the current step began
+    Stats stats;
+
+    std::future<std::string> pendingScript;
+    std::future<std::vector<unsigned char>> pendingPng;
+    std::future<bool> pendingStitch;
+};
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "page_stitcher.hpp"
+#include "image_diff.hpp"
+
+#include <algorithm>
+
+void PageStitcher::Begin(const std::filesystem::path &path, int level) {
+    this->path = path;
+    this->level = level;
+    previous.clear();
+    width = height = frames = 0;
+    fixedTop = fixedBottom = 0;
+    writtenHeight = inexactFrames = 0;
+}
+
+bool PageStitcher::Write(const std::vector<uint8_t> &pixels, int first, int last) {
+    if (last <= first) return true;
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    if (!writer.AddRows(pixels.data() + first * pitch, pitch, last - first)) return false;
+    writtenHeight += last - first;
+    return true;
+}
+
+int PageStitcher::AddFrame(std::vector<uint8_t> &&pixels, int frameWidth, int frameHeight, int expectedShift) {
+    if (frameWidth <= 0 || frameHeight <= 0 || pixels.size() < static_cast<size_t>(frameWidth) * frameHeight * 4) return -1;
+
+    if (frames == 0) {
+        if (!writer.Open(path, frameWidth, level)) return -1;
+        width = frameWidth;
+        height = frameHeight;
+        previous = std::move(pixels);
+        frames = 1;
+        return 0;
+    }
+    // The viewport was resized while scrolling
+    if (frameWidth != width || frameHeight != height) return -1;
+
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    if (frames == 1) {
+        // Rows the same in both frames did not scroll, at most a third of the viewport each
+        const auto sameRow = [&](int y) { return !ImageDiff::RowDiffers(previous.data() + y * pitch, pixels.data() + y * pitch, pitch, 0); };
+        while (fixedTop < height / 3 && sameRow(fixedTop)) ++fixedTop;
+        while (fixedBottom < height / 3 && sameRow(height - 1 - fixedBottom)) ++fixedBottom;
+        // The first frame goes out whole but for its footer, which the last frame supplies
+        if (!Write(previous, 0, height - fixedBottom)) return -1;
+    }
+
+    const int bottom = height - fixedBottom;
+    int shift = ImageDiff::FindVerticalShift(
+        previous.data(), pixels.data(), width, pitch, fixedTop, bottom, expectedShift, bottom - fixedTop
+    );
+    if (shift < 0) {
+        // Animated or lazily loaded content, trust the scroll position
+        ++inexactFrames;
+        shift = std::clamp(expectedShift, 0, bottom - fixedTop);
+    }
+
+    // New content scrolled in above the footer, never reaching into the header
+    if (!Write(pixels, std::max(fixedTop, bottom - shift), bottom)) return -1;
+    previous = std::move(pixels);
+    ++frames;
+    return shift;
+}
+
+bool PageStitcher::Finish() {
+    if (frames == 0) return false;
+    const bool written = Write(previous, frames == 1 ? 0 : height - fixedBottom, height);
+    previous.clear();
+    previous.shrink_to_fit();
+    return writer.Finish() && written;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include "image_encode.hpp"
+
+// Stitches viewport captures of a page scrolled top to bottom into one tall
+// PNG. Each frame is matched against the previous one to find how far the page
+// really scrolled, and only the rows it adds are appended to the file, so just
+// the previous frame is kept in memory. Rows that stay put between the first
+// two frames are taken for a fixed header and footer and written once.
+class PageStitcher {
+  public:
+    void Begin(const std::filesystem::path &path, int level = 6);
+    /**
+     * @brief Appends the part of a viewport not seen in the previous one.
+     *
+     * @param expectedShift  Rows the page scrolled since the previous frame by its scroll
+     *                       position, used as the search hint and when no shift matches exactly.
+     * @return Rows the frame is scrolled from the previous one, -1 on error.
+     */
+    int AddFrame(std::vector<uint8_t> &&pixels, int width, int height, int expectedShift);
+    // Writes the footer of the last frame and closes the file, false if nothing was written
+    bool Finish();
+
+    int GetFrames() const { return frames; }
+    int GetHeight() const { return writtenHeight; }
+    int GetFrameHeight() const { return height; }
+    // Rows scrollable content takes in a viewport, between header and footer
+    int GetScrollingRows() const { return height - fixedTop - fixedBottom; }
+    int GetInexactFrames() const { return inexactFrames; }
+
+  private:
+    bool Write(const std::vector<uint8_t> &pixels, int first, int last);
+
+  private:
+    ImageEncode::PngStreamWriter writer; // Opened by the first frame, which sets the width
+    std::filesystem::path path;
+    int level = 6;
+    std::vector<uint8_t> previous; // Top-down BGRA
+    int width = 0;
+    int height = 0;
+    int frames = 0;
+    int fixedTop = 0;
+    int fixedBottom = 0;
+    int writtenHeight = 0;
+    int inexactFrames = 0; // Placed by scroll position, no exact overlap was found
+};
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "region_selector.hpp"
+#include "Log.hpp"
+
+#include <windowsx.h>
+#include <algorithm>
+
+static constexpr wchar_t className[] = L"WebFrameRegionSelector";
+
+HBITMAP RegionSelector::CreateBitmap(const BYTE *pixels, int width, int height, bool dim) {
+    BITMAPINFO bi = {};
+    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bi.bmiHeader.biWidth = width;
+    bi.bmiHeader.biHeight = -height; // top-down
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    void *bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(nullptr, &bi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!bitmap) return nullptr;
+
+    const size_t size = static_cast<size_t>(width) * height * 4;
+    BYTE *dst = static_cast<BYTE *>(bits);
+    if (dim)
+        std::transform(pixels, pixels + size, dst, [](BYTE value) { return static_cast<BYTE>(value >> 1); });
+    else
+        std::copy(pixels, pixels + size, dst);
+    return bitmap;
+}
+
+bool RegionSelector::Begin(const std::vector<BYTE> &pixels, int imageWidth, int imageHeight, POINT origin, Callback onSelected) {
+    Cancel();
+    if (imageWidth <= 0 || imageHeight <= 0 || pixels.size() < static_cast<size_t>(imageWidth) * imageHeight * 4) return false;
+
+    static const bool registered = []() {
+        WNDCLASSEXW wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = WndProc;
+        wc.hInstance = GetModuleHandle(nullptr);
+        wc.hCursor = LoadCursor(nullptr, IDC_CROSS);
+        wc.lpszClassName = className;
+        return RegisterClassExW(&wc) != 0;
+    }();
+    if (!registered) return false;
+
+    width = imageWidth;
+    height = imageHeight;
+    dragging = false;
+
+    image = CreateBitmap(pixels.data(), width, height, false);
+    dimmed = CreateBitmap(pixels.data(), width, height, true);
+    if (!image || !dimmed) {
+        Log::Error("Failed to create region selection bitmaps");
+        Finish(std::nullopt);
+        return false;
+    }
+
+    hwnd = CreateWindowExW(
+        WS_EX_TOPMOST | WS_EX_TOOLWINDOW, className, L"", WS_POPUP,
+        origin.x, origin.y, width, height, nullptr, nullptr, GetModuleHandle(nullptr), this
+    );
+    if (!hwnd) {
+        Log::Error("Failed to create region selection overlay");
+        Finish(std::nullopt);
+        return false;
+    }
+
+    callback = std::move(onSelected);
+    ShowWindow(hwnd, SW_SHOW);
+    SetForegroundWindow(hwnd);
+    return true;
+}
+
+void RegionSelector::Cancel() {
+    if (hwnd) Finish(std::nullopt);
+}
+
+void RegionSelector::Finish(std::optional<RECT> selection) {
+    // Reset first, the callback may start another selection
+    HWND window = hwnd;
+    Callback onSelected = std::move(callback);
+    hwnd = nullptr;
+    callback = nullptr;
+    if (image) DeleteObject(image);
+    if (dimmed) DeleteObject(dimmed);
+    image = dimmed = nullptr;
+    if (window) {
+        if (GetCapture() == window) ReleaseCapture();
+        DestroyWindow(window);
+    }
+
+    if (onSelected) onSelected(selection);
+}
+
+RECT RegionSelector::GetSelection() const {
+    RECT rect = {
+        std::min(dragStart.x, dragEnd.x), std::min(dragStart.y, dragEnd.y),
+        std::max(dragStart.x, dragEnd.x), std::max(dragStart.y, dragEnd.y)
+    };
+    const RECT bounds = {0, 0, width, height};
+    IntersectRect(&rect, &rect, &bounds);
+    return rect;
+}
+
+void RegionSelector::Paint(HDC hdc) {
+    // Compose off-screen so dragging does not flicker
+    HDC backDC = CreateCompatibleDC(hdc);
+    HBITMAP backBuffer = CreateCompatibleBitmap(hdc, width, height);
+    HGDIOBJ previousBack = SelectObject(backDC, backBuffer);
+    HDC sourceDC = CreateCompatibleDC(hdc);
+    HGDIOBJ previousSource = SelectObject(sourceDC, dimmed);
+
+    BitBlt(backDC, 0, 0, width, height, sourceDC, 0, 0, SRCCOPY);
+
+    if (dragging) {
+        const RECT rect = GetSelection();
+        if (!IsRectEmpty(&rect)) {
+            SelectObject(sourceDC, image);
+            BitBlt(backDC, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, sourceDC, rect.left, rect.top, SRCCOPY);
+            FrameRect(backDC, &rect, static_cast<HBRUSH>(GetStockObject(WHITE_BRUSH)));
+        }
+    }
+
+    BitBlt(hdc, 0, 0, width, height, backDC, 0, 0, SRCCOPY);
+
+    SelectObject(sourceDC, previousSource);
+    DeleteDC(sourceDC);
+    SelectObject(backDC, previousBack);
+    DeleteObject(backBuffer);
+    DeleteDC(backDC);
+}
+
+LRESULT CALLBACK RegionSelector::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (msg == WM_NCCREATE) {
+        const CREATESTRUCTW *create = reinterpret_cast<CREATESTRUCTW *>(lParam);
+        SetWindowLongPtrW(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(create->lpCreateParams));
+    }
+    RegionSelector *selector = reinterpret_cast<RegionSelector *>(GetWindowLongPtrW(hWnd, GWLP_USERDATA));
+    if (!selector || selector->hwnd != hWnd) return DefWindowProcW(hWnd, msg, wParam, lParam);
+
+    switch (msg) {
+    case WM_LBUTTONDOWN:
+        selector->dragging = true;
+        selector->dragStart = selector->dragEnd = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+        SetCapture(hWnd);
+        return 0;
+    case WM_MOUSEMOVE:
+        if (selector->dragging) {
+            selector->dragEnd = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+            InvalidateRect(hWnd, nullptr, FALSE);
+        }
+        return 0;
+    case WM_LBUTTONUP: {
+        if (!selector->dragging) return 0;
+        selector->dragEnd = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+        const RECT rect = selector->GetSelection();
+        // A click without a drag selects nothing
+        if (IsRectEmpty(&rect))
+            selector->Finish(std::nullopt);
+        else
+            selector->Finish(rect);
+        return 0;
+    }
+    case WM_RBUTTONUP:
+        selector->Finish(std::nullopt);
+        return 0;
+    case WM_KEYDOWN:
+        if (wParam == VK_ESCAPE) selector->Finish(std::nullopt);
+        return 0;
+    case WM_KILLFOCUS:
+        // Switching away (e.g. Alt+Tab) abandons the selection rather than leaving a topmost overlay behind
+        if (!selector->dragging) selector->Finish(std::nullopt);
+        return 0;
+    case WM_ERASEBKGND:
+        return 1;
+    case WM_PAINT: {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(hWnd, &ps);
+        selector->Paint(hdc);
+        EndPaint(hWnd, &ps);
+        return 0;
+    }
+    }
+    return DefWindowProcW(hWnd, msg, wParam, lParam);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <optional>
+#include <functional>
+#include <windows.h>
+
+// Full-screen overlay showing a frozen capture, on which the user drags the
+// rectangle to keep. Runs on the UI thread's message loop, never blocks.
+class RegionSelector {
+  public:
+    // Selected rectangle in image coordinates, empty when cancelled
+    using Callback = std::function<void(std::optional<RECT>)>;
+
+    RegionSelector() = default;
+    ~RegionSelector() { Cancel(); }
+    RegionSelector(const RegionSelector &) = delete;
+    RegionSelector &operator=(const RegionSelector &) = delete;
+
+    /**
+     * @brief Shows the overlay over the area the image was captured from.
+     *
+     * @param pixels  Top-down BGRA capture, copied into GDI bitmaps.
+     * @param origin  Screen position of the image's top-left pixel.
+     */
+    bool Begin(const std::vector<BYTE> &pixels, int width, int height, POINT origin, Callback callback);
+    // Closes the overlay, reporting a cancelled selection
+    void Cancel();
+    bool IsActive() const { return hwnd != nullptr; }
+
+  private:
+    static HBITMAP CreateBitmap(const BYTE *pixels, int width, int height, bool dim);
+    void Finish(std::optional<RECT> selection);
+    void Paint(HDC hdc);
+    RECT GetSelection() const;
+    static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+  private:
+    HWND hwnd = nullptr;
+    Callback callback;
+    int width = 0;
+    int height = 0;
+    HBITMAP image = nullptr;  // Frozen capture, shown inside the selection
+    HBITMAP dimmed = nullptr; // Half brightness copy, shown outside it
+    bool dragging = false;
+    POINT dragStart = {};
+    POINT dragEnd = {};
+};
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "screen_recorder.hpp"
+#include "image_encode.hpp"
+#include "utils.hpp"
+#include "Log.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+bool ScreenRecorder::Start(const RECT &screenRect, const std::filesystem::path &path, const Settings &settings) {
+    if (IsRecording()) return false;
+    // A recording that ended on its own is collected first
+    Stop();
+
+    {
+        std::lock_guard lock(mutex);
+        queue.clear();
+        queuedBytes = 0;
+        captureDone = false;
+        stopRequested = false;
+        endTime = 0;
+    }
+    captured = unchanged = dropped = encoded = fileBytes = 0;
+    startTime = std::chrono::steady_clock::now();
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    encodeJob = std::async(std::launch::async, &ScreenRecorder::EncodeLoop, this, path, settings.compressionLevel);
+    captureJob = std::async(std::launch::async, &ScreenRecorder::CaptureLoop, this, screenRect, settings);
+    return true;
+}
+
+void ScreenRecorder::Stop() {
+    {
+        std::lock_guard lock(mutex);
+        stopRequested = true;
+    }
+    queueChanged.notify_all();
+
+    if (captureJob.valid()) captureJob.get();
+    if (encodeJob.valid() && !encodeJob.get()) Log::Error("Failed to write the screen recording");
+}
+
+ScreenRecorder::Stats ScreenRecorder::GetStats() const {
+    Stats stats = {
+        .captured = captured,
+        .unchanged = unchanged,
+        .dropped = dropped,
+        .encoded = encoded,
+        .fileBytes = fileBytes,
+    };
+    std::lock_guard lock(mutex);
+    stats.queuedBytes = queuedBytes;
+    const uint32_t elapsed = captureDone ? endTime
+                                         : static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                               std::chrono::steady_clock::now() - startTime).count());
+    stats.seconds = IsRecording() || captureDone ? elapsed / 1000.0 : 0.0;
+    return stats;
+}
+
+// Queues a frame unless that would exceed the budget, an empty queue always takes one
+bool ScreenRecorder::Push(Frame &&frame, size_t budget) {
+    {
+        std::lock_guard lock(mutex);
+        if (!queue.empty() && queuedBytes + frame.pixels.size() > budget) return false;
+        queuedBytes += frame.pixels.size();
+        queue.push_back(std::move(frame));
+    }
+    queueChanged.notify_all();
+    return true;
+}
+
+void ScreenRecorder::CaptureLoop(RECT screenRect, Settings settings) {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::microseconds(1'000'000 / std::clamp(settings.frameRate, 1, 60));
+
+    // The last frame passed to the encoder, changes are found against it
+    std::vector<BYTE> previous, current;
+    int captureWidth = 0, captureHeight = 0;
+    auto next = Clock::now();
+
+    while (true) {
+        int frameWidth = 0, frameHeight = 0;
+        if (!Utils::CaptureScreenRegion(screenRect, current, frameWidth, frameHeight)) {
+            Log::Error("Screen recording stopped, capture failed");
+            break;
+        }
+        // The canvas size of an APNG is fixed by the first frame
+        if (captureWidth == 0) {
+            captureWidth = frameWidth;
+            captureHeight = frameHeight;
+        } else if (frameWidth != captureWidth || frameHeight != captureHeight) {
+            Log::Error("Screen recording stopped, the captured area changed size");
+            break;
+        }
+        ++captured;
+
+        Frame frame;
+        frame.time = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count()
+        );
+        const size_t pitch = static_cast<size_t>(captureWidth) * 4;
+        frame.area = {0, 0, captureWidth, captureHeight};
+        bool changed = true;
+        if (!previous.empty()) {
+            const ImageDiff::Result diff = ImageDiff::Compare(
+                previous.data(), current.data(), captureWidth, captureHeight, pitch, settings.diffOptions
+            );
+            changed = diff.changedTiles > 0;
+            if (changed) {
+                // One bounding box, an APNG frame is a single rectangle
+                frame.area = {captureWidth, captureHeight, 0, 0};
+                for (const ImageDiff::Rect &region : diff.regions) {
+                    frame.area.left = std::min<LONG>(frame.area.left, region.x);
+                    frame.area.top = std::min<LONG>(frame.area.top, region.y);
+                    frame.area.right = std::max<LONG>(frame.area.right, region.x + region.width);
+                    frame.area.bottom = std::max<LONG>(frame.area.bottom, region.y + region.height);
+                }
+            }
+        }
+
+        if (!changed) {
+            ++unchanged;
+        } else {
+            const size_t rowBytes = static_cast<size_t>(frame.area.right - frame.area.left) * 4;
+            frame.pixels.resize(rowBytes * (frame.area.bottom - frame.area.top));
+            for (LONG y = frame.area.top; y < frame.area.bottom; ++y) {
+                std::memcpy(frame.pixels.data() + (y - frame.area.top) * rowBytes,
+                            current.data() + y * pitch + static_cast<size_t>(frame.area.left) * 4, rowBytes);
+            }
+            // A dropped frame leaves previous as it is, its changes go out with the next frame
+            if (Push(std::move(frame), settings.queueBudget))
+                std::swap(previous, current);
+            else
+                ++dropped;
+        }
+
+        // Missed ticks are skipped rather than caught up
+        next += period;
+        const auto now = Clock::now();
+        if (next < now) next = now;
+        std::unique_lock lock(mutex);
+        if (queueChanged.wait_until(lock, next, [this]() { return stopRequested; })) break;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        captureDone = true;
+        endTime = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count()
+        );
+    }
+    queueChanged.notify_all();
+}
+
+bool ScreenRecorder::EncodeLoop(std::filesystem::path path, int level) {
+    ImageEncode::ApngWriter writer;
+    bool success = true;
+
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock lock(mutex);
+            queueChanged.wait(lock, [this]() { return !queue.empty() || captureDone; });
+            if (queue.empty()) break;
+            frame = std::move(queue.front());
+            queue.pop_front();
+            queuedBytes -= frame.pixels.size();
+        }
+        if (!success) continue; // Keep draining so the capture worker is never blocked
+
+        const int frameWidth = frame.area.right - frame.area.left;
+        const int frameHeight = frame.area.bottom - frame.area.top;
+        // The first frame is always the full capture, it opens the file
+        if (encoded == 0) {
+            success = writer.Open(path, frameWidth, frameHeight, level);
+            if (!success) continue;
+        }
+        success = writer.AddFrame(frame.pixels.data(), static_cast<size_t>(frameWidth) * 4,
+                                  frame.area.left, frame.area.top, frameWidth, frameHeight, frame.time);
+        ++encoded;
+        fileBytes = writer.GetBytesWritten();
+    }
+
+    uint32_t end;
+    {
+        std::lock_guard lock(mutex);
+        end = endTime;
+    }
+    if (encoded == 0) return success;
+    success = writer.Finish(end) && success;
+    std::error_code error;
+    fileBytes = std::filesystem::file_size(path, error);
+    if (success) Log::Debug("Saved screen recording to %s", path.string().c_str());
+    return success;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <condition_variable>
+#include <windows.h>
+#include "image_diff.hpp"
+
+// Records an area of the screen to an animated PNG. A capture worker grabs the
+// area at a fixed frame rate and diffs each frame against the last one it passed
+// on; only the bounds of the changed tiles are queued. An encoder worker
+// compresses the queued frames and streams them to the file.
+//
+// Memory stays bounded however long the recording runs: the capture worker
+// holds two frames, the queue is capped in bytes and the encoder holds one
+// compressed frame. When the encoder falls behind, frames are dropped rather
+// than queued; the next frame is diffed against the last one queued, so what
+// the dropped frame changed is still recorded.
+class ScreenRecorder {
+  public:
+    struct Settings {
+        int frameRate = 5;
+        size_t queueBudget = 0; // Bytes of changed areas waiting for the encoder, at least one frame is queued
+        int compressionLevel = 1;
+        ImageDiff::Options diffOptions;
+    };
+
+    struct Stats {
+        uint64_t captured = 0;
+        uint64_t unchanged = 0; // Captures identical to the last queued frame
+        uint64_t dropped = 0;   // Captures dropped because the queue was full
+        uint64_t encoded = 0;
+        uint64_t fileBytes = 0;
+        size_t queuedBytes = 0;
+        double seconds = 0.0;
+    };
+
+    ~ScreenRecorder() { Stop(); }
+
+    // Records a screen rectangle to path until Stop(), fails if already recording
+    bool Start(const RECT &screenRect, const std::filesystem::path &path, const Settings &settings);
+    // Stops capturing, encodes what is queued and closes the file
+    void Stop();
+    // False again once the capture stops on its own, after an error
+    bool IsRecording() const {
+        return captureJob.valid() && captureJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    }
+    Stats GetStats() const;
+
+  private:
+    struct Frame {
+        RECT area = {}; // In capture pixels, the first frame covers the whole capture
+        uint32_t time = 0; // Milliseconds since the start
+        std::vector<BYTE> pixels; // Top-down BGRA of the area
+    };
+
+    void CaptureLoop(RECT screenRect, Settings settings);
+    bool EncodeLoop(std::filesystem::path path, int level);
+    bool Push(Frame &&frame, size_t budget);
+
+  private:
+    mutable std::mutex mutex;
+    std::condition_variable queueChanged;
+    std::deque<Frame> queue;
+    size_t queuedBytes = 0;
+    bool captureDone = false; // Set by the capture worker, the encoder drains the queue and stops
+    bool stopRequested = false;
+    uint32_t endTime = 0;
+
+    std::atomic<uint64_t> captured = 0;
+    std::atomic<uint64_t> unchanged = 0;
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<uint64_t> encoded = 0;
+    std::atomic<uint64_t> fileBytes = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    // Declared last, so they are joined before the state they use is destroyed
+    std::future<void> captureJob;
+    std::future<bool> encodeJob;
+};
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "screenshot_history.hpp"
+#include "image_encode.hpp"
+#include "perceptual_hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+ScreenshotHistory::ScreenshotHistory(size_t maxEntries, size_t memoryBudget)
+    : maxEntries(maxEntries), memoryBudget(memoryBudget) {}
+
+// 64-bit multiply-xorshift hash over the tile's rows, mixed with its size so
+// edge tiles never match full ones. A collision would show a wrong tile, at
+// 64 bits that is far less likely than a memory error.
+uint64_t ScreenshotHistory::HashTile(const uint8_t *bgra, size_t pitch, int width, int height) {
+    constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = (static_cast<uint64_t>(width) << 32 | static_cast<uint32_t>(height)) * multiplier;
+
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = bgra + y * pitch;
+        size_t x = 0;
+        for (; x + 8 <= rowBytes; x += 8) {
+            uint64_t word;
+            memcpy(&word, row + x, 8);
+            hash = (hash ^ word) * multiplier;
+            hash ^= hash >> 29;
+        }
+        for (; x < rowBytes; x += 4) {
+            uint32_t word;
+            memcpy(&word, row + x, 4);
+            hash = (hash ^ word) * multiplier;
+            hash ^= hash >> 29;
+        }
+    }
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t ScreenshotHistory::Add(const uint8_t *bgra, int width, int height, size_t pitch, uint64_t perceptualHash) {
+    if (maxEntries == 0 || !bgra || width <= 0 || height <= 0) return 0;
+
+    const int columns = (width + TileSize - 1) / TileSize;
+    const int rows = (height + TileSize - 1) / TileSize;
+    const auto tileOrigin = [&](size_t index) {
+        const int x = static_cast<int>(index % columns) * TileSize;
+        const int y = static_cast<int>(index / columns) * TileSize;
+        return bgra + y * pitch + static_cast<size_t>(x) * 4;
+    };
+    const auto tileWidth = [&](size_t index) { return std::min(TileSize, width - static_cast<int>(index % columns) * TileSize); };
+    const auto tileHeight = [&](size_t index) { return std::min(TileSize, height - static_cast<int>(index / columns) * TileSize); };
+
+    // Hash outside the lock, decoding other entries can go on meanwhile
+    std::vector<uint64_t> hashes(static_cast<size_t>(columns) * rows);
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        hashes[i] = HashTile(tileOrigin(i), pitch, tileWidth(i), tileHeight(i));
+    }
+
+    Entry entry;
+    entry.width = width;
+    entry.height = height;
+    entry.perceptualHash = perceptualHash;
+    entry.tiles.resize(hashes.size());
+
+    // Look up shared tiles, only those nobody has stored yet get compressed
+    std::vector<size_t> missing;
+    {
+        std::lock_guard lock(mutex);
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            const auto found = tiles.find(hashes[i]);
+            if (found != tiles.end())
+                entry.tiles[i] = found->second;
+            else
+                missing.push_back(i);
+        }
+    }
+
+    std::unordered_map<uint64_t, std::shared_ptr<const Tile>> compressed;
+    for (const size_t i : missing) {
+        // Repeated content within this capture (blank areas) is compressed once
+        std::shared_ptr<const Tile> &tile = compressed[hashes[i]];
+        if (!tile) {
+            const int w = tileWidth(i), h = tileHeight(i);
+            tile = std::make_shared<const Tile>(Tile{ImageEncode::EncodeQoi(tileOrigin(i), w, h, pitch), w, h});
+        }
+        entry.tiles[i] = tile;
+    }
+
+    std::lock_guard lock(mutex);
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        // Another Add may have stored the same tile meanwhile, or an eviction
+        // dropped one found above, keep exactly one copy in the map
+        const auto [it, inserted] = tiles.try_emplace(hashes[i], entry.tiles[i]);
+        if (inserted) compressedBytes += it->second->data.size();
+        entry.tiles[i] = it->second;
+    }
+
+    entry.id = nextId++;
+    entries.push_back(std::move(entry));
+    Evict();
+    return entries.back().id;
+}
+
+// Drops the oldest entries over the count or budget, then the tiles no entry uses any more
+void ScreenshotHistory::Evict() {
+    const auto overBudget = [this]() {
+        return entries.size() > maxEntries || compressedBytes > memoryBudget;
+    };
+    while (entries.size() > 1 && overBudget()) {
+        entries.pop_front();
+
+        // A tile still being read by Decode() is released by a later sweep
+        for (auto it = tiles.begin(); it != tiles.end();) {
+            if (it->second.use_count() == 1) {
+                compressedBytes -= it->second->data.size();
+                it = tiles.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+bool ScreenshotHistory::Decode(uint64_t id, std::vector<uint8_t> &out, int &width, int &height) const {
+    // Copy the tile list so decompression runs without the lock
+    Entry entry;
+    {
+        std::lock_guard lock(mutex);
+        const auto found = std::find_if(entries.begin(), entries.end(), [id](const Entry &e) { return e.id == id; });
+        if (found == entries.end()) return false;
+        entry = *found;
+    }
+
+    width = entry.width;
+    height = entry.height;
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    out.resize(pitch * height);
+
+    const int columns = (width + TileSize - 1) / TileSize;
+    for (size_t i = 0; i < entry.tiles.size(); ++i) {
+        const Tile &tile = *entry.tiles[i];
+        const int x = static_cast<int>(i % columns) * TileSize;
+        const int y = static_cast<int>(i / columns) * TileSize;
+        uint8_t *origin = out.data() + y * pitch + static_cast<size_t>(x) * 4;
+        if (!ImageEncode::DecodeQoi(tile.data.data(), tile.data.size(), origin, tile.width, tile.height, pitch)) return false;
+    }
+    return true;
+}
+
+uint64_t ScreenshotHistory::FindSimilar(uint64_t perceptualHash, int threshold) const {
+    if (threshold < 0) return 0;
+
+    std::lock_guard lock(mutex);
+    const auto found = std::find_if(entries.rbegin(), entries.rend(), [&](const Entry &entry) {
+        return PerceptualHash::Distance(entry.perceptualHash, perceptualHash) <= threshold;
+    });
+    return found != entries.rend() ? found->id : 0;
+}
+
+void ScreenshotHistory::GetPosition(uint64_t id, int &position, int &count) const {
+    std::lock_guard lock(mutex);
+    const auto found = std::find_if(entries.begin(), entries.end(), [id](const Entry &entry) { return entry.id == id; });
+    position = found != entries.end() ? static_cast<int>(found - entries.begin()) + 1 : 0;
+    count = static_cast<int>(entries.size());
+}
+
+std::vector<uint64_t> ScreenshotHistory::GetIds() const {
+    std::lock_guard lock(mutex);
+    std::vector<uint64_t> ids;
+    ids.reserve(entries.size());
+    for (const Entry &entry : entries) {
+        ids.push_back(entry.id);
+    }
+    return ids;
+}
+
+ScreenshotHistory::Stats ScreenshotHistory::GetStats() const {
+    std::lock_guard lock(mutex);
+    Stats stats;
+    stats.entries = entries.size();
+    stats.uniqueTiles = tiles.size();
+    stats.compressedBytes = compressedBytes;
+    for (const Entry &entry : entries) {
+        stats.tileReferences += entry.tiles.size();
+        stats.rawBytes += static_cast<size_t>(entry.width) * entry.height * 4;
+    }
+    return stats;
+}
+
+void ScreenshotHistory::Clear() {
+    std::lock_guard lock(mutex);
+    entries.clear();
+    tiles.clear();
+    compressedBytes = 0;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Ring of recent captures. Each capture is cut into fixed tiles keyed by a
+// content hash: tiles already stored by another entry are shared, new ones are
+// QOI-compressed once. Only the entry being viewed is ever decompressed.
+// Thread-safe, captures are added and decoded on workers.
+class ScreenshotHistory {
+  public:
+    static constexpr int TileSize = 64;
+
+    struct Stats {
+        size_t entries = 0;
+        size_t uniqueTiles = 0;
+        size_t tileReferences = 0;
+        size_t compressedBytes = 0; // Held by the unique tiles
+        size_t rawBytes = 0;        // The same entries as plain BGRA buffers
+    };
+
+    /**
+     * @param maxEntries    Oldest entries beyond this count are dropped.
+     * @param memoryBudget  Compressed bytes kept, the newest entry is kept even when it alone exceeds it.
+     */
+    ScreenshotHistory(size_t maxEntries, size_t memoryBudget);
+
+    // Stores a top-down BGRA capture and returns its id, 0 when history is disabled
+    uint64_t Add(const uint8_t *bgra, int width, int height, size_t pitch, uint64_t perceptualHash);
+    // Newest entry whose perceptual hash is within threshold bits of hash, 0 if none
+    uint64_t FindSimilar(uint64_t perceptualHash, int threshold) const;
+    // Decompresses an entry into out (resized to width * height * 4)
+    bool Decode(uint64_t id, std::vector<uint8_t> &out, int &width, int &height) const;
+    // Ids of the stored entries, oldest first
+    std::vector<uint64_t> GetIds() const;
+    // 1-based position of an entry, oldest first, 0 when not stored. Nothing is copied, cheap enough per frame.
+    void GetPosition(uint64_t id, int &position, int &count) const;
+    Stats GetStats() const;
+    void Clear();
+
+  private:
+    struct Tile {
+        std::vector<uint8_t> data; // QOI op stream
+        int width = 0;
+        int height = 0;
+    };
+
+    struct Entry {
+        uint64_t id = 0;
+        int width = 0;
+        int height = 0;
+        uint64_t perceptualHash = 0;
+        std::vector<std::shared_ptr<const Tile>> tiles; // Row-major
+    };
+
+    static uint64_t HashTile(const uint8_t *bgra, size_t pitch, int width, int height);
+    void Evict();
+
+  private:
+    size_t maxEntries;
+    size_t memoryBudget;
+    uint64_t nextId = 1;
+    size_t compressedBytes = 0;
+    std::deque<Entry> entries;
+    // Every stored tile, the map's reference is dropped once no entry uses the tile
+    std::unordered_map<uint64_t, std::shared_ptr<const Tile>> tiles;
+    mutable std::mutex mutex;
+};
\ No newline at end of file
@@ -0,0 +1,874 @@
+#include "screenshot_manager.hpp"
+#include "clipboard.hpp"
+#include "utils.hpp"
+#include "image_encode.hpp"
+#include "image_resample.hpp"
+#include "image_filter.hpp"
+#include "perceptual_hash.hpp"
+#include "Log.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <dwmapi.h>
+
+namespace {
+
+// A reply from the WebView, delivered on the UI thread. Completes with an empty
+// value if the WebView drops the request, a broken promise would throw in get().
+template <typename T>
+struct WebViewReply {
+    std::promise<T> value;
+    bool delivered = false;
+
+    ~WebViewReply() {
+        if (!delivered) value.set_value({});
+    }
+    void Deliver(T result) {
+        value.set_value(std::move(result));
+        delivered = true;
+    }
+};
+
+} // namespace
+
+ScreenshotManager::ScreenshotManager(ID3D11Device *device, Settings settings)
+    : settings(std::move(settings)), device(device),
+      history(this->settings.historyEntries, this->settings.historyBudget),
+      savedImages(16, this->settings.duplicateThreshold) {
+    const D3D11_SAMPLER_DESC desc = {
+        .Filter = D3D11_FILTER_MIN_MAG_MIP_POINT,
+        .AddressU = D3D11_TEXTURE_ADDRESS_BORDER,
+        .AddressV = D3D11_TEXTURE_ADDRESS_BORDER,
+        .AddressW = D3D11_TEXTURE_ADDRESS_BORDER,
+        .ComparisonFunc = D3D11_COMPARISON_ALWAYS,
+        .MaxLOD = D3D11_FLOAT32_MAX,
+    };
+    // The loupe falls back to the default sampler without it
+    if (device && FAILED(device->CreateSamplerState(&desc, &pointSampler))) {
+        Log::Warning("Failed to create the screenshot loupe sampler");
+    }
+}
+
+void ScreenshotManager::SetWindows(HWND window, HWND webview) {
+    windowHwnd = window;
+    webviewHwnd = webview;
+}
+
+void ScreenshotManager::Capture() {
+    hasImage = false;
+    selector.Cancel();
+    if (IsCapturing()) {
+        // The worker owns the buffer, start again once it is done. A capture
+        // for a file is still saved, only a panel capture is dropped.
+        discardPending = !captureToFile;
+        captureRequested = true;
+        return;
+    }
+    AcquireBuffer();
+    StartCapture(buffer);
+}
+
+void ScreenshotManager::Capture(bool value) {
+    if (value)
+        Capture();
+    else
+        Release();
+}
+
+void ScreenshotManager::CopyToClipboard() {
+    if (!hasImage) {
+        Log::Error("No screenshot captured");
+        return;
+    }
+
+    if (!Clipboard::SetImage({width, height, buffer})) {
+        Log::Error("Failed to copy screenshot to clipboard");
+    }
+}
+
+void ScreenshotManager::Save() {
+    if (!hasImage) {
+        Log::Error("No screenshot captured");
+        return;
+    }
+
+    // An explicit save is always written, duplicate or not
+    SaveImage(buffer, width, height, false);
+}
+
+void ScreenshotManager::CaptureToFile() {
+    if (settings.captureMode == CaptureMode::Region) {
+        // The selection needs the overlay, which lives on this thread
+        if (IsCapturing() || selector.IsActive()) return;
+        captureToFile = true;
+        StartCapture(std::make_shared<std::vector<BYTE>>());
+        return;
+    }
+
+    if (settings.captureMode == CaptureMode::Element) {
+        if (settings.elementSelector.empty()) {
+            Log::Error("Enter a CSS selector or pick an element to capture");
+            return;
+        }
+        StartElementLookup(nullptr);
+        return;
+    }
+
+    if (settings.captureMode == CaptureMode::WebView) {
+        if (auto png = RequestPagePng()) {
+            // Shared so the job stays copyable for std::function
+            auto pending = std::make_shared<std::future<std::vector<unsigned char>>>(std::move(*png));
+            StartSave([this, pending](const std::filesystem::path &path) {
+                std::vector<BYTE> pixels;
+                int width = 0, height = 0;
+                if (!DecodePagePng(*pending, pixels, width, height)) return SaveResult::Failed;
+                return WriteFile(path, pixels.data(), width, height, true);
+            });
+            return;
+        }
+    }
+
+    StartSave([this, rect = GetCaptureRect(settings.captureMode)](const std::filesystem::path &path) {
+        std::vector<BYTE> pixels;
+        int width = 0, height = 0;
+        if (!Utils::CaptureScreenRegion(rect, pixels, width, height)) return SaveResult::Failed;
+        return WriteFile(path, pixels.data(), width, height, true);
+    });
+}
+
+void ScreenshotManager::ShowHistory(int step) {
+    if (IsCapturing() || pendingHistory.valid() || selector.IsActive()) return;
+    // A panel Element capture waiting for its bounds is about to write the buffer
+    if (std::ranges::any_of(elementLookups, [](const ElementLookup &lookup) { return lookup.target != nullptr; })) return;
+
+    const std::vector<uint64_t> ids = history.GetIds();
+    const auto current = std::find(ids.begin(), ids.end(), shownHistoryId);
+    if (current == ids.end()) return;
+    const ptrdiff_t index = (current - ids.begin()) + step;
+    if (index < 0 || index >= std::ssize(ids)) return;
+
+    hasImage = false;
+    grabbed = true; // Nothing is read from the screen, the panel stays visible
+    AcquireBuffer();
+    pendingCapture = std::async(std::launch::async, [this, target = buffer, historyId = ids[index],
+                                                     maxWidth = previewMaxWidth, maxHeight = previewMaxHeight]() {
+        CaptureResult result;
+        result.pixels = target;
+        result.historyId = historyId;
+        const size_t capacity = target->capacity();
+        result.success = history.Decode(historyId, *target, result.width, result.height);
+        result.allocatedBytes = target->capacity() != capacity ? target->capacity() : 0;
+        if (result.success) result.preview = BuildPreview(*target, result.width, result.height, maxWidth, maxHeight);
+        return result;
+    });
+}
+
+void ScreenshotManager::Release() {
+    hasImage = false;
+    captureRequested = false;
+    selector.Cancel();
+    std::erase_if(elementLookups, [](const ElementLookup &lookup) { return lookup.target != nullptr; });
+    if (IsCapturing()) {
+        // Trimmed when the worker hands the buffer back
+        discardPending = true;
+        return;
+    }
+    Trim();
+}
+
+void ScreenshotManager::ScreenCleared() {
+    if (!screenCleared || !IsGrabbing()) return;
+    screenCleared->set_value();
+    screenCleared.reset();
+}
+
+void ScreenshotManager::Update() {
+    using namespace std::chrono_literals;
+    fullPage.Update();
+    UpdateElementLookups();
+    if (std::optional<std::string> picked = elementLocator.Update()) {
+        settings.elementSelector = std::move(*picked);
+        if (settings.captureMode == CaptureMode::Element) Capture();
+    }
+    std::erase_if(saveJobs, [](const std::future<void> &job) { return job.wait_for(0s) == std::future_status::ready; });
+    stats.skippedDuplicateSaves = skippedSaves;
+
+    if (pendingPreview.valid() && pendingPreview.wait_for(0s) == std::future_status::ready) {
+        const Preview preview = pendingPreview.get();
+        // Dropped when the image was released or replaced meanwhile
+        if (hasImage && preview.imageId == imageId && UploadTexture(preview)) textureImageId = imageId;
+    }
+
+    if (pendingHistory.valid() && pendingHistory.wait_for(0s) == std::future_status::ready) {
+        const HistoryResult result = pendingHistory.get();
+        if (result.imageId == imageId) {
+            shownHistoryId = result.historyId;
+            shownCollapsed = result.collapsed;
+        }
+        if (result.collapsed) ++stats.collapsedDuplicates;
+    }
+
+    if (pendingDiff.valid() && pendingDiff.wait_for(0s) == std::future_status::ready) {
+        DiffResult diff = pendingDiff.get();
+        stats.lastDiffMilliseconds = diff.milliseconds;
+        stats.lastDiffBytes = diff.bytes;
+        stats.lastChangedTiles = diff.changedTiles;
+        if (diff.imageId == imageId) {
+            changedRegions = std::move(diff.regions);
+            diffImageId = imageId;
+        }
+    }
+    // The diff needs the shown capture's history entry to find what to compare with
+    if (highlightChanges && hasImage && shownHistoryId && diffImageId != imageId && !pendingDiff.valid() && !IsCapturing()) {
+        StartDiff();
+    }
+
+    if (!pendingCapture.valid() || pendingCapture.wait_for(0s) != std::future_status::ready) return;
+
+    CaptureResult result = pendingCapture.get();
+    if (captureToFile) {
+        captureToFile = false;
+        // A Release() meanwhile was meant for the panel, not for this capture or the next one
+        discardPending = false;
+        if (result.success) BeginSelection(result, true);
+    } else if (discardPending) {
+        discardPending = false;
+        result.pixels.reset();
+        Trim();
+    } else if (result.success && result.mode == CaptureMode::Region && !result.historyId) {
+        BeginSelection(result, false);
+    } else {
+        Publish(result);
+    }
+
+    if (captureRequested) {
+        captureRequested = false;
+        Capture();
+    }
+}
+
+// Called every frame, so nothing is copied: the regions are a view of changedRegions
+ScreenshotImage ScreenshotManager::GetImage() const {
+    int historyPosition = 0, historyCount = 0;
+    history.GetPosition(shownHistoryId, historyPosition, historyCount);
+    return {
+        .width = width,
+        .height = height,
+        // A texture still showing the previous capture is hidden until the new preview is uploaded
+        .textureView = hasImage && textureImageId == imageId ? texture.Get() : nullptr,
+        .pending = IsCapturing() || selector.IsActive() || (hasImage && textureImageId != imageId) ||
+                   std::ranges::any_of(elementLookups, [](const ElementLookup &lookup) { return lookup.target != nullptr; }),
+        .mode = settings.captureMode,
+        .historyPosition = historyPosition,
+        .historyCount = historyCount,
+        .highlightChanges = highlightChanges,
+        .changedRegions = highlightChanges && diffImageId == imageId ? std::span<const RECT>(changedRegions) : std::span<const RECT>(),
+        .redactTool = redactTool,
+        .pointSampler = pointSampler.Get(),
+        .recording = recorder.IsRecording(),
+        .fullPageActive = fullPage.IsActive(),
+        .elementSelector = settings.elementSelector,
+        .pickingElement = elementLocator.IsPicking()
+    };
+}
+
+void ScreenshotManager::SetRecording(bool value) {
+    if (!value) {
+        recorder.Stop();
+        return;
+    }
+    // Read from the screen like a GDI capture, the page source is too slow for a steady frame rate
+    if (!recorder.Start(GetCaptureRect(CaptureMode::WebView), MakeFilePath("apng"), settings.recording)) {
+        Log::Error("Failed to start screen recording");
+    }
+}
+
+std::optional<uint32_t> ScreenshotManager::GetPixel(int x, int y) const {
+    // A running capture may be writing into the buffer
+    if (!hasImage || IsCapturing() || !buffer || x < 0 || y < 0 || x >= width || y >= height) return std::nullopt;
+    const size_t offset = (static_cast<size_t>(y) * width + x) * 4;
+    if (offset + 4 > buffer->size()) return std::nullopt;
+    uint32_t pixel;
+    std::memcpy(&pixel, buffer->data() + offset, sizeof(pixel));
+    return pixel;
+}
+
+size_t ScreenshotManager::GetRetainedBytes() const {
+    // A buffer still referenced by the clipboard is not ours to free
+    const size_t bufferBytes = (buffer && buffer.use_count() == 1) ? buffer->capacity() : 0;
+    return bufferBytes + texture.GetByteSize();
+}
+
+void ScreenshotManager::SetPreviewSize(int maxWidth, int maxHeight) {
+    previewMaxWidth = std::max(1, maxWidth);
+    previewMaxHeight = std::max(1, maxHeight);
+    if (!hasImage || IsCapturing() || pendingPreview.valid()) return;
+
+    // Rebuild only on a noticeable change, not on every pixel of a resize drag
+    int fitWidth, fitHeight;
+    FitPreview(width, height, previewMaxWidth, previewMaxHeight, fitWidth, fitHeight);
+    const int threshold = std::max(16, textureWidth / 10);
+    if (std::abs(fitWidth - textureWidth) > threshold) StartPreview();
+}
+
+// Screen rectangle of the current mode, window positions are only read on the UI thread
+RECT ScreenshotManager::GetCaptureRect(CaptureMode mode) const {
+    RECT rect = {};
+    switch (mode) {
+    case CaptureMode::WebView:
+    case CaptureMode::Element: // Clips the element
+        if (webviewHwnd && GetWindowRect(webviewHwnd, &rect)) return rect;
+        // Not created yet, fall back to the client area
+        if (windowHwnd && GetClientRect(windowHwnd, &rect)) {
+            MapWindowPoints(windowHwnd, nullptr, reinterpret_cast<POINT *>(&rect), 2);
+            return rect;
+        }
+        break;
+    case CaptureMode::Window:
+        if (windowHwnd && GetWindowRect(windowHwnd, &rect)) return rect;
+        break;
+    case CaptureMode::Region:
+        return Utils::GetVirtualScreenRect();
+    case CaptureMode::Screen:
+        break;
+    }
+    return {0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN)};
+}
+
+void ScreenshotManager::StartCapture(std::shared_ptr<std::vector<BYTE>> target) {
+    // A new panel capture replaces an Element capture still waiting for its bounds
+    std::erase_if(elementLookups, [](const ElementLookup &lookup) { return lookup.target != nullptr; });
+    const std::shared_future<void> cleared = BeginScreenGrab();
+    const RECT rect = GetCaptureRect(settings.captureMode);
+    // A region capture is cropped before it is shown, a preview of all monitors would be wasted
+    const bool buildPreview = !captureToFile && settings.captureMode != CaptureMode::Region;
+
+    if (settings.captureMode == CaptureMode::WebView) {
+        if (auto png = RequestPagePng()) {
+            grabbed = true; // Nothing is read from the screen, the panel stays visible
+            pendingCapture = std::async(std::launch::async, [target, png = std::move(*png), origin = POINT{rect.left, rect.top},
+                                                             maxWidth = previewMaxWidth, maxHeight = previewMaxHeight]() mutable {
+                CaptureResult result;
+                result.pixels = target;
+                result.origin = origin;
+                const size_t capacity = target->capacity();
+                result.success = DecodePagePng(png, *target, result.width, result.height);
+                result.allocatedBytes = target->capacity() != capacity ? target->capacity() : 0;
+                if (result.success) result.preview = BuildPreview(*target, result.width, result.height, maxWidth, maxHeight);
+                return result;
+            });
+            return;
+        }
+    }
+
+    if (settings.captureMode == CaptureMode::Element) {
+        // The panel stays up while the page looks for the element, nothing is read from the screen yet
+        grabbed = true;
+        // Nothing to show until a selector is typed or picked, the panel says so
+        if (!settings.elementSelector.empty()) StartElementLookup(target);
+        return;
+    }
+
+    // Only the worker touches the buffer until Update() collects the result
+    pendingCapture = std::async(std::launch::async, [this, target, rect, buildPreview, cleared, mode = settings.captureMode,
+                                                     maxWidth = previewMaxWidth, maxHeight = previewMaxHeight]() {
+        return CaptureScreen(target, rect, mode, buildPreview, maxWidth, maxHeight, cleared);
+    });
+}
+
+// Runs on a capture worker
+ScreenshotManager::CaptureResult ScreenshotManager::CaptureScreen(
+    std::shared_ptr<std::vector<BYTE>> target, const RECT &rect, CaptureMode mode, bool buildPreview, int maxWidth, int maxHeight,
+    const std::shared_future<void> &cleared
+) {
+    using namespace std::chrono_literals;
+    // The panel and the WebView hole are gone in the next frame the UI thread presents,
+    // and on screen after the following composition. Not waiting forever on a stalled UI.
+    cleared.wait_for(500ms);
+    DwmFlush();
+
+    CaptureResult result;
+    result.pixels = target;
+    result.mode = mode;
+    const size_t capacity = target->capacity();
+    result.success = Utils::CaptureScreenRegion(rect, *target, result.width, result.height, [this]() { grabbed = true; });
+    result.allocatedBytes = target->capacity() != capacity ? target->capacity() : 0;
+    grabbed = true;
+    if (result.success) {
+        const RECT virtualScreen = Utils::GetVirtualScreenRect();
+        result.origin = {std::max(rect.left, virtualScreen.left), std::max(rect.top, virtualScreen.top)};
+        if (buildPreview) result.preview = BuildPreview(*target, result.width, result.height, maxWidth, maxHeight);
+    }
+    return result;
+}
+
+// The panel is hidden and the worker waits for ScreenCleared() before reading the screen
+std::shared_future<void> ScreenshotManager::BeginScreenGrab() {
+    grabbed = false;
+    screenCleared.emplace();
+    return screenCleared->get_future().share();
+}
+
+// The page scrolls the element into view and reports its bounds on this thread,
+// UpdateElementLookups() captures it once they arrive
+void ScreenshotManager::StartElementLookup(std::shared_ptr<std::vector<BYTE>> target) {
+    using namespace std::chrono_literals;
+    if (!scriptRunner) {
+        Log::Error("Element capture needs the WebView");
+        return;
+    }
+    elementLookups.push_back({
+        .bounds = RunScript(ElementLocator::MakeBoundsScript(settings.elementSelector)),
+        .webviewRect = GetCaptureRect(CaptureMode::Element),
+        .selector = settings.elementSelector,
+        .target = std::move(target),
+        .deadline = std::chrono::steady_clock::now() + 5s,
+    });
+}
+
+void ScreenshotManager::UpdateElementLookups() {
+    using namespace std::chrono_literals;
+    const auto now = std::chrono::steady_clock::now();
+    // True once the lookup is captured or has failed
+    const auto advance = [this, now](ElementLookup &lookup) {
+        if (!lookup.element) {
+            if (lookup.bounds.wait_for(0s) != std::future_status::ready) {
+                if (now < lookup.deadline) return false;
+                Log::Error("Timed out waiting for the page to find the element");
+                return true;
+            }
+            lookup.element = ElementLocator::ParseBounds(lookup.bounds.get(), lookup.webviewRect);
+            if (!lookup.element) {
+                Log::Error("No visible element matches \"%s\"", lookup.selector.c_str());
+                return true;
+            }
+            if (lookup.element->clipped) Log::Debug("The element is larger than the page view, only its visible part is captured");
+            // The page renders the scrolled view a few frames later
+            lookup.readyAt = lookup.element->scrolled ? now + 150ms : now;
+        }
+        if (now < lookup.readyAt) return false;
+        CaptureElement(lookup);
+        return true;
+    };
+    for (auto it = elementLookups.begin(); it != elementLookups.end();) {
+        it = advance(*it) ? elementLookups.erase(it) : it + 1;
+    }
+}
+
+// Crops the element out of a render of the page, so windows on top of the WebView and
+// the hole cut for the panel never show up. Read from the screen until the WebView is ready.
+void ScreenshotManager::CaptureElement(ElementLookup &lookup) {
+    const RECT screenRect = lookup.element->rect;
+    RECT crop = screenRect;
+    OffsetRect(&crop, -lookup.webviewRect.left, -lookup.webviewRect.top);
+    std::optional<std::future<std::vector<unsigned char>>> png = RequestPagePng();
+
+    if (!lookup.target) {
+        if (!png) {
+            StartSave([this, screenRect](const std::filesystem::path &path) {
+                std::vector<BYTE> pixels;
+                int width = 0, height = 0;
+                if (!Utils::CaptureScreenRegion(screenRect, pixels, width, height)) return SaveResult::Failed;
+                return WriteFile(path, pixels.data(), width, height, true);
+            });
+            return;
+        }
+        // Shared so the job stays copyable for std::function
+        auto pending = std::make_shared<std::future<std::vector<unsigned char>>>(std::move(*png));
+        StartSave([this, pending, crop](const std::filesystem::path &path) {
+            std::vector<BYTE> pixels;
+            int width = 0, height = 0;
+            if (!DecodePagePng(*pending, pixels, width, height, &crop)) return SaveResult::Failed;
+            return WriteFile(path, pixels.data(), width, height, true);
+        });
+        return;
+    }
+
+    if (!png) {
+        pendingCapture = std::async(std::launch::async, [this, target = lookup.target, screenRect, cleared = BeginScreenGrab(),
+                                                         maxWidth = previewMaxWidth, maxHeight = previewMaxHeight]() {
+            return CaptureScreen(target, screenRect, CaptureMode::Element, true, maxWidth, maxHeight, cleared);
+        });
+        return;
+    }
+    pendingCapture = std::async(std::launch::async, [target = lookup.target, png = std::move(*png), crop,
+                                                     origin = POINT{screenRect.left, screenRect.top},
+                                                     maxWidth = previewMaxWidth, maxHeight = previewMaxHeight]() mutable {
+        CaptureResult result;
+        result.pixels = target;
+        result.mode = CaptureMode::Element;
+        result.origin = origin;
+        const size_t capacity = target->capacity();
+        // Only the element is converted into the buffer, it stays element-sized and reusable
+        result.success = DecodePagePng(png, *target, result.width, result.height, &crop);
+        result.allocatedBytes = target->capacity() != capacity ? target->capacity() : 0;
+        if (result.success) result.preview = BuildPreview(*target, result.width, result.height, maxWidth, maxHeight);
+        return result;
+    });
+}
+
+// Asks the WebView for the page as PNG, it arrives on the UI thread while a worker waits for it
+std::optional<std::future<std::vector<unsigned char>>> ScreenshotManager::RequestPagePng() {
+    if (!pageCapture) return std::nullopt;
+
+    auto reply = std::make_shared<WebViewReply<std::vector<unsigned char>>>();
+    std::future<std::vector<unsigned char>> result = reply->value.get_future();
+    if (!pageCapture([reply](std::vector<unsigned char> data) { reply->Deliver(std::move(data)); })) return std::nullopt;
+    return result;
+}
+
+// The script's JSON result arrives on the UI thread, empty if it failed
+std::future<std::string> ScreenshotManager::RunScript(const std::string &script) {
+    auto reply = std::make_shared<WebViewReply<std::string>>();
+    std::future<std::string> result = reply->value.get_future();
+    if (scriptRunner) scriptRunner(script, [reply](std::string json) { reply->Deliver(std::move(json)); });
+    return result;
+}
+
+void ScreenshotManager::CaptureFullPage() {
+    if (!scriptRunner || !pageCapture) {
+        Log::Error("Full-page capture needs the WebView");
+        return;
+    }
+    fullPage.Start(MakeFilePath("png"), settings.fullPage,
+                   [this](const std::string &script) { return RunScript(script); },
+                   [this]() { return RequestPagePng(); });
+}
+
+void ScreenshotManager::PickElement() {
+    if (elementLocator.IsPicking()) {
+        elementLocator.CancelPicking();
+        return;
+    }
+    if (!scriptRunner) {
+        Log::Error("Picking an element needs the WebView");
+        return;
+    }
+    elementLocator.StartPicking([this](const std::string &script) { return RunScript(script); });
+}
+
+// Runs on a worker, the browser renders and encodes the page in its own process. The crop is
+// clipped to the render, which may be a pixel off the window size.
+bool ScreenshotManager::DecodePagePng(std::future<std::vector<unsigned char>> &png, std::vector<BYTE> &pixels, int &width, int &height,
+                                      const RECT *crop) {
+    using namespace std::chrono_literals;
+    // The UI thread delivers the PNG, it stops pumping messages on shutdown
+    if (png.wait_for(5s) != std::future_status::ready) {
+        Log::Error("Timed out waiting for the WebView capture");
+        return false;
+    }
+    const std::vector<unsigned char> data = png.get();
+    return Utils::DecodePng(data.data(), data.size(), pixels, width, height, crop);
+}
+
+// Shows the frozen capture on the overlay, the selected part becomes the screenshot or is saved
+void ScreenshotManager::BeginSelection(const CaptureResult &result, bool toFile) {
+    ++stats.captures;
+    stats.lastCaptureBytes = result.allocatedBytes;
+    stats.totalAllocatedBytes += result.allocatedBytes;
+    if (result.allocatedBytes == 0) ++stats.bufferReuses;
+
+    std::shared_ptr<std::vector<BYTE>> pixels = result.pixels;
+    const int fullWidth = result.width;
+    const bool started = selector.Begin(*pixels, result.width, result.height, result.origin,
+        [this, pixels, fullWidth, toFile](std::optional<RECT> selection) mutable {
+            if (!selection) {
+                pixels.reset();
+                if (!toFile) Trim();
+                return;
+            }
+
+            CropInPlace(*pixels, fullWidth, *selection);
+            const int cropWidth = selection->right - selection->left;
+            const int cropHeight = selection->bottom - selection->top;
+            if (toFile) {
+                SaveImage(pixels, cropWidth, cropHeight, true);
+                return;
+            }
+
+            width = cropWidth;
+            height = cropHeight;
+            ++imageId;
+            hasImage = true;
+            shownHistoryId = 0;
+            shownCollapsed = false;
+            StartPreview();
+            StoreInHistory();
+        });
+    if (!started && !toFile) Trim();
+}
+
+// Moves the rows inside rect to the front of the buffer and shrinks it to them,
+// rows only ever move towards the start so this works in place
+void ScreenshotManager::CropInPlace(std::vector<BYTE> &pixels, int width, const RECT &rect) {
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    const size_t rowBytes = static_cast<size_t>(rect.right - rect.left) * 4;
+    const int rows = rect.bottom - rect.top;
+    for (int y = 0; y < rows; ++y) {
+        memmove(pixels.data() + y * rowBytes, pixels.data() + (rect.top + y) * pitch + rect.left * 4, rowBytes);
+    }
+    // The capacity stays for the next capture, Trim() gives it back when over budget
+    pixels.resize(rowBytes * rows);
+}
+
+void ScreenshotManager::StartPreview() {
+    // Holding a reference makes the next capture allocate a new buffer instead of overwriting this one
+    pendingPreview = std::async(std::launch::async, [pixels = buffer, width = width, height = height, id = imageId,
+                                                     maxWidth = previewMaxWidth, maxHeight = previewMaxHeight]() {
+        Preview preview = BuildPreview(*pixels, width, height, maxWidth, maxHeight);
+        preview.imageId = id;
+        return preview;
+    });
+}
+
+// Largest size with the image's aspect ratio that fits the area, never enlarged
+void ScreenshotManager::FitPreview(int width, int height, int maxWidth, int maxHeight, int &outWidth, int &outHeight) {
+    const double scale = std::min({1.0, static_cast<double>(maxWidth) / width, static_cast<double>(maxHeight) / height});
+    outWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+    outHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+}
+
+ScreenshotManager::Preview ScreenshotManager::BuildPreview(
+    const std::vector<BYTE> &pixels, int width, int height, int maxWidth, int maxHeight
+) {
+    Preview preview;
+    FitPreview(width, height, maxWidth, maxHeight, preview.width, preview.height);
+    preview.pixels.resize(static_cast<size_t>(preview.width) * preview.height * 4);
+    // Integer box filter, the preview favours speed and is never enlarged
+    ImageResample::Downscale(
+        pixels.data(), width, height, static_cast<size_t>(width) * 4,
+        preview.pixels.data(), preview.width, preview.height, static_cast<size_t>(preview.width) * 4
+    );
+    return preview;
+}
+
+void ScreenshotManager::Publish(const CaptureResult &result) {
+    if (!result.historyId) ++stats.captures;
+    if (!result.success) {
+        Log::Error(result.historyId ? "Failed to decode screenshot history" : "Failed to capture screenshot");
+        return;
+    }
+
+    width = result.width;
+    height = result.height;
+    ++imageId;
+    stats.lastCaptureBytes = result.allocatedBytes;
+    if (result.allocatedBytes == 0) ++stats.bufferReuses;
+
+    hasImage = UploadTexture(result.preview);
+    if (hasImage) textureImageId = imageId;
+    shownHistoryId = result.historyId;
+    shownCollapsed = false;
+    if (!result.historyId) StoreInHistory();
+    stats.totalAllocatedBytes += stats.lastCaptureBytes;
+    Log::Debug("Screenshot %dx%d, %llu bytes allocated", width, height,
+               static_cast<unsigned long long>(stats.lastCaptureBytes));
+}
+
+void ScreenshotManager::AcquireBuffer() {
+    // The clipboard may still reference the previous capture, never write into it
+    if (!buffer || buffer.use_count() > 1) buffer = std::make_shared<std::vector<BYTE>>();
+}
+
+bool ScreenshotManager::UploadTexture(const Preview &preview) {
+    if (preview.pixels.empty()) return false;
+
+    if (!texture || textureWidth != preview.width || textureHeight != preview.height) {
+        texture = Utils::CreateUpdatableTextureBGRA(preview.width, preview.height, device.Get());
+        if (!texture) return false;
+        textureWidth = preview.width;
+        textureHeight = preview.height;
+        stats.lastCaptureBytes += texture.GetByteSize();
+    } else {
+        ++stats.textureReuses;
+    }
+    return Utils::UpdateTexture(
+        texture, preview.pixels.data(), static_cast<size_t>(preview.width) * 4, {0, 0, preview.width, preview.height}
+    );
+}
+
+void ScreenshotManager::Redact(const RECT &area) {
+    if (!hasImage || IsCapturing() || redactTool == RedactTool::None) return;
+
+    RECT clipped;
+    const RECT bounds = {0, 0, width, height};
+    if (!IntersectRect(&clipped, &area, &bounds)) return;
+
+    // The clipboard renders from the buffer on demand and workers may still read it,
+    // they keep the unredacted pixels they were given
+    if (buffer.use_count() > 1) buffer = std::make_shared<std::vector<BYTE>>(*buffer);
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    const int areaWidth = clipped.right - clipped.left;
+    const int areaHeight = clipped.bottom - clipped.top;
+    if (redactTool == RedactTool::Blur) {
+        ImageFilter::BoxBlur(buffer->data(), pitch, clipped.left, clipped.top, areaWidth, areaHeight, settings.blurRadius);
+    } else {
+        ImageFilter::Pixelate(
+            buffer->data(), pitch, clipped.left, clipped.top, areaWidth, areaHeight, settings.pixelateBlockSize
+        );
+    }
+    stats.lastRedactMilliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    UpdatePreviewArea(clipped);
+    // A preview still being built would show the unredacted pixels
+    if (pendingPreview.valid()) StartPreview();
+}
+
+// Rebuilds only the 32x32 preview tiles covering a changed area of the capture
+void ScreenshotManager::UpdatePreviewArea(const RECT &area) {
+    if (!texture || textureImageId != imageId) return;
+
+    constexpr LONG tileSize = 32;
+    const double scaleX = static_cast<double>(textureWidth) / width;
+    const double scaleY = static_cast<double>(textureHeight) / height;
+    const RECT tiles = {
+        static_cast<LONG>(area.left * scaleX) / tileSize * tileSize,
+        static_cast<LONG>(area.top * scaleY) / tileSize * tileSize,
+        std::min<LONG>(textureWidth, (static_cast<LONG>(std::ceil(area.right * scaleX)) + tileSize - 1) / tileSize * tileSize),
+        std::min<LONG>(textureHeight, (static_cast<LONG>(std::ceil(area.bottom * scaleY)) + tileSize - 1) / tileSize * tileSize)
+    };
+    const int tilesWidth = tiles.right - tiles.left;
+    const int tilesHeight = tiles.bottom - tiles.top;
+    if (tilesWidth <= 0 || tilesHeight <= 0) return;
+
+    // Only those tiles of the preview's downscale, pixel for pixel what BuildPreview makes
+    const size_t tilesPitch = static_cast<size_t>(tilesWidth) * 4;
+    std::vector<BYTE> pixels(tilesPitch * tilesHeight);
+    if (!ImageResample::DownscaleArea(buffer->data(), width, height, static_cast<size_t>(width) * 4, textureWidth, textureHeight,
+                                      tiles.left, tiles.top, tilesWidth, tilesHeight, pixels.data(), tilesPitch)) {
+        return;
+    }
+    if (Utils::UpdateTexture(texture, pixels.data(), tilesPitch, tiles)) {
+        stats.lastRedactUploadPixels = static_cast<uint64_t>(tilesWidth) * tilesHeight;
+    }
+}
+
+// Keep the buffers for the next capture only while they fit the budget,
+// the CPU copy goes first since the texture is the costlier one to recreate
+void ScreenshotManager::Trim() {
+    // Drop capacity left over from a larger capture
+    if (buffer && buffer.use_count() == 1) buffer->shrink_to_fit();
+    if (GetRetainedBytes() > settings.memoryBudget && buffer) {
+        buffer.reset();
+    }
+    if (GetRetainedBytes() > settings.memoryBudget) {
+        texture.Reset();
+        textureWidth = textureHeight = 0;
+        textureImageId = 0;
+    }
+}
+
+// "WebFrame_YYYYMMDD_HHMMSS_mmm.ext" in the save directory
+std::filesystem::path ScreenshotManager::MakeFilePath(const char *extension) const {
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+
+    char name[64];
+    snprintf(name, sizeof(name), "WebFrame_%04d%02d%02d_%02d%02d%02d_%03d.%s",
+             time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond, time.wMilliseconds,
+             extension ? extension : settings.fileFormat == FileFormat::Qoi ? "qoi" : "png");
+    return settings.saveDirectory / name;
+}
+
+void ScreenshotManager::StoreInHistory() {
+    if (settings.historyEntries == 0) return;
+
+    // Holds the buffer like a preview does, a capture started meanwhile allocates its own
+    pendingHistory = std::async(std::launch::async, [this, pixels = buffer, width = width, height = height, id = imageId]() {
+        HistoryResult result;
+        result.imageId = id;
+        const size_t pitch = static_cast<size_t>(width) * 4;
+        const uint64_t hash = PerceptualHash::DHash(pixels->data(), width, height, pitch);
+
+        // A capture that looks like a stored one is shown as that entry rather than stored again
+        result.historyId = history.FindSimilar(hash, settings.duplicateThreshold);
+        result.collapsed = result.historyId != 0;
+        if (!result.collapsed) result.historyId = history.Add(pixels->data(), width, height, pitch, hash);
+        return result;
+    });
+}
+
+void ScreenshotManager::StartDiff() {
+    const std::vector<uint64_t> ids = history.GetIds();
+    const auto shown = std::find(ids.begin(), ids.end(), shownHistoryId);
+    // A collapsed capture is not stored, the entry it matched holds the pixels it
+    // differs from. Any other capture is compared with the entry before its own.
+    if (shown == ids.end() || (!shownCollapsed && shown == ids.begin())) {
+        // Nothing older to compare with
+        changedRegions.clear();
+        diffImageId = imageId;
+        return;
+    }
+
+    pendingDiff = std::async(std::launch::async, [this, pixels = buffer, width = width, height = height, id = imageId,
+                                                  previousId = shownCollapsed ? *shown : *(shown - 1),
+                                                  options = settings.diffOptions]() {
+        DiffResult diff;
+        diff.imageId = id;
+        std::vector<uint8_t> previous;
+        int previousWidth = 0, previousHeight = 0;
+        // Captures of different sizes are not compared, nothing is outlined
+        if (!history.Decode(previousId, previous, previousWidth, previousHeight) ||
+            previousWidth != width || previousHeight != height) {
+            return diff;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const ImageDiff::Result result =
+            ImageDiff::Compare(pixels->data(), previous.data(), width, height, static_cast<size_t>(width) * 4, options);
+        diff.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        diff.bytes = static_cast<uint64_t>(width) * height * 8;
+        diff.changedTiles = result.changedTiles;
+        for (const ImageDiff::Rect &region : result.regions) {
+            diff.regions.push_back({region.x, region.y, region.x + region.width, region.y + region.height});
+        }
+        return diff;
+    });
+}
+
+void ScreenshotManager::SaveImage(std::shared_ptr<const std::vector<BYTE>> pixels, int width, int height, bool skipDuplicates) {
+    // The shared buffer stays untouched while referenced, a new capture allocates its own
+    StartSave([this, pixels = std::move(pixels), width, height, skipDuplicates](const std::filesystem::path &path) {
+        return WriteFile(path, pixels->data(), width, height, skipDuplicates);
+    });
+}
+
+// Runs on a save worker
+ScreenshotManager::SaveResult ScreenshotManager::WriteFile(
+    const std::filesystem::path &path, const BYTE *pixels, int width, int height, bool skipDuplicates
+) {
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    if (skipDuplicates && savedImages.CheckAndInsert(PerceptualHash::DHash(pixels, width, height, pitch))) {
+        ++skippedSaves;
+        return SaveResult::Skipped;
+    }
+
+    const bool written = settings.fileFormat == FileFormat::Qoi ? ImageEncode::WriteQoi(path, pixels, width, height, pitch)
+                                                                : ImageEncode::WritePng(path, pixels, width, height, pitch);
+    return written ? SaveResult::Saved : SaveResult::Failed;
+}
+
+void ScreenshotManager::StartSave(std::function<SaveResult(const std::filesystem::path &)> job) {
+    std::filesystem::path path = MakeFilePath();
+    saveJobs.push_back(std::async(std::launch::async, [job = std::move(job), path]() mutable {
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        switch (job(path)) {
+        case SaveResult::Saved:
+            Log::Debug("Saved screenshot to %s", path.string().c_str());
+            break;
+        case SaveResult::Skipped:
+            Log::Debug("Skipped saving a near-duplicate screenshot to %s", path.string().c_str());
+            break;
+        case SaveResult::Failed:
+            Log::Error("Failed to save screenshot to %s", path.string().c_str());
+            break;
+        }
+    }));
+}
\ No newline at end of file
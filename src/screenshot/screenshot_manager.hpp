@@ -0,0 +1,277 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <future>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+#include <functional>
+#include <windows.h>
+#include "gpu_resources.hpp"
+#include "image_diff.hpp"
+#include "widgets.hpp"
+#include "region_selector.hpp"
+#include "screenshot_history.hpp"
+#include "duplicate_index.hpp"
+#include "screen_recorder.hpp"
+#include "full_page_capture.hpp"
+#include "element_locator.hpp"
+
+// Owns the current screenshot: the full resolution CPU capture buffer (shared
+// with the clipboard and file saves) and a downscaled preview texture sized to
+// the Screenshot panel. Both are reused across captures and trimmed to a
+// memory budget when the panel closes.
+//
+// Capturing runs on a worker thread into the staging buffer. The result is
+// published by Update() on the render thread, which only uploads the texture.
+// Only the area of the capture mode is copied, so buffers are sized to it; in
+// Region mode the worker freezes all monitors and the user picks the area on
+// an overlay before anything is shown or saved.
+//
+// Every capture shown in the panel is also added to a tile-deduplicated
+// history, browsing it decodes the chosen entry into the capture buffer.
+// With change highlighting on, the shown capture is diffed on a worker against
+// the entry before it, or against the entry it was collapsed onto.
+//
+// In WebView mode the page is rendered by the browser itself (see
+// SetPageCapture) rather than read from the screen, so other windows on top
+// of it, or the whole window being hidden, do not matter. GDI remains the
+// fallback until the WebView is ready. Element mode asks the page for the
+// bounding box of a CSS selector, then converts only that part of the render
+// (or grabs only that area of the screen), so the capture buffer is element-sized.
+//
+// Near-duplicates, found by perceptual hash, are collapsed onto the existing
+// history entry and not written again by the capture hotkey.
+//
+// Screen recordings run independently of the shown capture, see ScreenRecorder.
+class ScreenshotManager {
+  public:
+    enum class FileFormat {
+        Png,
+        Qoi
+    };
+
+    struct Settings {
+        size_t memoryBudget = 0;             // Bytes kept for reuse while the panel is closed
+        std::filesystem::path saveDirectory; // Created on first save
+        FileFormat fileFormat = FileFormat::Png;
+        CaptureMode captureMode = CaptureMode::WebView;
+        size_t historyEntries = 0; // Captures kept for browsing, 0 disables the history
+        size_t historyBudget = 0;  // Compressed bytes the history may hold
+        ImageDiff::Options diffOptions;
+        int duplicateThreshold = -1; // Largest dHash distance of a near-duplicate, negative keeps every capture
+        int blurRadius = 12;         // Redaction strength, in capture pixels
+        int pixelateBlockSize = 16;
+        ScreenRecorder::Settings recording;
+        FullPageCapture::Settings fullPage;
+        std::string elementSelector; // Captured in Element mode
+    };
+
+    struct Stats {
+        uint64_t captures = 0;
+        uint64_t lastCaptureBytes = 0;   // Bytes newly allocated by the last capture
+        uint64_t totalAllocatedBytes = 0; // Bytes allocated over all captures
+        uint64_t textureReuses = 0;
+        uint64_t bufferReuses = 0;
+        double lastDiffMilliseconds = 0.0;
+        uint64_t lastDiffBytes = 0; // Read from both images by the last diff
+        size_t lastChangedTiles = 0;
+        uint64_t collapsedDuplicates = 0;   // Captures shown as an existing history entry
+        uint64_t skippedDuplicateSaves = 0; // Hotkey captures not written
+        double lastRedactMilliseconds = 0.0;
+        uint64_t lastRedactUploadPixels = 0; // Preview texels re-uploaded by the last redaction
+    };
+
+    // Starts rendering the page to PNG, the callback receives it (empty on failure).
+    // Returns false when nothing was started.
+    using PageCapture = std::function<bool(std::function<void(std::vector<unsigned char>)>)>;
+    // Runs a script in the page, the callback receives its JSON result and is not called on failure
+    using ScriptRunner = std::function<void(std::string, std::function<void(std::string)>)>;
+
+    ScreenshotManager(ID3D11Device *device, Settings settings);
+
+    // Windows the WebView and Window modes capture, the WebView may be null until it is created
+    void SetWindows(HWND window, HWND webview);
+    // Source of WebView mode captures, GDI is used while unset or when it fails to start
+    void SetPageCapture(PageCapture capture) { pageCapture = std::move(capture); }
+    void SetScriptRunner(ScriptRunner runner) { scriptRunner = std::move(runner); }
+    void SetCaptureMode(CaptureMode mode) { settings.captureMode = mode; }
+    CaptureMode GetCaptureMode() const { return settings.captureMode; }
+
+    void Capture();
+    void Capture(bool value);
+    void CopyToClipboard();
+    // Writes the current capture to a new file in the save directory, on a worker
+    void Save();
+    // Captures straight to a file without involving the panel, after a selection in Region mode
+    void CaptureToFile();
+    // Hides the image and frees whatever does not fit the memory budget
+    void Release();
+    // Shows the capture step entries older (negative) or newer than the current one
+    void ShowHistory(int step);
+    // Outlines what changed since the previous history entry
+    void SetHighlightChanges(bool value) { highlightChanges = value; }
+    void SetRedactTool(RedactTool tool) { redactTool = tool; }
+    // Blurs or pixelates an area of the current capture, in capture pixels, before it is copied or saved
+    void Redact(const RECT &area);
+    // Records the WebView area to an animated PNG in the save directory until stopped
+    void SetRecording(bool value);
+    ScreenRecorder::Stats GetRecordingStats() const { return recorder.GetStats(); }
+    // Scrolls the page top to bottom and saves the stitched viewports as one PNG
+    void CaptureFullPage();
+    const FullPageCapture::Stats &GetFullPageStats() const { return fullPage.GetStats(); }
+    void SetElementSelector(std::string selector) { settings.elementSelector = std::move(selector); }
+    const std::string &GetElementSelector() const { return settings.elementSelector; }
+    // Lets the user click the element to capture in the page, calling it again stops picking
+    void PickElement();
+    // Publishes a finished capture, call once per frame on the render thread
+    void Update();
+    // Area the preview is displayed in, in pixels. The preview is rebuilt when it changes noticeably.
+    void SetPreviewSize(int maxWidth, int maxHeight);
+
+    // True until the worker has copied the screen, UI drawn before then would
+    // end up in the screenshot
+    bool IsGrabbing() const { return pendingCapture.valid() && !grabbed; }
+    bool IsCapturing() const { return pendingCapture.valid(); }
+    // Call after presenting a frame drawn while IsGrabbing(), without the panel
+    // and the hole cut into the WebView for it. The worker reads the screen then.
+    void ScreenCleared();
+
+    ScreenshotImage GetImage() const;
+    // BGRA of a pixel of the shown capture, read from the full resolution buffer
+    std::optional<uint32_t> GetPixel(int x, int y) const;
+    const Stats &GetStats() const { return stats; }
+    ScreenshotHistory::Stats GetHistoryStats() const { return history.GetStats(); }
+    size_t GetRetainedBytes() const;
+
+  private:
+    struct Preview {
+        std::vector<BYTE> pixels; // BGRA
+        int width = 0;
+        int height = 0;
+        uint64_t imageId = 0; // Capture the preview was built from
+    };
+
+    struct CaptureResult {
+        bool success = false;
+        int width = 0;
+        int height = 0;
+        POINT origin = {}; // Screen position of the top-left pixel
+        std::shared_ptr<std::vector<BYTE>> pixels;
+        CaptureMode mode = CaptureMode::WebView; // Mode at the time of capture
+        uint64_t historyId = 0;                  // Set when decoded from the history
+        size_t allocatedBytes = 0;
+        Preview preview;
+    };
+
+    enum class SaveResult {
+        Saved,
+        Skipped,
+        Failed
+    };
+
+    struct HistoryResult {
+        uint64_t imageId = 0;
+        uint64_t historyId = 0;
+        bool collapsed = false; // Matched an existing entry instead of adding one
+    };
+
+    // An Element capture waiting for the page to report the element's bounds
+    struct ElementLookup {
+        std::future<std::string> bounds;
+        RECT webviewRect = {};
+        std::string selector;
+        std::shared_ptr<std::vector<BYTE>> target; // Capture buffer of a panel capture, null when saving to a file
+        std::chrono::steady_clock::time_point deadline;
+        std::optional<ElementLocator::Bounds> element; // Set once the bounds arrived
+        std::chrono::steady_clock::time_point readyAt; // The page has repainted after scrolling the element into view
+    };
+
+    struct DiffResult {
+        uint64_t imageId = 0;
+        std::vector<RECT> regions; // In capture pixels
+        double milliseconds = 0.0;
+        uint64_t bytes = 0;
+        size_t changedTiles = 0;
+    };
+
+    static Preview BuildPreview(const std::vector<BYTE> &pixels, int width, int height, int maxWidth, int maxHeight);
+    static void FitPreview(int width, int height, int maxWidth, int maxHeight, int &outWidth, int &outHeight);
+
+    RECT GetCaptureRect(CaptureMode mode) const;
+    static void CropInPlace(std::vector<BYTE> &pixels, int width, const RECT &rect);
+    void StartCapture(std::shared_ptr<std::vector<BYTE>> target);
+    CaptureResult CaptureScreen(std::shared_ptr<std::vector<BYTE>> target, const RECT &rect, CaptureMode mode,
+                                bool buildPreview, int maxWidth, int maxHeight, const std::shared_future<void> &cleared);
+    std::shared_future<void> BeginScreenGrab();
+    void StartElementLookup(std::shared_ptr<std::vector<BYTE>> target);
+    void UpdateElementLookups();
+    void CaptureElement(ElementLookup &lookup);
+    std::optional<std::future<std::vector<unsigned char>>> RequestPagePng();
+    std::future<std::string> RunScript(const std::string &script);
+    static bool DecodePagePng(std::future<std::vector<unsigned char>> &png, std::vector<BYTE> &pixels, int &width, int &height,
+                              const RECT *crop = nullptr);
+    void BeginSelection(const CaptureResult &result, bool toFile);
+    void StoreInHistory();
+    void StartDiff();
+    void SaveImage(std::shared_ptr<const std::vector<BYTE>> pixels, int width, int height, bool skipDuplicates);
+    void StartPreview();
+    void Publish(const CaptureResult &result);
+    void AcquireBuffer();
+    bool UploadTexture(const Preview &preview);
+    void UpdatePreviewArea(const RECT &area);
+    void Trim();
+    std::filesystem::path MakeFilePath(const char *extension = nullptr) const;
+    void StartSave(std::function<SaveResult(const std::filesystem::path &)> job);
+    SaveResult WriteFile(const std::filesystem::path &path, const BYTE *pixels, int width, int height, bool skipDuplicates);
+
+  private:
+    std::shared_ptr<std::vector<BYTE>> buffer; // Top-down BGRA, shared with the clipboard
+    int width = 0;
+    int height = 0;
+    bool hasImage = false;
+    uint64_t imageId = 0; // Bumped whenever the shown capture changes
+    uint64_t textureImageId = 0; // Capture the preview texture currently shows
+    uint64_t shownHistoryId = 0; // History entry of the shown capture, 0 until stored
+    bool shownCollapsed = false; // The shown capture matched shownHistoryId instead of being stored
+    bool discardPending = false;   // Panel closed while capturing
+    bool captureRequested = false; // Panel reopened while capturing
+    bool captureToFile = false;    // Running capture is a Region mode CaptureToFile
+    Settings settings;
+    Stats stats;
+    ComPtr<ID3D11Device> device;
+    ComPtr<ID3D11SamplerState> pointSampler; // Keeps pixels square in the zoomed loupe
+    HWND windowHwnd = nullptr;
+    HWND webviewHwnd = nullptr;
+    PageCapture pageCapture;
+    ScriptRunner scriptRunner;
+    RegionSelector selector;
+    ScreenshotHistory history;
+    DuplicateIndex savedImages; // Written by the hotkey, to skip repeats
+    std::atomic<uint64_t> skippedSaves = 0;
+    ScreenRecorder recorder;
+    FullPageCapture fullPage;
+    ElementLocator elementLocator;
+    std::vector<ElementLookup> elementLookups;
+    bool highlightChanges = false;
+    std::vector<RECT> changedRegions;
+    uint64_t diffImageId = 0; // Capture changedRegions belong to
+    RedactTool redactTool = RedactTool::None;
+    GpuTexture texture; // Preview, rewritten in place (whole or by tiles) while its size is unchanged
+    int textureWidth = 0;
+    int textureHeight = 0;
+    int previewMaxWidth = 640;
+    int previewMaxHeight = 400;
+
+    std::atomic<bool> grabbed = false;
+    std::optional<std::promise<void>> screenCleared; // Set by ScreenCleared() for the running capture
+    // Last members so their destructors wait for the workers before anything they use is destroyed
+    std::vector<std::future<void>> saveJobs;
+    std::future<HistoryResult> pendingHistory;
+    std::future<DiffResult> pendingDiff;
+    std::future<Preview> pendingPreview;
+    std::future<CaptureResult> pendingCapture;
+};
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "assets.hpp"
+#include "Log.hpp"
+#include <string>
+
+const Assets::Asset &Assets::Get(std::string_view name) {
+    for (size_t i = 0; i < embeddedCount; ++i) {
+        if (embedded[i].name == name) return embedded[i];
+    }
+
+    static const Asset missing = {};
+    Log::Error("Embedded asset not found: %s", std::string(name).c_str());
+    return missing;
+}
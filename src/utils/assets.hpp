@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+// Files compiled into the executable by embed_assets.cmake. Names are paths
+// relative to the project root, e.g. "icons/refresh.png".
+namespace Assets {
+
+struct Asset {
+    std::string_view name;
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+
+    bool empty() const { return data == nullptr || size == 0; }
+};
+
+// Returns an empty asset if no file with this name was embedded.
+const Asset &Get(std::string_view name);
+
+// Defined in the generated source
+extern const Asset embedded[];
+extern const size_t embeddedCount;
+
+} // namespace Assets
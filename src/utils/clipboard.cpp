@@ -0,0 +1,210 @@
+#include "clipboard.hpp"
+#include "utils.hpp"
+#include "pixel_convert.hpp"
+#include "Log.hpp"
+
+#include <cstring>
+#include <thread>
+
+HWND Clipboard::ownerHwnd = nullptr;
+UINT Clipboard::pngFormat = 0;
+Clipboard::Image Clipboard::image = {};
+std::shared_future<std::vector<unsigned char>> Clipboard::png = {};
+
+bool Clipboard::SetImage(Image newImage) {
+    if (newImage.width <= 0 || newImage.height <= 0 || !newImage.pixels ||
+        newImage.pixels->size() < static_cast<size_t>(newImage.width) * newImage.height * 4)
+        return false;
+
+    if (!ownerHwnd && !CreateOwnerWindow()) return false;
+
+    if (!OpenClipboard(ownerHwnd)) return false;
+    // Triggers WM_DESTROYCLIPBOARD for the previous image if we still own it
+    EmptyClipboard();
+
+    image = std::move(newImage);
+    // A detached worker rather than std::async, whose future would block in its
+    // destructor when the next copy replaces an unfinished encode
+    std::promise<std::vector<unsigned char>> encoded;
+    png = encoded.get_future().share();
+    std::thread([encoded = std::move(encoded), source = image]() mutable {
+        encoded.set_value(Utils::EncodePng(source.pixels->data(), source.width, source.height,
+                                           static_cast<size_t>(source.width) * 4));
+    }).detach();
+
+    // NULL data announces the format, it is rendered on WM_RENDERFORMAT.
+    // SetClipboardData then returns NULL on success too, so check the error code.
+    SetLastError(ERROR_SUCCESS);
+    SetClipboardData(CF_DIBV5, nullptr);
+    const bool announced = GetLastError() == ERROR_SUCCESS;
+    if (pngFormat != 0) SetClipboardData(pngFormat, nullptr);
+    // Announced explicitly so applications without alpha get a 24-bit DIB
+    // instead of the one Windows would synthesize from CF_DIBV5
+    SetClipboardData(CF_DIB, nullptr);
+    CloseClipboard();
+
+    if (!announced) ReleaseImage();
+    return announced;
+}
+
+void Clipboard::Shutdown() {
+    if (!ownerHwnd) return;
+    // Destroying the owner sends WM_RENDERALLFORMATS while it still owns the clipboard
+    DestroyWindow(ownerHwnd);
+    ownerHwnd = nullptr;
+    ReleaseImage();
+}
+
+bool Clipboard::CreateOwnerWindow() {
+    static constexpr wchar_t className[] = L"WebFrameClipboardOwner";
+
+    WNDCLASSEXW wc = {};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = WndProc;
+    wc.hInstance = GetModuleHandle(nullptr);
+    wc.lpszClassName = className;
+    RegisterClassExW(&wc);
+
+    // Message-only window, never shown
+    ownerHwnd = CreateWindowExW(0, className, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, wc.hInstance, nullptr);
+    if (!ownerHwnd) {
+        Log::Error("Failed to create clipboard owner window");
+        return false;
+    }
+
+    pngFormat = RegisterClipboardFormatW(L"PNG");
+    return true;
+}
+
+HANDLE Clipboard::RenderFormat(UINT format) {
+    if (!image.pixels) return nullptr;
+    if (format == CF_DIBV5) return RenderDibV5(image);
+    if (format == CF_DIB) return RenderDib(image);
+    if (format == pngFormat && pngFormat != 0) return RenderPng();
+    return nullptr;
+}
+
+// Bottom-up 32-bit DIB with an explicit alpha mask, copied row by row from the BGRA buffer
+HGLOBAL Clipboard::RenderDibV5(const Image &source) {
+    const size_t rowSize = static_cast<size_t>(source.width) * 4;
+    const size_t imageSize = rowSize * source.height;
+
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, sizeof(BITMAPV5HEADER) + imageSize);
+    if (!hMem) return nullptr;
+
+    BYTE *data = static_cast<BYTE *>(GlobalLock(hMem));
+    if (!data) {
+        GlobalFree(hMem);
+        return nullptr;
+    }
+
+    BITMAPV5HEADER header = {};
+    header.bV5Size = sizeof(BITMAPV5HEADER);
+    header.bV5Width = source.width;
+    header.bV5Height = source.height; // positive -> bottom-up, the most widely understood layout
+    header.bV5Planes = 1;
+    header.bV5BitCount = 32;
+    header.bV5Compression = BI_BITFIELDS;
+    header.bV5SizeImage = static_cast<DWORD>(imageSize);
+    header.bV5RedMask = 0x00FF0000;
+    header.bV5GreenMask = 0x0000FF00;
+    header.bV5BlueMask = 0x000000FF;
+    header.bV5AlphaMask = 0xFF000000;
+    header.bV5CSType = LCS_sRGB;
+    header.bV5Intent = LCS_GM_IMAGES;
+    std::memcpy(data, &header, sizeof(header));
+
+    BYTE *bits = data + sizeof(BITMAPV5HEADER);
+    const BYTE *src = source.pixels->data();
+    for (int y = 0; y < source.height; ++y) {
+        std::memcpy(bits + (source.height - 1 - y) * rowSize, src + y * rowSize, rowSize);
+    }
+
+    GlobalUnlock(hMem);
+    return hMem;
+}
+
+// Bottom-up 24-bit DIB, rows padded to 4 bytes, alpha dropped while flipping
+HGLOBAL Clipboard::RenderDib(const Image &source) {
+    const size_t rowSize = (static_cast<size_t>(source.width) * 3 + 3) & ~static_cast<size_t>(3);
+    const size_t imageSize = rowSize * source.height;
+
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE | GMEM_ZEROINIT, sizeof(BITMAPINFOHEADER) + imageSize);
+    if (!hMem) return nullptr;
+
+    BYTE *data = static_cast<BYTE *>(GlobalLock(hMem));
+    if (!data) {
+        GlobalFree(hMem);
+        return nullptr;
+    }
+
+    BITMAPINFOHEADER header = {};
+    header.biSize = sizeof(BITMAPINFOHEADER);
+    header.biWidth = source.width;
+    header.biHeight = source.height;
+    header.biPlanes = 1;
+    header.biBitCount = 24;
+    header.biCompression = BI_RGB;
+    header.biSizeImage = static_cast<DWORD>(imageSize);
+    std::memcpy(data, &header, sizeof(header));
+
+    PixelConvert::BGRAToBGRFlipped(source.pixels->data(), static_cast<size_t>(source.width) * 4,
+                                   data + sizeof(BITMAPINFOHEADER), rowSize, source.width, source.height);
+
+    GlobalUnlock(hMem);
+    return hMem;
+}
+
+HGLOBAL Clipboard::RenderPng() {
+    if (!png.valid()) return nullptr;
+    // Usually finished already, otherwise the pasting application waits for the worker
+    const std::vector<unsigned char> &encoded = png.get();
+    if (encoded.empty()) return nullptr;
+
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, encoded.size());
+    if (!hMem) return nullptr;
+
+    void *data = GlobalLock(hMem);
+    if (!data) {
+        GlobalFree(hMem);
+        return nullptr;
+    }
+    std::memcpy(data, encoded.data(), encoded.size());
+    GlobalUnlock(hMem);
+    return hMem;
+}
+
+void Clipboard::ReleaseImage() {
+    image = {};
+    png = {};
+}
+
+LRESULT CALLBACK Clipboard::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+    case WM_RENDERFORMAT: {
+        // The clipboard is already open by the requesting application
+        const UINT format = static_cast<UINT>(wParam);
+        HANDLE data = RenderFormat(format);
+        if (data && !SetClipboardData(format, data)) GlobalFree(data);
+        return 0;
+    }
+    case WM_RENDERALLFORMATS: {
+        if (!OpenClipboard(hWnd)) return 0;
+        // Another application may have taken ownership in the meantime
+        if (GetClipboardOwner() == hWnd) {
+            for (UINT format : {static_cast<UINT>(CF_DIBV5), pngFormat, static_cast<UINT>(CF_DIB)}) {
+                if (format == 0) continue;
+                HANDLE data = RenderFormat(format);
+                if (data && !SetClipboardData(format, data)) GlobalFree(data);
+            }
+        }
+        CloseClipboard();
+        return 0;
+    }
+    case WM_DESTROYCLIPBOARD:
+        // Someone else emptied the clipboard, the image is no longer needed
+        ReleaseImage();
+        return 0;
+    }
+    return DefWindowProcW(hWnd, msg, wParam, lParam);
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <future>
+#include <windows.h>
+
+// Places images on the clipboard with delayed rendering. Only the formats are
+// announced on copy, the data is produced when another application pastes.
+class Clipboard {
+  public:
+    struct Image {
+        int width = 0;
+        int height = 0;
+        // Top-down BGRA, shared with the owner so copying never duplicates it
+        std::shared_ptr<const std::vector<BYTE>> pixels;
+    };
+
+    /**
+     * @brief Announces CF_DIBV5, PNG and CF_DIB for the image and takes clipboard ownership.
+     *
+     * Must be called from the thread that pumps window messages. PNG encoding
+     * starts on a worker right away so it is usually done before a paste.
+     */
+    static bool SetImage(Image image);
+
+    /**
+     * @brief Renders any pending formats so they outlive the application, then
+     *        destroys the clipboard owner window.
+     */
+    static void Shutdown();
+
+  private:
+    static bool CreateOwnerWindow();
+    static HANDLE RenderFormat(UINT format);
+    static HGLOBAL RenderDibV5(const Image &source);
+    static HGLOBAL RenderDib(const Image &source);
+    static HGLOBAL RenderPng();
+    static void ReleaseImage();
+    static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+  private:
+    static HWND ownerHwnd;
+    static UINT pngFormat;
+    static Image image;
+    static std::shared_future<std::vector<unsigned char>> png;
+};
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "gpu_resources.hpp"
+#include "Log.hpp"
+
+#include <algorithm>
+
+std::mutex GpuResources::mutex;
+std::unordered_map<uint64_t, GpuResources::Entry> GpuResources::entries;
+uint64_t GpuResources::nextId = 1;
+size_t GpuResources::liveBytes = 0;
+size_t GpuResources::peakBytes = 0;
+ComPtr<IDXGIAdapter3> GpuResources::adapter;
+
+uint64_t GpuResources::Register(size_t bytes, const std::source_location &location) {
+    // Strip the directory, the file name is enough to find the call site
+    std::string_view file = location.file_name();
+    const size_t slash = file.find_last_of("/\\");
+    if (slash != std::string_view::npos) file.remove_prefix(slash + 1);
+
+    std::string site = std::string(file) + ":" + std::to_string(location.line()) +
+                       " (" + location.function_name() + ")";
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint64_t id = nextId++;
+    entries.emplace(id, Entry{id, bytes, std::move(site)});
+    liveBytes += bytes;
+    peakBytes = std::max(peakBytes, liveBytes);
+    return id;
+}
+
+void GpuResources::Unregister(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = entries.find(id);
+    if (it == entries.end()) return;
+    liveBytes -= it->second.bytes;
+    entries.erase(it);
+}
+
+size_t GpuResources::GetLiveBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return liveBytes;
+}
+
+size_t GpuResources::GetPeakBytes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peakBytes;
+}
+
+std::vector<GpuResources::Entry> GpuResources::GetLiveEntries() {
+    std::vector<Entry> live;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        live.reserve(entries.size());
+        for (const auto &[id, entry] : entries) live.push_back(entry);
+    }
+    std::sort(live.begin(), live.end(), [](const Entry &a, const Entry &b) { return a.id < b.id; });
+    return live;
+}
+
+void GpuResources::SetDevice(ID3D11Device *device) {
+    adapter.Reset();
+    if (device == nullptr) return;
+
+    ComPtr<IDXGIDevice> dxgiDevice;
+    ComPtr<IDXGIAdapter> dxgiAdapter;
+    if (FAILED(device->QueryInterface(IID_PPV_ARGS(&dxgiDevice)))) return;
+    if (FAILED(dxgiDevice->GetAdapter(&dxgiAdapter))) return;
+    // Not available before Windows 10, the diagnostics view then only shows tracked textures
+    dxgiAdapter.As(&adapter);
+}
+
+GpuResources::VideoMemoryInfo GpuResources::QueryVideoMemory() {
+    VideoMemoryInfo info;
+    if (adapter == nullptr) return info;
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo;
+    if (FAILED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo))) return info;
+
+    info.valid = true;
+    info.usage = memoryInfo.CurrentUsage;
+    info.budget = memoryInfo.Budget;
+    return info;
+}
+
+size_t GpuResources::ReportLeaks() {
+    const std::vector<Entry> live = GetLiveEntries();
+    for (const Entry &entry : live) {
+        Log::Warning("Leaked GPU texture #%llu (%zu bytes) created at %s",
+                     static_cast<unsigned long long>(entry.id), entry.bytes, entry.site.c_str());
+    }
+    if (!live.empty()) {
+        Log::Warning("%zu GPU texture(s) still alive at shutdown, %zu bytes", live.size(), GetLiveBytes());
+    }
+    return live.size();
+}
+
+GpuTexture::GpuTexture(ComPtr<ID3D11ShaderResourceView> view, size_t bytes, const std::source_location &location)
+    : view(std::move(view)), bytes(bytes) {
+    if (this->view) id = GpuResources::Register(bytes, location);
+}
+
+GpuTexture::GpuTexture(GpuTexture &&other) noexcept
+    : view(std::move(other.view)), bytes(other.bytes), id(other.id) {
+    other.bytes = 0;
+    other.id = 0;
+}
+
+GpuTexture &GpuTexture::operator=(GpuTexture &&other) noexcept {
+    if (this != &other) {
+        Reset();
+        view = std::move(other.view);
+        bytes = other.bytes;
+        id = other.id;
+        other.bytes = 0;
+        other.id = 0;
+    }
+    return *this;
+}
+
+void GpuTexture::Reset() {
+    if (id != 0) GpuResources::Unregister(id);
+    view.Reset();
+    bytes = 0;
+    id = 0;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <source_location>
+#include <unordered_map>
+#include <d3d11.h>
+#include <dxgi1_4.h>
+#include <wrl/client.h>
+#include "imgui.h"
+
+template <typename T>
+using ComPtr = Microsoft::WRL::ComPtr<T>;
+
+// Registry of live GPU textures, used for the diagnostics view and to report
+// textures still alive when the device is destroyed.
+class GpuResources {
+  public:
+    struct Entry {
+        uint64_t id;
+        size_t bytes;
+        std::string site; // "file:line (function)" of the creating call
+    };
+
+    struct VideoMemoryInfo {
+        bool valid = false;
+        uint64_t usage = 0;  // Process local video memory usage
+        uint64_t budget = 0; // Budget granted by the OS for this process
+    };
+
+    static uint64_t Register(size_t bytes, const std::source_location &location);
+    static void Unregister(uint64_t id);
+
+    static size_t GetLiveBytes();
+    static size_t GetPeakBytes();
+    static std::vector<Entry> GetLiveEntries();
+
+    // Set by the window once the device exists, cleared before it is destroyed
+    static void SetDevice(ID3D11Device *device);
+    static VideoMemoryInfo QueryVideoMemory();
+    // Logs every texture still registered, returns the number of leaks
+    static size_t ReportLeaks();
+
+  private:
+    static std::mutex mutex;
+    static std::unordered_map<uint64_t, Entry> entries;
+    static uint64_t nextId;
+    static size_t liveBytes;
+    static size_t peakBytes;
+    static ComPtr<IDXGIAdapter3> adapter;
+};
+
+// Move-only owner of a shader resource view, registered with GpuResources for
+// as long as it is alive.
+class GpuTexture {
+  public:
+    GpuTexture() = default;
+    GpuTexture(ComPtr<ID3D11ShaderResourceView> view, size_t bytes, const std::source_location &location);
+    ~GpuTexture() { Reset(); }
+
+    GpuTexture(const GpuTexture &) = delete;
+    GpuTexture &operator=(const GpuTexture &) = delete;
+    GpuTexture(GpuTexture &&other) noexcept;
+    GpuTexture &operator=(GpuTexture &&other) noexcept;
+
+    void Reset();
+    ID3D11ShaderResourceView *Get() const { return view.Get(); }
+    ImTextureID GetTextureId() const { return (ImTextureID)(intptr_t)view.Get(); }
+    size_t GetByteSize() const { return bytes; }
+    explicit operator bool() const { return view != nullptr; }
+
+  private:
+    ComPtr<ID3D11ShaderResourceView> view;
+    size_t bytes = 0;
+    uint64_t id = 0;
+};
\ No newline at end of file
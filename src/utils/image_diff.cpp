@@ -0,0 +1,253 @@
+#include "image_diff.hpp"
+#include "pixel_convert.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define IMAGE_DIFF_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+using RowKernel = bool (*)(const uint8_t *a, const uint8_t *b, size_t bytes, uint8_t tolerance);
+
+// ** =====> KERNELS <===== **
+
+bool RowDiffersScalar(const uint8_t *a, const uint8_t *b, size_t bytes, uint8_t tolerance) {
+    for (size_t i = 0; i < bytes; ++i) {
+        const int difference = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        if (difference > tolerance) return true;
+    }
+    return false;
+}
+
+#ifdef IMAGE_DIFF_X86
+
+// |a - b| with saturating subtractions, then minus the tolerance: any non-zero byte is a change
+TARGET_SSE2 bool RowDiffersSSE2(const uint8_t *a, const uint8_t *b, size_t bytes, uint8_t tolerance) {
+    const __m128i tol = _mm_set1_epi8(static_cast<char>(tolerance));
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        const __m128i difference = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        const __m128i excess = _mm_subs_epu8(difference, tol);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(excess, zero)) != 0xFFFF) return true;
+    }
+    return RowDiffersScalar(a + i, b + i, bytes - i, tolerance);
+}
+
+TARGET_AVX2 bool RowDiffersAVX2(const uint8_t *a, const uint8_t *b, size_t bytes, uint8_t tolerance) {
+    const __m256i tol = _mm256_set1_epi8(static_cast<char>(tolerance));
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        const __m256i difference = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+        const __m256i excess = _mm256_subs_epu8(difference, tol);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(excess, zero)) != -1) return true;
+    }
+    // The 16-byte step stays in this function, calling the SSE2 kernel would
+    // mix VEX and legacy encodings on every short tile segment
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        const __m128i difference = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        const __m128i excess = _mm_subs_epu8(difference, _mm256_castsi256_si128(tol));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(excess, _mm_setzero_si128())) != 0xFFFF) return true;
+    }
+    return RowDiffersScalar(a + i, b + i, bytes - i, tolerance);
+}
+
+#endif // IMAGE_DIFF_X86
+
+RowKernel SelectRowDiffers() {
+#ifdef IMAGE_DIFF_X86
+    switch (PixelConvert::GetActiveIsa()) {
+    case PixelConvert::Isa::AVX2: return RowDiffersAVX2;
+    case PixelConvert::Isa::SSSE3: return RowDiffersSSE2;
+    default: return RowDiffersScalar;
+    }
+#else
+    return RowDiffersScalar;
+#endif
+}
+
+// 64-bit words mixed into a row hash, equal rows always hash equal
+uint64_t HashRow(const uint8_t *row, size_t bytes) {
+    uint64_t hash = bytes;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, row + i, 8);
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < bytes; ++i) hash = (hash ^ row[i]) * 0x100000001B3ull;
+    return hash;
+}
+
+// ** =====> REGIONS <===== **
+
+bool Overlaps(const ImageDiff::Rect &a, const ImageDiff::Rect &b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+ImageDiff::Rect Union(const ImageDiff::Rect &a, const ImageDiff::Rect &b) {
+    const int left = std::min(a.x, b.x), top = std::min(a.y, b.y);
+    const int right = std::max(a.x + a.width, b.x + b.width), bottom = std::max(a.y + a.height, b.y + b.height);
+    return {left, top, right - left, bottom - top};
+}
+
+// Bounds of each 8-connected group of changed tiles, in tile units
+std::vector<ImageDiff::Rect> FindComponents(const std::vector<uint8_t> &mask, int columns, int rows) {
+    std::vector<ImageDiff::Rect> components;
+    std::vector<uint8_t> visited(mask.size(), 0);
+    std::vector<int> stack;
+
+    for (int start = 0; start < static_cast<int>(mask.size()); ++start) {
+        if (!mask[start] || visited[start]) continue;
+
+        int left = start % columns, right = left, top = start / columns, bottom = top;
+        visited[start] = 1;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            const int index = stack.back();
+            stack.pop_back();
+            const int x = index % columns, y = index / columns;
+            left = std::min(left, x);
+            right = std::max(right, x);
+            top = std::min(top, y);
+            bottom = std::max(bottom, y);
+
+            for (int ny = std::max(0, y - 1); ny <= std::min(rows - 1, y + 1); ++ny) {
+                for (int nx = std::max(0, x - 1); nx <= std::min(columns - 1, x + 1); ++nx) {
+                    const int neighbour = ny * columns + nx;
+                    if (mask[neighbour] && !visited[neighbour]) {
+                        visited[neighbour] = 1;
+                        stack.push_back(neighbour);
+                    }
+                }
+            }
+        }
+        components.push_back({left, top, right - left + 1, bottom - top + 1});
+    }
+    return components;
+}
+
+} // namespace
+
+bool ImageDiff::RowDiffers(const uint8_t *a, const uint8_t *b, size_t bytes, uint8_t tolerance) {
+    return SelectRowDiffers()(a, b, bytes, tolerance);
+}
+
+ImageDiff::Result ImageDiff::Compare(
+    const uint8_t *a, const uint8_t *b, int width, int height, size_t pitch, const Options &options
+) {
+    Result result;
+    if (!a || !b || width <= 0 || height <= 0) return result;
+
+    const int tileSize = std::max(1, options.tileSize);
+    result.tileSize = tileSize;
+    result.columns = (width + tileSize - 1) / tileSize;
+    result.rows = (height + tileSize - 1) / tileSize;
+    result.mask.assign(static_cast<size_t>(result.columns) * result.rows, 0);
+
+    // Resolve the kernel once rather than per segment
+    const RowKernel rowDiffers = SelectRowDiffers();
+    for (int tileY = 0; tileY < result.rows; ++tileY) {
+        uint8_t *maskRow = result.mask.data() + static_cast<size_t>(tileY) * result.columns;
+        const int firstRow = tileY * tileSize;
+        const int lastRow = std::min(height, firstRow + tileSize);
+        int unchanged = result.columns;
+
+        // Row by row so both images stream through the cache once, tiles
+        // already known to have changed are skipped
+        for (int y = firstRow; y < lastRow && unchanged > 0; ++y) {
+            const uint8_t *rowA = a + y * pitch;
+            const uint8_t *rowB = b + y * pitch;
+            for (int tileX = 0; tileX < result.columns; ++tileX) {
+                if (maskRow[tileX]) continue;
+                const int x = tileX * tileSize;
+                const size_t bytes = static_cast<size_t>(std::min(tileSize, width - x)) * 4;
+                if (rowDiffers(rowA + static_cast<size_t>(x) * 4, rowB + static_cast<size_t>(x) * 4, bytes, options.tolerance)) {
+                    maskRow[tileX] = 1;
+                    --unchanged;
+                }
+            }
+        }
+        result.changedTiles += result.columns - unchanged;
+    }
+
+    std::vector<Rect> regions = FindComponents(result.mask, result.columns, result.rows);
+
+    // Bounds of separate groups can still overlap (an L next to a dot), merge until disjoint
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < regions.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < regions.size(); ++j) {
+                if (Overlaps(regions[i], regions[j])) {
+                    regions[i] = Union(regions[i], regions[j]);
+                    regions.erase(regions.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Tile units to pixels, the last row and column are clipped to the image
+    for (Rect &region : regions) {
+        const int left = region.x * tileSize, top = region.y * tileSize;
+        const int right = std::min(width, (region.x + region.width) * tileSize);
+        const int bottom = std::min(height, (region.y + region.height) * tileSize);
+        result.regions.push_back({left, top, right - left, bottom - top});
+    }
+    return result;
+}
+
+int ImageDiff::FindVerticalShift(
+    const uint8_t *a, const uint8_t *b, int width, size_t pitch,
+    int top, int bottom, int hint, int maxShift, int minOverlap
+) {
+    if (!a || !b || width <= 0 || top < 0 || bottom <= top) return -1;
+    const int band = bottom - top;
+    maxShift = std::min(maxShift, band - std::max(1, minOverlap));
+    if (maxShift < 1) return -1;
+
+    const size_t bytes = static_cast<size_t>(width) * 4;
+    std::vector<uint64_t> hashesA(band), hashesB(band);
+    for (int y = 0; y < band; ++y) {
+        hashesA[y] = HashRow(a + (top + y) * pitch, bytes);
+        hashesB[y] = HashRow(b + (top + y) * pitch, bytes);
+    }
+
+    const RowKernel rowDiffers = SelectRowDiffers();
+    const auto matches = [&](int shift) {
+        const int overlap = band - shift;
+        if (!std::equal(hashesB.begin(), hashesB.begin() + overlap, hashesA.begin() + shift)) return false;
+        for (int y = top; y < top + overlap; ++y) {
+            if (rowDiffers(b + y * pitch, a + (y + shift) * pitch, bytes, 0)) return false;
+        }
+        return true;
+    };
+
+    // Outwards from the hint, each distance tried above then below it
+    hint = std::clamp(hint, 1, maxShift);
+    for (int distance = 0; hint - distance >= 1 || hint + distance <= maxShift; ++distance) {
+        if (hint + distance <= maxShift && matches(hint + distance)) return hint + distance;
+        if (distance > 0 && hint - distance >= 1 && matches(hint - distance)) return hint - distance;
+    }
+    return -1;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Change detection between two BGRA images of the same size. The image is
+// split into square tiles, a tile changed when any channel of any of its
+// pixels differs by more than the tolerance. The row kernel has scalar, SSE2
+// and AVX2 implementations, dispatched like PixelConvert.
+namespace ImageDiff {
+
+struct Options {
+    int tileSize = 16;
+    uint8_t tolerance = 0; // Largest per-channel difference still treated as equal, absorbs anti-aliasing noise
+};
+
+struct Rect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+struct Result {
+    int columns = 0;
+    int rows = 0;
+    int tileSize = 0;
+    std::vector<uint8_t> mask; // columns * rows, row-major, 1 where the tile changed
+    size_t changedTiles = 0;
+    std::vector<Rect> regions; // Non-overlapping bounds of changed tiles, in pixels
+};
+
+/**
+ * @brief Returns true if any byte of a and b differs by more than tolerance.
+ *
+ * Stops at the first difference.
+ */
+bool RowDiffers(const uint8_t *a, const uint8_t *b, size_t bytes, uint8_t tolerance);
+
+/**
+ * @brief Builds the tile change mask of two images and merges changed tiles into regions.
+ *
+ * Touching changed tiles (diagonals included) form one region, regions whose
+ * bounds overlap are merged until none do.
+ *
+ * @param pitch  Row size in bytes of both images.
+ */
+Result Compare(const uint8_t *a, const uint8_t *b, int width, int height, size_t pitch, const Options &options = {});
+
+/**
+ * @brief Finds how far b is scrolled down from a: the shift for which row y of
+ *        b equals row y + shift of a, for every row of the band both share.
+ *
+ * Only rows [top, bottom) take part, leaving out fixed headers and footers.
+ * Shifts are tried by distance from hint and the first exact match wins, so a
+ * hint from the scroll position settles repetitive content. Row hashes rule
+ * out most shifts, matches are confirmed with RowDiffers.
+ *
+ * @param minOverlap  Rows the band must still share at a shift for it to count.
+ * @return The shift, or -1 when none in [1, maxShift] matches.
+ */
+int FindVerticalShift(
+    const uint8_t *a, const uint8_t *b, int width, size_t pitch,
+    int top, int bottom, int hint, int maxShift, int minOverlap = 16
+);
+
+} // namespace ImageDiff
\ No newline at end of file
@@ -0,0 +1,705 @@
+#include "image_encode.hpp"
+#include "pixel_convert.hpp"
+
+#include <zlib.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// ** =====> OUTPUT <===== **
+
+// Buffered big-endian writer over an ofstream
+class FileWriter {
+  public:
+    explicit FileWriter(const std::filesystem::path &path) : file(path, std::ios::binary | std::ios::trunc) {
+        buffer.reserve(bufferSize);
+    }
+    ~FileWriter() { Flush(); }
+
+    bool IsOpen() const { return file.is_open(); }
+    bool Good() const { return file.good(); }
+
+    void Write(const void *data, size_t size) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        position += size;
+        if (buffer.size() + size > bufferSize) Flush();
+        if (size >= bufferSize) {
+            file.write(reinterpret_cast<const char *>(bytes), static_cast<std::streamsize>(size));
+            return;
+        }
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    void WriteU8(uint8_t value) { Write(&value, 1); }
+
+    void WriteU32(uint32_t value) {
+        const uint8_t bytes[4] = {
+            static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)
+        };
+        Write(bytes, 4);
+    }
+
+    void Flush() {
+        if (buffer.empty()) return;
+        file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+    // Bytes written so far, the offset of the next write
+    uint64_t Tell() const { return position; }
+
+    // Overwrites bytes already written, then continues at the end
+    void Patch(uint64_t offset, const void *data, size_t size) {
+        Flush();
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+        file.seekp(0, std::ios::end);
+    }
+
+  private:
+    static constexpr size_t bufferSize = 64 * 1024;
+    std::ofstream file;
+    std::vector<uint8_t> buffer;
+    uint64_t position = 0;
+};
+
+void StoreU32(uint8_t *out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+// ** =====> PNG <===== **
+
+void WritePngChunk(FileWriter &out, const char type[4], const uint8_t *data, size_t size) {
+    out.WriteU32(static_cast<uint32_t>(size));
+    out.Write(type, 4);
+    if (size > 0) out.Write(data, size);
+
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef *>(type), 4);
+    if (size > 0) crc = crc32_z(crc, data, size);
+    out.WriteU32(static_cast<uint32_t>(crc));
+}
+
+// Signature and IHDR of an 8-bit RGBA image
+void WritePngHeader(FileWriter &out, int width, int height) {
+    constexpr uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.Write(signature, sizeof(signature));
+
+    uint8_t ihdr[13] = {
+        0, 0, 0, 0, 0, 0, 0, 0,
+        8, // Bit depth
+        6, // Colour type RGBA
+        0, 0, 0 // Deflate, adaptive filtering, no interlace
+    };
+    StoreU32(ihdr, static_cast<uint32_t>(width));
+    StoreU32(ihdr + 4, static_cast<uint32_t>(height));
+    WritePngChunk(out, "IHDR", ihdr, sizeof(ihdr));
+}
+
+uint8_t Paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    if (pb <= pc) return static_cast<uint8_t>(b);
+    return static_cast<uint8_t>(c);
+}
+
+// Filters one RGBA row into out (filter byte + data), choosing the filter with
+// the smallest sum of absolute signed residuals, as libpng's heuristic does
+void FilterRow(const uint8_t *row, const uint8_t *previous, size_t rowSize, uint8_t *out, std::vector<uint8_t> &scratch) {
+    constexpr int bpp = 4;
+    scratch.resize(rowSize * 4);
+    uint8_t *candidates[4] = {scratch.data(), scratch.data() + rowSize, scratch.data() + rowSize * 2, scratch.data() + rowSize * 3};
+    uint64_t costs[4] = {};
+
+    for (size_t i = 0; i < rowSize; ++i) {
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = previous ? previous[i] : 0;
+        const int c = (previous && i >= bpp) ? previous[i - bpp] : 0;
+        const uint8_t x = row[i];
+
+        const uint8_t residuals[4] = {
+            x,
+            static_cast<uint8_t>(x - a),
+            static_cast<uint8_t>(x - b),
+            static_cast<uint8_t>(x - Paeth(a, b, c)),
+        };
+        for (int f = 0; f < 4; ++f) {
+            candidates[f][i] = residuals[f];
+            costs[f] += static_cast<uint64_t>(std::abs(static_cast<int8_t>(residuals[f])));
+        }
+    }
+
+    // Filter types: 0 None, 1 Sub, 2 Up, 4 Paeth
+    constexpr uint8_t filterTypes[4] = {0, 1, 2, 4};
+    const int best = static_cast<int>(std::min_element(costs, costs + 4) - costs);
+    out[0] = filterTypes[best];
+    std::memcpy(out + 1, candidates[best], rowSize);
+}
+
+// zlib header: deflate with a 32 KB window, FLEVEL from the compression level
+void MakeZlibHeader(int level, uint8_t out[2]) {
+    const uint8_t cmf = 0x78;
+    uint8_t flg = static_cast<uint8_t>((level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6);
+    flg += static_cast<uint8_t>(31 - ((cmf * 256 + flg) % 31));
+    out[0] = cmf;
+    out[1] = flg;
+}
+
+struct PngImage {
+    const uint8_t *bgra;
+    int width;
+    int height;
+    size_t pitch;
+};
+
+// Filtered scanlines [first, last) in PNG byte order (RGBA)
+std::vector<uint8_t> FilterRows(const PngImage &image, int first, int last) {
+    const size_t rowSize = static_cast<size_t>(image.width) * 4;
+    std::vector<uint8_t> filtered((rowSize + 1) * (last - first));
+    std::vector<uint8_t> current(rowSize), previous(rowSize), scratch;
+
+    if (first > 0) {
+        PixelConvert::SwapRedBlue(image.bgra + (first - 1) * image.pitch, previous.data(), image.width);
+    }
+    for (int y = first; y < last; ++y) {
+        PixelConvert::SwapRedBlue(image.bgra + y * image.pitch, current.data(), image.width);
+        FilterRow(current.data(), y > 0 ? previous.data() : nullptr, rowSize,
+                  filtered.data() + (rowSize + 1) * (y - first), scratch);
+        std::swap(current, previous);
+    }
+    return filtered;
+}
+
+struct DeflatedChunk {
+    bool success = false;
+    std::vector<uint8_t> data;
+    uLong adler = 1;
+    size_t inputSize = 0;
+};
+
+DeflatedChunk DeflateRows(const PngImage &image, int first, int last, int level) {
+    constexpr size_t windowSize = 32 * 1024;
+    const size_t lineSize = static_cast<size_t>(image.width) * 4 + 1;
+    const bool isFinal = last == image.height;
+
+    DeflatedChunk chunk;
+    const std::vector<uint8_t> input = FilterRows(image, first, last);
+    chunk.inputSize = input.size();
+    chunk.adler = adler32_z(1L, input.data(), input.size());
+
+    z_stream stream = {};
+    // Negative window bits: raw deflate, the zlib header and trailer are written once by the caller
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return chunk;
+
+    if (first > 0) {
+        // Re-filter just enough preceding rows to prime the dictionary, filtering is deterministic
+        const int dictionaryRows = static_cast<int>((windowSize + lineSize - 1) / lineSize);
+        const std::vector<uint8_t> preceding = FilterRows(image, std::max(0, first - dictionaryRows), first);
+        const size_t dictionarySize = std::min(windowSize, preceding.size());
+        deflateSetDictionary(&stream, preceding.data() + preceding.size() - dictionarySize, static_cast<uInt>(dictionarySize));
+    }
+
+    chunk.data.resize(deflateBound(&stream, static_cast<uLong>(input.size())) + 16);
+    stream.next_in = const_cast<Bytef *>(input.data());
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = chunk.data.data();
+    stream.avail_out = static_cast<uInt>(chunk.data.size());
+
+    // A sync flush ends the chunk on a byte boundary so the next chunk's blocks follow directly
+    const int result = deflate(&stream, isFinal ? Z_FINISH : Z_SYNC_FLUSH);
+    chunk.success = isFinal ? result == Z_STREAM_END : result == Z_OK && stream.avail_in == 0;
+    chunk.data.resize(stream.total_out);
+    deflateEnd(&stream);
+    return chunk;
+}
+
+// ** =====> QOI <===== **
+
+constexpr uint8_t QOI_OP_INDEX = 0x00;
+constexpr uint8_t QOI_OP_DIFF = 0x40;
+constexpr uint8_t QOI_OP_LUMA = 0x80;
+constexpr uint8_t QOI_OP_RUN = 0xC0;
+constexpr uint8_t QOI_OP_RGB = 0xFE;
+constexpr uint8_t QOI_OP_RGBA = 0xFF;
+
+struct QoiPixel {
+    uint8_t r, g, b, a;
+    bool operator==(const QoiPixel &other) const = default;
+};
+
+inline int QoiHash(const QoiPixel &px) {
+    return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+}
+
+// QOI op stream state, fed one row at a time
+class QoiEncoder {
+  public:
+    void EncodeRow(const uint8_t *row, int width, std::vector<uint8_t> &ops) {
+        for (int x = 0; x < width; ++x) {
+            const uint8_t *p = row + static_cast<size_t>(x) * 4;
+            const QoiPixel px = {p[2], p[1], p[0], p[3]};
+
+            if (px == previous) {
+                if (++run == 62) {
+                    ops.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                ops.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+                run = 0;
+            }
+
+            const int hash = QoiHash(px);
+            if (index[hash] == px) {
+                ops.push_back(static_cast<uint8_t>(QOI_OP_INDEX | hash));
+            } else {
+                index[hash] = px;
+
+                if (px.a == previous.a) {
+                    const int8_t dr = static_cast<int8_t>(px.r - previous.r);
+                    const int8_t dg = static_cast<int8_t>(px.g - previous.g);
+                    const int8_t db = static_cast<int8_t>(px.b - previous.b);
+                    const int8_t drDg = static_cast<int8_t>(dr - dg);
+                    const int8_t dbDg = static_cast<int8_t>(db - dg);
+
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        ops.push_back(static_cast<uint8_t>(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                    } else if (dg >= -32 && dg <= 31 && drDg >= -8 && drDg <= 7 && dbDg >= -8 && dbDg <= 7) {
+                        ops.push_back(static_cast<uint8_t>(QOI_OP_LUMA | (dg + 32)));
+                        ops.push_back(static_cast<uint8_t>((drDg + 8) << 4 | (dbDg + 8)));
+                    } else {
+                        ops.insert(ops.end(), {QOI_OP_RGB, px.r, px.g, px.b});
+                    }
+                } else {
+                    ops.insert(ops.end(), {QOI_OP_RGBA, px.r, px.g, px.b, px.a});
+                }
+            }
+            previous = px;
+        }
+    }
+
+    // Closes a pending run, call after the last row
+    void Finish(std::vector<uint8_t> &ops) {
+        if (run > 0) ops.push_back(static_cast<uint8_t>(QOI_OP_RUN | (run - 1)));
+        run = 0;
+    }
+
+  private:
+    QoiPixel index[64] = {};
+    QoiPixel previous = {0, 0, 0, 255};
+    int run = 0;
+};
+
+} // namespace
+
+bool ImageEncode::WritePng(
+    const std::filesystem::path &path, const uint8_t *bgra,
+    int width, int height, size_t pitch, int level
+) {
+    if (!bgra || width <= 0 || height <= 0) return false;
+    level = std::clamp(level, 1, 9);
+
+    FileWriter out(path);
+    if (!out.IsOpen()) return false;
+
+    WritePngHeader(out, width, height);
+
+    uint8_t zlibHeader[2];
+    MakeZlibHeader(level, zlibHeader);
+    WritePngChunk(out, "IDAT", zlibHeader, sizeof(zlibHeader));
+
+    // Row chunks of about 256 KB of scanline data, the unit of parallel work
+    const PngImage image = {bgra, width, height, pitch};
+    const size_t lineSize = static_cast<size_t>(width) * 4 + 1;
+    const int rowsPerChunk = std::max(1, static_cast<int>((256 * 1024) / lineSize));
+    const size_t maxInFlight = std::max(2u, std::thread::hardware_concurrency()) * 2;
+
+    // Chunks are compressed ahead on workers and written in order, at most
+    // maxInFlight compressed chunks are held in memory at a time
+    std::deque<std::future<DeflatedChunk>> inFlight;
+    int nextRow = 0;
+    uLong adler = 1;
+    bool success = true;
+
+    while ((success && nextRow < height) || !inFlight.empty()) {
+        // After a failure only the chunks already queued are drained
+        while (success && nextRow < height && inFlight.size() < maxInFlight) {
+            const int first = nextRow;
+            const int last = std::min(height, first + rowsPerChunk);
+            inFlight.push_back(std::async(std::launch::async, DeflateRows, image, first, last, level));
+            nextRow = last;
+        }
+
+        DeflatedChunk chunk = inFlight.front().get();
+        inFlight.pop_front();
+        if (!chunk.success) {
+            success = false;
+            continue; // Drain the remaining workers
+        }
+        if (!success) continue;
+
+        adler = adler32_combine(adler, chunk.adler, static_cast<z_off_t>(chunk.inputSize));
+        if (!chunk.data.empty()) WritePngChunk(out, "IDAT", chunk.data.data(), chunk.data.size());
+    }
+    if (!success) return false;
+
+    const uint8_t trailer[4] = {
+        static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16),
+        static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler)
+    };
+    WritePngChunk(out, "IDAT", trailer, sizeof(trailer));
+    WritePngChunk(out, "IEND", nullptr, 0);
+
+    out.Flush();
+    return out.Good();
+}
+
+bool ImageEncode::WriteQoi(
+    const std::filesystem::path &path, const uint8_t *bgra,
+    int width, int height, size_t pitch
+) {
+    if (!bgra || width <= 0 || height <= 0) return false;
+
+    FileWriter out(path);
+    if (!out.IsOpen()) return false;
+
+    out.Write("qoif", 4);
+    out.WriteU32(static_cast<uint32_t>(width));
+    out.WriteU32(static_cast<uint32_t>(height));
+    out.WriteU8(4); // Channels
+    out.WriteU8(0); // sRGB with linear alpha
+
+    QoiEncoder encoder;
+
+    // Ops for one row are staged in a small buffer, far cheaper than per-byte writes
+    std::vector<uint8_t> ops;
+    ops.reserve(static_cast<size_t>(width) * 5 + 1);
+
+    for (int y = 0; y < height; ++y) {
+        ops.clear();
+        encoder.EncodeRow(bgra + y * pitch, width, ops);
+        out.Write(ops.data(), ops.size());
+    }
+    ops.clear();
+    encoder.Finish(ops);
+    out.Write(ops.data(), ops.size());
+
+    constexpr uint8_t endMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    out.Write(endMarker, sizeof(endMarker));
+
+    out.Flush();
+    return out.Good();
+}
+
+std::vector<uint8_t> ImageEncode::EncodeQoi(const uint8_t *bgra, int width, int height, size_t pitch) {
+    std::vector<uint8_t> ops;
+    if (!bgra || width <= 0 || height <= 0) return ops;
+
+    QoiEncoder encoder;
+    for (int y = 0; y < height; ++y) {
+        encoder.EncodeRow(bgra + y * pitch, width, ops);
+    }
+    encoder.Finish(ops);
+    ops.shrink_to_fit();
+    return ops;
+}
+
+bool ImageEncode::DecodeQoi(const uint8_t *data, size_t size, uint8_t *bgra, int width, int height, size_t pitch) {
+    if (!data || !bgra || width <= 0 || height <= 0) return false;
+
+    QoiPixel index[64] = {};
+    QoiPixel px = {0, 0, 0, 255};
+    int run = 0;
+    size_t pos = 0;
+
+    for (int y = 0; y < height; ++y) {
+        uint8_t *row = bgra + y * pitch;
+        for (int x = 0; x < width; ++x) {
+            if (run > 0) {
+                --run;
+            } else {
+                if (pos >= size) return false;
+                const uint8_t op = data[pos++];
+
+                if (op == QOI_OP_RGB) {
+                    if (size - pos < 3) return false;
+                    px.r = data[pos];
+                    px.g = data[pos + 1];
+                    px.b = data[pos + 2];
+                    pos += 3;
+                } else if (op == QOI_OP_RGBA) {
+                    if (size - pos < 4) return false;
+                    px = {data[pos], data[pos + 1], data[pos + 2], data[pos + 3]};
+                    pos += 4;
+                } else if ((op & 0xC0) == QOI_OP_INDEX) {
+                    px = index[op];
+                } else if ((op & 0xC0) == QOI_OP_DIFF) {
+                    px.r = static_cast<uint8_t>(px.r + ((op >> 4) & 0x03) - 2);
+                    px.g = static_cast<uint8_t>(px.g + ((op >> 2) & 0x03) - 2);
+                    px.b = static_cast<uint8_t>(px.b + (op & 0x03) - 2);
+                } else if ((op & 0xC0) == QOI_OP_LUMA) {
+                    if (pos >= size) return false;
+                    const uint8_t next = data[pos++];
+                    const int dg = (op & 0x3F) - 32;
+                    px.r = static_cast<uint8_t>(px.r + dg - 8 + ((next >> 4) & 0x0F));
+                    px.g = static_cast<uint8_t>(px.g + dg);
+                    px.b = static_cast<uint8_t>(px.b + dg - 8 + (next & 0x0F));
+                } else {
+                    run = op & 0x3F; // QOI_OP_RUN, this pixel is the first of the run
+                }
+                index[QoiHash(px)] = px;
+            }
+
+            uint8_t *p = row + static_cast<size_t>(x) * 4;
+            p[0] = px.b;
+            p[1] = px.g;
+            p[2] = px.r;
+            p[3] = px.a;
+        }
+    }
+    return true;
+}
+
+// ** =====> APNG <===== **
+
+struct ImageEncode::ApngWriter::State {
+    struct Frame {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        uint32_t time = 0;
+        std::vector<uint8_t> data; // zlib stream after 4 bytes reserved for the fdAT sequence number
+    };
+
+    explicit State(const std::filesystem::path &path) : out(path) {}
+
+    FileWriter out;
+    int width = 0;
+    int height = 0;
+    int level = 6;
+    uint64_t actlOffset = 0; // File offset of the acTL chunk
+    uint32_t frames = 0;
+    uint32_t sequence = 0; // Shared by fcTL and fdAT chunks
+    bool hasPending = false;
+    Frame pending;
+
+    bool Compress(const uint8_t *bgra, size_t pitch, int frameWidth, int frameHeight, std::vector<uint8_t> &data) const {
+        const DeflatedChunk chunk = DeflateRows({bgra, frameWidth, frameHeight, pitch}, 0, frameHeight, level);
+        if (!chunk.success) return false;
+
+        data.resize(4 + 2 + chunk.data.size() + 4);
+        MakeZlibHeader(level, data.data() + 4);
+        std::memcpy(data.data() + 6, chunk.data.data(), chunk.data.size());
+        StoreU32(data.data() + data.size() - 4, static_cast<uint32_t>(chunk.adler));
+        return true;
+    }
+
+    void WriteFrame(Frame &frame, uint32_t duration) {
+        uint8_t fctl[26];
+        StoreU32(fctl, sequence++);
+        StoreU32(fctl + 4, static_cast<uint32_t>(frame.width));
+        StoreU32(fctl + 8, static_cast<uint32_t>(frame.height));
+        StoreU32(fctl + 12, static_cast<uint32_t>(frame.x));
+        StoreU32(fctl + 16, static_cast<uint32_t>(frame.y));
+        // Delay in milliseconds, a longer still frame is cut short at about 65 seconds
+        const uint16_t delay = static_cast<uint16_t>(std::min<uint32_t>(duration, 0xFFFF));
+        fctl[20] = static_cast<uint8_t>(delay >> 8);
+        fctl[21] = static_cast<uint8_t>(delay);
+        fctl[22] = 1000 >> 8;
+        fctl[23] = 1000 & 0xFF;
+        fctl[24] = 0; // APNG_DISPOSE_OP_NONE
+        fctl[25] = 0; // APNG_BLEND_OP_SOURCE
+        WritePngChunk(out, "fcTL", fctl, sizeof(fctl));
+
+        // The first frame is the default image, later ones carry a sequence number
+        if (frames == 0) {
+            WritePngChunk(out, "IDAT", frame.data.data() + 4, frame.data.size() - 4);
+        } else {
+            StoreU32(frame.data.data(), sequence++);
+            WritePngChunk(out, "fdAT", frame.data.data(), frame.data.size());
+        }
+        ++frames;
+    }
+};
+
+ImageEncode::ApngWriter::ApngWriter() = default;
+
+ImageEncode::ApngWriter::~ApngWriter() {
+    if (state) Finish(state->hasPending ? state->pending.time : 0);
+}
+
+bool ImageEncode::ApngWriter::Open(const std::filesystem::path &path, int width, int height, int level) {
+    if (width <= 0 || height <= 0) return false;
+
+    state = std::make_unique<State>(path);
+    if (!state->out.IsOpen()) {
+        state.reset();
+        return false;
+    }
+    state->width = width;
+    state->height = height;
+    state->level = std::clamp(level, 1, 9);
+
+    WritePngHeader(state->out, width, height);
+    // Frame count patched by Finish(), 0 plays loops forever
+    state->actlOffset = state->out.Tell();
+    const uint8_t actl[8] = {};
+    WritePngChunk(state->out, "acTL", actl, sizeof(actl));
+    return state->out.Good();
+}
+
+bool ImageEncode::ApngWriter::AddFrame(const uint8_t *bgra, size_t pitch, int x, int y, int width, int height, uint32_t time) {
+    if (!state || !bgra || width <= 0 || height <= 0 || x < 0 || y < 0 || x + width > state->width || y + height > state->height) return false;
+    // The default image must cover the canvas
+    if (state->frames == 0 && !state->hasPending && (x != 0 || y != 0 || width != state->width || height != state->height)) return false;
+
+    State::Frame frame = {.x = x, .y = y, .width = width, .height = height, .time = time, .data = {}};
+    // Reuse the previous frame's storage once it is written
+    if (state->hasPending) {
+        state->WriteFrame(state->pending, time - state->pending.time);
+        frame.data = std::move(state->pending.data);
+    }
+    state->hasPending = state->Compress(bgra, pitch, width, height, frame.data);
+    state->pending = std::move(frame);
+    return state->hasPending && state->out.Good();
+}
+
+bool ImageEncode::ApngWriter::Finish(uint32_t endTime) {
+    if (!state) return false;
+
+    if (state->hasPending) state->WriteFrame(state->pending, endTime - std::min(endTime, state->pending.time));
+    WritePngChunk(state->out, "IEND", nullptr, 0);
+
+    uint8_t actl[12] = {};
+    std::memcpy(actl, "acTL", 4);
+    StoreU32(actl + 4, state->frames);
+    const uint32_t crc = static_cast<uint32_t>(crc32(0L, actl, sizeof(actl)));
+    uint8_t crcBytes[4];
+    StoreU32(crcBytes, crc);
+    // Length and type are unchanged, only the data and CRC follow them
+    state->out.Patch(state->actlOffset + 8, actl + 4, 8);
+    state->out.Patch(state->actlOffset + 16, crcBytes, 4);
+
+    const bool success = state->frames > 0 && state->out.Good();
+    state.reset();
+    return success;
+}
+
+uint64_t ImageEncode::ApngWriter::GetBytesWritten() const {
+    return state ? state->out.Tell() : 0;
+}
+
+// ** =====> STREAMED PNG <===== **
+
+struct ImageEncode::PngStreamWriter::State {
+    explicit State(const std::filesystem::path &path) : out(path) {}
+    ~State() {
+        if (deflating) deflateEnd(&stream);
+    }
+
+    FileWriter out;
+    z_stream stream = {};
+    bool deflating = false;
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> current, previous; // RGBA rows
+    std::vector<uint8_t> filtered, scratch;
+    std::vector<uint8_t> output; // Deflated bytes, written as one IDAT whenever full
+
+    // Deflates the input set on stream, writing every filled output buffer
+    bool Deflate(int flush) {
+        do {
+            stream.next_out = output.data();
+            stream.avail_out = static_cast<uInt>(output.size());
+            const int result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) return false;
+            const size_t produced = output.size() - stream.avail_out;
+            if (produced > 0) WritePngChunk(out, "IDAT", output.data(), produced);
+            if (result == Z_STREAM_END) break;
+        } while (stream.avail_out == 0 || flush == Z_FINISH);
+        return out.Good();
+    }
+};
+
+ImageEncode::PngStreamWriter::PngStreamWriter() = default;
+ImageEncode::PngStreamWriter::~PngStreamWriter() = default;
+
+bool ImageEncode::PngStreamWriter::Open(const std::filesystem::path &path, int width, int level) {
+    if (width <= 0) return false;
+
+    state = std::make_unique<State>(path);
+    if (!state->out.IsOpen() || deflateInit(&state->stream, std::clamp(level, 1, 9)) != Z_OK) {
+        state.reset();
+        return false;
+    }
+    state->deflating = true;
+    state->width = width;
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    state->current.resize(rowSize);
+    state->previous.resize(rowSize);
+    state->output.resize(256 * 1024);
+
+    // Height 0 for now, patched by Finish()
+    WritePngHeader(state->out, width, 0);
+    return state->out.Good();
+}
+
+bool ImageEncode::PngStreamWriter::AddRows(const uint8_t *bgra, size_t pitch, int rows) {
+    if (!state || !bgra || rows < 0) return false;
+
+    const size_t rowSize = static_cast<size_t>(state->width) * 4;
+    state->filtered.resize((rowSize + 1) * rows);
+    for (int y = 0; y < rows; ++y) {
+        PixelConvert::SwapRedBlue(bgra + y * pitch, state->current.data(), state->width);
+        FilterRow(state->current.data(), state->height + y > 0 ? state->previous.data() : nullptr, rowSize,
+                  state->filtered.data() + (rowSize + 1) * y, state->scratch);
+        std::swap(state->current, state->previous);
+    }
+    state->height += rows;
+
+    state->stream.next_in = state->filtered.data();
+    state->stream.avail_in = static_cast<uInt>(state->filtered.size());
+    return state->Deflate(Z_NO_FLUSH);
+}
+
+bool ImageEncode::PngStreamWriter::Finish() {
+    if (!state) return false;
+
+    state->stream.next_in = nullptr;
+    state->stream.avail_in = 0;
+    bool success = state->height > 0 && state->Deflate(Z_FINISH);
+    WritePngChunk(state->out, "IEND", nullptr, 0);
+
+    // IHDR data starts after the signature, length and type, the CRC follows its 13 bytes
+    uint8_t ihdr[17] = {'I', 'H', 'D', 'R', 0, 0, 0, 0, 0, 0, 0, 0, 8, 6, 0, 0, 0};
+    StoreU32(ihdr + 4, static_cast<uint32_t>(state->width));
+    StoreU32(ihdr + 8, static_cast<uint32_t>(state->height));
+    uint8_t patch[17];
+    std::memcpy(patch, ihdr + 4, 13);
+    StoreU32(patch + 13, static_cast<uint32_t>(crc32(0L, ihdr, sizeof(ihdr))));
+    state->out.Patch(16, patch, sizeof(patch));
+
+    success = success && state->out.Good();
+    state.reset();
+    return success;
+}
+
+int ImageEncode::PngStreamWriter::GetHeight() const {
+    return state ? state->height : 0;
+}
\ No newline at end of file
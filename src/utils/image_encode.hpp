@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+// Lossless image file writers for 8-bit BGRA input (alpha last). Output is
+// streamed to the file as it is produced, so no second full-size copy of the
+// image is held in memory.
+namespace ImageEncode {
+
+/**
+ * @brief Writes a PNG, deflating row chunks in parallel across all cores.
+ *
+ * Each chunk is compressed as an independent raw deflate stream primed with
+ * the previous chunk's last 32 KB as dictionary and ends on a byte boundary
+ * (sync flush), so the concatenation is one valid zlib stream (pigz-style).
+ *
+ * @param pitch  Source row size in bytes.
+ * @param level  zlib compression level, 1 (fastest) to 9.
+ */
+bool WritePng(
+    const std::filesystem::path &path, const uint8_t *bgra,
+    int width, int height, size_t pitch, int level = 6
+);
+
+/**
+ * @brief Writes a QOI ("Quite OK Image") file, a single fast linear pass.
+ */
+bool WriteQoi(
+    const std::filesystem::path &path, const uint8_t *bgra,
+    int width, int height, size_t pitch
+);
+
+/**
+ * @brief Encodes to a bare QOI op stream, without file header or end marker.
+ *
+ * Used as a fast in-memory codec, DecodeQoi() reverses it given the same size.
+ */
+std::vector<uint8_t> EncodeQoi(const uint8_t *bgra, int width, int height, size_t pitch);
+bool DecodeQoi(const uint8_t *data, size_t size, uint8_t *bgra, int width, int height, size_t pitch);
+
+/**
+ * @brief Writes a PNG of unknown height, rows are appended in strips.
+ *
+ * Rows are filtered and deflated as they arrive and written out as IDAT chunks,
+ * so only the previous row and the compressor's window are kept. The height in
+ * IHDR is patched by Finish().
+ */
+class PngStreamWriter {
+  public:
+    PngStreamWriter();
+    ~PngStreamWriter();
+
+    bool Open(const std::filesystem::path &path, int width, int level = 6);
+    // Appends rows of the image's width
+    bool AddRows(const uint8_t *bgra, size_t pitch, int rows);
+    bool Finish();
+    int GetHeight() const;
+
+  private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+/**
+ * @brief Streams an animated PNG (APNG) to a file one frame at a time.
+ *
+ * The first frame covers the whole canvas, later frames may cover any part of
+ * it and are drawn over what was shown before. A frame's duration is only known
+ * once the next one arrives, so the last frame is held compressed until then.
+ * The frame count in acTL is patched by Finish(), readers show a file that was
+ * never finished as its first frame.
+ */
+class ApngWriter {
+  public:
+    ApngWriter();
+    ~ApngWriter();
+
+    bool Open(const std::filesystem::path &path, int width, int height, int level = 6);
+    /**
+     * @param x, y  Position of the frame on the canvas.
+     * @param time  Milliseconds since the start, frames are shown in the order they are added.
+     */
+    bool AddFrame(const uint8_t *bgra, size_t pitch, int x, int y, int width, int height, uint32_t time);
+    // Writes the last frame, shown until endTime, and closes the file
+    bool Finish(uint32_t endTime);
+    uint64_t GetBytesWritten() const;
+
+  private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+} // namespace ImageEncode
\ No newline at end of file
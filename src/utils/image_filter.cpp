@@ -0,0 +1,263 @@
+#include "image_filter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_FILTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Rectangles below this many pixels are filtered on the calling thread
+constexpr size_t parallelThreshold = 256 * 1024;
+
+// Runs fn(begin, end) over [0, count) in contiguous parts, one per core
+template <typename Fn>
+void ParallelFor(int count, size_t pixels, Fn fn) {
+    const int threads = pixels < parallelThreshold
+                            ? 1
+                            : std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, count);
+    if (threads <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    std::vector<std::future<void>> parts;
+    const int step = (count + threads - 1) / threads;
+    for (int begin = step; begin < count; begin += step) {
+        parts.push_back(std::async(std::launch::async, fn, begin, std::min(count, begin + step)));
+    }
+    fn(0, std::min(count, step));
+    for (std::future<void> &part : parts) {
+        part.get();
+    }
+}
+
+// ** =====> BOX BLUR <===== **
+
+// One horizontal box pass over a row of n pixels. src holds the row with
+// radius + 1 copies of its edge pixels on either side, so no index is clamped.
+void BlurRow(const uint8_t *src, uint8_t *dst, int n, int radius) {
+    const uint8_t *row = src + static_cast<size_t>(radius + 1) * 4;
+    const float scale = 1.0f / static_cast<float>(2 * radius + 1);
+
+#ifdef IMAGE_FILTER_SSE2
+    // The four channels of a pixel are the four lanes
+    const __m128i zero = _mm_setzero_si128();
+    const auto load = [&](int i) {
+        int value;
+        std::memcpy(&value, row + i * 4, 4);
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+    };
+    const __m128 factor = _mm_set1_ps(scale);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    __m128i sum = zero;
+    for (int i = -radius; i <= radius; ++i) {
+        sum = _mm_add_epi32(sum, load(i));
+    }
+    for (int x = 0; x < n; ++x) {
+        // Half up and truncated, as the scalar path rounds, not to nearest even
+        const __m128i average = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), factor), half));
+        const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(average, zero), zero);
+        const int value = _mm_cvtsi128_si32(packed);
+        std::memcpy(dst + static_cast<size_t>(x) * 4, &value, 4);
+        sum = _mm_add_epi32(sum, _mm_sub_epi32(load(x + radius + 1), load(x - radius)));
+    }
+#else
+    int sum[4] = {};
+    for (int i = -radius; i <= radius; ++i) {
+        for (int c = 0; c < 4; ++c) sum[c] += row[i * 4 + c];
+    }
+    for (int x = 0; x < n; ++x) {
+        const uint8_t *add = row + (x + radius + 1) * 4;
+        const uint8_t *remove = row + (x - radius) * 4;
+        for (int c = 0; c < 4; ++c) {
+            dst[x * 4 + c] = static_cast<uint8_t>(static_cast<float>(sum[c]) * scale + 0.5f);
+            sum[c] += add[c] - remove[c];
+        }
+    }
+#endif
+}
+
+// Copies a row into padded (see BlurRow), replicating its first and last pixel
+void PadRow(const uint8_t *row, int n, int radius, uint8_t *padded) {
+    const size_t pad = static_cast<size_t>(radius + 1);
+    for (size_t i = 0; i < pad; ++i) {
+        std::memcpy(padded + i * 4, row, 4);
+        std::memcpy(padded + (pad + n + i) * 4, row + static_cast<size_t>(n - 1) * 4, 4);
+    }
+    std::memcpy(padded + pad * 4, row, static_cast<size_t>(n) * 4);
+}
+
+// out = sums * scale, then sums += add - remove, over count bytes of a row
+void BlurColumns(int32_t *sums, const uint8_t *add, const uint8_t *remove, uint8_t *out, size_t count, float scale) {
+    size_t i = 0;
+#ifdef IMAGE_FILTER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 factor = _mm_set1_ps(scale);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i addBytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(add + i));
+        const __m128i removeBytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(remove + i));
+        const __m128i addWords[2] = {_mm_unpacklo_epi8(addBytes, zero), _mm_unpackhi_epi8(addBytes, zero)};
+        const __m128i removeWords[2] = {_mm_unpacklo_epi8(removeBytes, zero), _mm_unpackhi_epi8(removeBytes, zero)};
+
+        __m128i averages[4];
+        for (int part = 0; part < 4; ++part) {
+            __m128i *sum = reinterpret_cast<__m128i *>(sums + i + part * 4);
+            const __m128i current = _mm_loadu_si128(sum);
+            averages[part] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(current), factor), half));
+
+            const __m128i addWord = addWords[part / 2], removeWord = removeWords[part / 2];
+            const __m128i added = part % 2 ? _mm_unpackhi_epi16(addWord, zero) : _mm_unpacklo_epi16(addWord, zero);
+            const __m128i removed = part % 2 ? _mm_unpackhi_epi16(removeWord, zero) : _mm_unpacklo_epi16(removeWord, zero);
+            _mm_storeu_si128(sum, _mm_add_epi32(current, _mm_sub_epi32(added, removed)));
+        }
+        const __m128i low = _mm_packs_epi32(averages[0], averages[1]);
+        const __m128i high = _mm_packs_epi32(averages[2], averages[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = static_cast<uint8_t>(static_cast<float>(sums[i]) * scale + 0.5f);
+        sums[i] += add[i] - remove[i];
+    }
+}
+
+// One vertical box pass over columns [begin, end) of the rectangle, in place.
+// Rows are overwritten top to bottom, a ring keeps the originals still to be subtracted.
+void BlurColumnRange(uint8_t *origin, size_t pitch, int height, int radius, int begin, int end) {
+    const size_t offset = static_cast<size_t>(begin) * 4;
+    const size_t count = static_cast<size_t>(end - begin) * 4;
+    const auto row = [&](int y) { return origin + static_cast<size_t>(std::clamp(y, 0, height - 1)) * pitch + offset; };
+
+    std::vector<int32_t> sums(count, 0);
+    for (int i = -radius; i <= radius; ++i) {
+        const uint8_t *src = row(i);
+        for (size_t c = 0; c < count; ++c) sums[c] += src[c];
+    }
+
+    const int ringRows = std::min(height, 2 * radius + 2);
+    std::vector<uint8_t> ring(count * ringRows);
+    const float scale = 1.0f / static_cast<float>(2 * radius + 1);
+
+    for (int y = 0; y < height; ++y) {
+        uint8_t *current = row(y);
+        std::memcpy(ring.data() + (y % ringRows) * count, current, count);
+
+        // Rows below y are untouched, rows above come from the ring
+        const uint8_t *add = row(y + radius + 1);
+        const int removeRow = std::max(0, y - radius);
+        const uint8_t *remove = ring.data() + (removeRow % ringRows) * count;
+        BlurColumns(sums.data(), add, remove, current, count, scale);
+    }
+}
+
+// ** =====> PIXELATE <===== **
+
+// Average of a block of pixels, channels in BGRA order
+uint32_t AverageBlock(const uint8_t *origin, size_t pitch, int width, int height) {
+    uint64_t sum[4] = {};
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *src = origin + y * pitch;
+        int x = 0;
+#ifdef IMAGE_FILTER_SSE2
+        // 16-bit lanes hold two pixels each, widened once per row
+        const __m128i zero = _mm_setzero_si128();
+        __m128i rowSum = zero;
+        for (; x + 4 <= width && x < 512; x += 4) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4));
+            rowSum = _mm_add_epi16(rowSum, _mm_add_epi16(_mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero)));
+        }
+        alignas(16) uint16_t lanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), rowSum);
+        for (int c = 0; c < 4; ++c) sum[c] += lanes[c] + lanes[c + 4];
+#endif
+        for (; x < width; ++x) {
+            for (int c = 0; c < 4; ++c) sum[c] += src[x * 4 + c];
+        }
+    }
+
+    const uint64_t count = static_cast<uint64_t>(width) * height;
+    uint32_t pixel = 0;
+    for (int c = 0; c < 4; ++c) {
+        pixel |= static_cast<uint32_t>((sum[c] + count / 2) / count) << (c * 8);
+    }
+    return pixel;
+}
+
+void FillBlock(uint8_t *origin, size_t pitch, int width, int height, uint32_t pixel) {
+    for (int y = 0; y < height; ++y) {
+        uint8_t *dst = origin + y * pitch;
+        int x = 0;
+#ifdef IMAGE_FILTER_SSE2
+        const __m128i pattern = _mm_set1_epi32(static_cast<int>(pixel));
+        for (; x + 4 <= width; x += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), pattern);
+        }
+#endif
+        for (; x < width; ++x) {
+            std::memcpy(dst + x * 4, &pixel, 4);
+        }
+    }
+}
+
+} // namespace
+
+void ImageFilter::BoxBlur(uint8_t *bgra, size_t pitch, int x, int y, int width, int height, int radius) {
+    if (!bgra || width <= 0 || height <= 0 || radius <= 0) return;
+
+    uint8_t *origin = bgra + y * pitch + static_cast<size_t>(x) * 4;
+    const size_t pixels = static_cast<size_t>(width) * height;
+
+    // All three horizontal passes while a row is in cache, then all three
+    // vertical ones per stripe. Box passes commute up to rounding.
+    ParallelFor(height, pixels, [&](int begin, int end) {
+        std::vector<uint8_t> padded((static_cast<size_t>(width) + 2 * (radius + 1)) * 4);
+        for (int row = begin; row < end; ++row) {
+            uint8_t *line = origin + row * pitch;
+            for (int pass = 0; pass < 3; ++pass) {
+                PadRow(line, width, radius, padded.data());
+                BlurRow(padded.data(), line, width, radius);
+            }
+        }
+    });
+
+    // Stripes of 64 pixels keep a stripe's sums and row ring in L1 cache,
+    // and a multiple of four pixels keeps the 16-byte kernel on full blocks
+    constexpr int stripeWidth = 64;
+    const int stripes = (width + stripeWidth - 1) / stripeWidth;
+    ParallelFor(stripes, pixels, [&](int begin, int end) {
+        for (int stripe = begin; stripe < end; ++stripe) {
+            const int left = stripe * stripeWidth;
+            for (int pass = 0; pass < 3; ++pass) {
+                BlurColumnRange(origin, pitch, height, radius, left, std::min(width, left + stripeWidth));
+            }
+        }
+    });
+}
+
+void ImageFilter::Pixelate(uint8_t *bgra, size_t pitch, int x, int y, int width, int height, int blockSize) {
+    if (!bgra || width <= 0 || height <= 0 || blockSize <= 1) return;
+
+    uint8_t *origin = bgra + y * pitch + static_cast<size_t>(x) * 4;
+    const int blockRows = (height + blockSize - 1) / blockSize;
+
+    ParallelFor(blockRows, static_cast<size_t>(width) * height, [&](int begin, int end) {
+        for (int blockY = begin; blockY < end; ++blockY) {
+            const int top = blockY * blockSize;
+            const int blockHeight = std::min(blockSize, height - top);
+            for (int left = 0; left < width; left += blockSize) {
+                const int blockWidth = std::min(blockSize, width - left);
+                uint8_t *block = origin + top * pitch + static_cast<size_t>(left) * 4;
+                FillBlock(block, pitch, blockWidth, blockHeight, AverageBlock(block, pitch, blockWidth, blockHeight));
+            }
+        }
+    });
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// In-place filters on a rectangle of an 8-bit BGRA image, used to redact
+// screenshots. Only pixels inside the rectangle are read or written, so
+// nothing outside it leaks in. Kernels use SSE2 where available, large
+// rectangles are split across cores.
+namespace ImageFilter {
+
+/**
+ * @brief Blurs a rectangle with three passes of a separable box filter.
+ *
+ * Three box passes approximate a Gaussian of the given radius, each pass is
+ * a running sum so the cost does not depend on the radius. Edges replicate
+ * the rectangle's border pixels.
+ *
+ * @param pitch  Row size in bytes.
+ */
+void BoxBlur(uint8_t *bgra, size_t pitch, int x, int y, int width, int height, int radius);
+
+/**
+ * @brief Replaces each blockSize x blockSize block of a rectangle with its average colour.
+ *
+ * Blocks are aligned to the rectangle, partial blocks at its right and bottom
+ * edge average only the pixels they cover.
+ */
+void Pixelate(uint8_t *bgra, size_t pitch, int x, int y, int width, int height, int blockSize);
+
+} // namespace ImageFilter
\ No newline at end of file
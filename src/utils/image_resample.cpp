@@ -0,0 +1,266 @@
+#include "image_resample.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RESAMPLE_SSE2 1
+#endif
+
+namespace {
+
+// Source taps contributing to one destination pixel along an axis
+struct Contributions {
+    std::vector<int> first;     // First source index per destination pixel
+    std::vector<int> count;     // Number of taps per destination pixel
+    std::vector<int> offset;    // Offset into weights per destination pixel
+    std::vector<float> weights; // Normalized tap weights
+};
+
+Contributions BuildContributions(int srcSize, int dstSize) {
+    Contributions c;
+    c.first.resize(dstSize);
+    c.count.resize(dstSize);
+    c.offset.resize(dstSize);
+
+    const double ratio = static_cast<double>(srcSize) / dstSize;
+
+    for (int i = 0; i < dstSize; ++i) {
+        c.offset[i] = static_cast<int>(c.weights.size());
+
+        if (ratio > 1.0) {
+            // Area averaging: weight each source pixel by its coverage of [start, end)
+            const double start = i * ratio;
+            const double end = start + ratio;
+            const int first = static_cast<int>(start);
+            const int last = std::min(static_cast<int>(std::ceil(end)), srcSize);
+
+            c.first[i] = first;
+            c.count[i] = last - first;
+            for (int s = first; s < last; ++s) {
+                const double coverage = std::min<double>(s + 1, end) - std::max<double>(s, start);
+                c.weights.push_back(static_cast<float>(coverage / ratio));
+            }
+        } else {
+            // Bilinear: two taps around the mapped pixel centre
+            const double center = (i + 0.5) * ratio - 0.5;
+            const int left = static_cast<int>(std::floor(center));
+            const float t = static_cast<float>(center - left);
+            const int s0 = std::clamp(left, 0, srcSize - 1);
+            const int s1 = std::clamp(left + 1, 0, srcSize - 1);
+
+            c.first[i] = s0;
+            c.count[i] = s1 - s0 + 1;
+            if (s0 == s1) {
+                c.weights.push_back(1.0f);
+            } else {
+                c.weights.push_back(1.0f - t);
+                c.weights.push_back(t);
+            }
+        }
+    }
+    return c;
+}
+
+struct GammaTables {
+    float toLinear[256];
+    uint8_t toSrgb[4096]; // Indexed by linear value * 4095
+
+    GammaTables() {
+        for (int i = 0; i < 256; ++i) {
+            const float v = i / 255.0f;
+            toLinear[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < 4096; ++i) {
+            const float v = i / 4095.0f;
+            const float s = v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+            toSrgb[i] = static_cast<uint8_t>(std::lround(std::clamp(s, 0.0f, 1.0f) * 255.0f));
+        }
+    }
+};
+
+const GammaTables &GetGammaTables() {
+    static const GammaTables tables;
+    return tables;
+}
+
+// Accumulate `weight * px` into acc, 4 channels at a time
+inline void MultiplyAdd(float *acc, const float *px, float weight) {
+#ifdef RESAMPLE_SSE2
+    _mm_storeu_ps(acc, _mm_add_ps(_mm_loadu_ps(acc), _mm_mul_ps(_mm_loadu_ps(px), _mm_set1_ps(weight))));
+#else
+    acc[0] += px[0] * weight;
+    acc[1] += px[1] * weight;
+    acc[2] += px[2] * weight;
+    acc[3] += px[3] * weight;
+#endif
+}
+
+// First source pixel of destination pixel i, the bin of i ends where that of i + 1 starts
+inline int BinStart(int i, int srcSize, int dstSize) {
+    return static_cast<int>(static_cast<int64_t>(i) * srcSize / dstSize);
+}
+
+// Adds the per-channel sums of pixels [first, last) of a row to acc
+inline void SumPixels(const uint8_t *row, int first, int last, uint64_t *acc) {
+#ifdef RESAMPLE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = _mm_setzero_si128(); // 32-bit B, G, R, A
+    int x = first;
+    for (; x + 4 <= last; x += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x * 4));
+        // Pixels 0 + 2 and 1 + 3 in 16 bits, then both halves widened into the sum
+        const __m128i pairs = _mm_add_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero));
+        sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_unpacklo_epi16(pairs, zero), _mm_unpackhi_epi16(pairs, zero)));
+    }
+    for (; x < last; ++x) {
+        int pixel;
+        memcpy(&pixel, row + x * 4, 4);
+        sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero));
+    }
+    // Widened again, a tall bin of a huge image overflows 32 bits
+    __m128i *acc128 = reinterpret_cast<__m128i *>(acc);
+    _mm_storeu_si128(acc128, _mm_add_epi64(_mm_loadu_si128(acc128), _mm_unpacklo_epi32(sum, zero)));
+    _mm_storeu_si128(acc128 + 1, _mm_add_epi64(_mm_loadu_si128(acc128 + 1), _mm_unpackhi_epi32(sum, zero)));
+#else
+    for (int x = first; x < last; ++x) {
+        const uint8_t *p = row + x * 4;
+        acc[0] += p[0];
+        acc[1] += p[1];
+        acc[2] += p[2];
+        acc[3] += p[3];
+    }
+#endif
+}
+
+} // namespace
+
+bool ImageResample::Downscale(
+    const uint8_t *src, int srcWidth, int srcHeight, size_t srcPitch,
+    uint8_t *dst, int dstWidth, int dstHeight, size_t dstPitch
+) {
+    return DownscaleArea(src, srcWidth, srcHeight, srcPitch, dstWidth, dstHeight, 0, 0, dstWidth, dstHeight, dst, dstPitch);
+}
+
+bool ImageResample::DownscaleArea(
+    const uint8_t *src, int srcWidth, int srcHeight, size_t srcPitch,
+    int dstWidth, int dstHeight, int x, int y, int width, int height,
+    uint8_t *dst, size_t dstPitch
+) {
+    // Every bin must hold at least one source pixel
+    if (dstWidth <= 0 || dstHeight <= 0 || dstWidth > srcWidth || dstHeight > srcHeight) return false;
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > dstWidth || y + height > dstHeight) return false;
+
+    std::vector<int> columns(static_cast<size_t>(width) + 1);
+    for (int i = 0; i <= width; ++i) {
+        columns[i] = BinStart(x + i, srcWidth, dstWidth);
+    }
+
+    std::vector<uint64_t> acc(static_cast<size_t>(width) * 4);
+    for (int row = 0; row < height; ++row) {
+        const int top = BinStart(y + row, srcHeight, dstHeight);
+        const int bottom = BinStart(y + row + 1, srcHeight, dstHeight);
+
+        std::fill(acc.begin(), acc.end(), 0);
+        for (int s = top; s < bottom; ++s) {
+            const uint8_t *srcRow = src + s * srcPitch;
+            for (int i = 0; i < width; ++i) {
+                SumPixels(srcRow, columns[i], columns[i + 1], acc.data() + i * 4);
+            }
+        }
+
+        uint8_t *dstRow = dst + row * dstPitch;
+        for (int i = 0; i < width; ++i) {
+            // Division in double is exact enough to round half up like integers would
+            const double count = static_cast<double>(columns[i + 1] - columns[i]) * (bottom - top);
+            for (int c = 0; c < 4; ++c) {
+                dstRow[i * 4 + c] = static_cast<uint8_t>(static_cast<double>(acc[i * 4 + c]) / count + 0.5);
+            }
+        }
+    }
+    return true;
+}
+
+void ImageResample::Resize(
+    const uint8_t *src, int srcWidth, int srcHeight, size_t srcPitch,
+    uint8_t *dst, int dstWidth, int dstHeight, size_t dstPitch,
+    bool gammaCorrect
+) {
+    if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) return;
+
+    const GammaTables &gamma = GetGammaTables();
+    const Contributions horizontal = BuildContributions(srcWidth, dstWidth);
+    const Contributions vertical = BuildContributions(srcHeight, dstHeight);
+
+    // Horizontal pass into a float buffer of srcHeight x dstWidth pixels
+    std::vector<float> decodedRow(static_cast<size_t>(srcWidth) * 4);
+    std::vector<float> rows(static_cast<size_t>(srcHeight) * dstWidth * 4);
+
+    for (int y = 0; y < srcHeight; ++y) {
+        const uint8_t *srcRow = src + y * srcPitch;
+
+        for (int x = 0; x < srcWidth; ++x) {
+            const uint8_t *p = srcRow + x * 4;
+            float *d = decodedRow.data() + x * 4;
+            const float alpha = p[3] / 255.0f;
+            if (gammaCorrect) {
+                // Premultiplied linear light
+                d[0] = gamma.toLinear[p[0]] * alpha;
+                d[1] = gamma.toLinear[p[1]] * alpha;
+                d[2] = gamma.toLinear[p[2]] * alpha;
+            } else {
+                d[0] = p[0] / 255.0f;
+                d[1] = p[1] / 255.0f;
+                d[2] = p[2] / 255.0f;
+            }
+            d[3] = alpha;
+        }
+
+        float *outRow = rows.data() + static_cast<size_t>(y) * dstWidth * 4;
+        for (int x = 0; x < dstWidth; ++x) {
+            float *acc = outRow + x * 4;
+            const float *weights = horizontal.weights.data() + horizontal.offset[x];
+            const float *taps = decodedRow.data() + horizontal.first[x] * 4;
+            for (int t = 0; t < horizontal.count[x]; ++t) {
+                MultiplyAdd(acc, taps + t * 4, weights[t]);
+            }
+        }
+    }
+
+    // Vertical pass and re-encode
+    std::vector<float> accRow(static_cast<size_t>(dstWidth) * 4);
+
+    for (int y = 0; y < dstHeight; ++y) {
+        std::fill(accRow.begin(), accRow.end(), 0.0f);
+        const float *weights = vertical.weights.data() + vertical.offset[y];
+
+        for (int t = 0; t < vertical.count[y]; ++t) {
+            const float *srcRow = rows.data() + static_cast<size_t>(vertical.first[y] + t) * dstWidth * 4;
+            for (int x = 0; x < dstWidth; ++x) {
+                MultiplyAdd(accRow.data() + x * 4, srcRow + x * 4, weights[t]);
+            }
+        }
+
+        uint8_t *dstRow = dst + y * dstPitch;
+        for (int x = 0; x < dstWidth; ++x) {
+            const float *acc = accRow.data() + x * 4;
+            uint8_t *p = dstRow + x * 4;
+            const float alpha = std::clamp(acc[3], 0.0f, 1.0f);
+
+            if (gammaCorrect) {
+                const float unpremultiply = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+                for (int c = 0; c < 3; ++c) {
+                    const float linear = std::clamp(acc[c] * unpremultiply, 0.0f, 1.0f);
+                    p[c] = gamma.toSrgb[static_cast<int>(linear * 4095.0f + 0.5f)];
+                }
+            } else {
+                for (int c = 0; c < 3; ++c) {
+                    p[c] = static_cast<uint8_t>(std::clamp(acc[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+            p[3] = static_cast<uint8_t>(alpha * 255.0f + 0.5f);
+        }
+    }
+}
\ No newline at end of file
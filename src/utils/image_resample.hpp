@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Portable resampling for 8-bit, 4-channel images (RGBA or BGRA, alpha last).
+namespace ImageResample {
+
+/**
+ * @brief Resizes an image with area averaging (box filter) when shrinking
+ *        and bilinear interpolation when enlarging.
+ *
+ * With gammaCorrect set, colour channels are decoded from sRGB to linear light
+ * and weighted by alpha before averaging, then re-encoded. This keeps thin
+ * strokes from darkening and transparent pixels from bleeding into edges.
+ *
+ * @param src       Source pixels.
+ * @param srcPitch  Source row size in bytes.
+ * @param dst       Destination pixels, dstPitch * dstHeight bytes.
+ * @param dstPitch  Destination row size in bytes.
+ */
+void Resize(
+    const uint8_t *src, int srcWidth, int srcHeight, size_t srcPitch,
+    uint8_t *dst, int dstWidth, int dstHeight, size_t dstPitch,
+    bool gammaCorrect
+);
+
+/**
+ * @brief Shrinks an image with an integer box filter, for previews that favour speed.
+ *
+ * Destination pixel x averages the source pixels from x * srcWidth / dstWidth up
+ * to (x + 1) * srcWidth / dstWidth, and likewise vertically, rounded half up.
+ * Source rows are summed into one row of accumulators as they are read, so
+ * nothing image-sized is allocated. Channels are averaged as stored, without
+ * gamma or alpha weighting.
+ *
+ * @return false, writing nothing, when the destination is larger than the source in either direction.
+ */
+bool Downscale(
+    const uint8_t *src, int srcWidth, int srcHeight, size_t srcPitch,
+    uint8_t *dst, int dstWidth, int dstHeight, size_t dstPitch
+);
+
+/**
+ * @brief Computes only the area [x, x + width) x [y, y + height) of a Downscale
+ *        to dstWidth x dstHeight, with the same pixels as the full Downscale.
+ *
+ * @param dst  Receives the area's top-left pixel, dstPitch * height bytes.
+ */
+bool DownscaleArea(
+    const uint8_t *src, int srcWidth, int srcHeight, size_t srcPitch,
+    int dstWidth, int dstHeight, int x, int y, int width, int height,
+    uint8_t *dst, size_t dstPitch
+);
+
+} // namespace ImageResample
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "perceptual_hash.hpp"
+#include "image_resample.hpp"
+
+uint64_t PerceptualHash::DHash(const uint8_t *bgra, int width, int height, size_t pitch) {
+    if (!bgra || width <= 0 || height <= 0) return 0;
+
+    constexpr int columns = 9, rows = 8;
+    uint8_t samples[columns * rows * 4];
+    // Plain averaging, the hash only needs relative brightness
+    ImageResample::Resize(bgra, width, height, pitch, samples, columns, rows, columns * 4, false);
+
+    uint64_t hash = 0;
+    for (int y = 0; y < rows; ++y) {
+        int previous = 0;
+        for (int x = 0; x < columns; ++x) {
+            const uint8_t *p = samples + (y * columns + x) * 4;
+            // BT.601 luma in integer weights summing to 256
+            const int luma = (p[2] * 77 + p[1] * 150 + p[0] * 29) >> 8;
+            if (x > 0) hash = hash << 1 | (previous > luma ? 1 : 0);
+            previous = luma;
+        }
+    }
+    return hash;
+}
\ No newline at end of file
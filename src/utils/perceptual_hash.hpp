@@ -0,0 +1,24 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Perceptual hashes of 8-bit BGRA images. Unlike a content hash, images that
+// look alike (recompressed, a blinking caret, a changed clock digit) get
+// hashes a few bits apart, so near-duplicates are found without comparing pixels.
+namespace PerceptualHash {
+
+/**
+ * @brief Computes the 64-bit difference hash (dHash) of an image.
+ *
+ * The image is area-averaged down to 9x8 luma samples, each bit tells whether
+ * a sample is brighter than its right neighbour.
+ *
+ * @param pitch  Row size in bytes.
+ */
+uint64_t DHash(const uint8_t *bgra, int width, int height, size_t pitch);
+
+// Number of differing bits, 0 for identical looking images
+inline int Distance(uint64_t a, uint64_t b) { return std::popcount(a ^ b); }
+
+} // namespace PerceptualHash
\ No newline at end of file
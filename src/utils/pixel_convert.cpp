@@ -0,0 +1,257 @@
+#include "pixel_convert.hpp"
+#include <atomic>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_CONVERT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC emits any intrinsic regardless of /arch, dispatch guards their use
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+using RowKernel = void (*)(const uint8_t *src, uint8_t *dst, size_t width);
+
+// ** =====> SCALAR <===== **
+
+void BGRAToBGRScalar(const uint8_t *src, uint8_t *dst, size_t width) {
+    for (size_t x = 0; x < width; ++x) {
+        dst[x * 3 + 0] = src[x * 4 + 0];
+        dst[x * 3 + 1] = src[x * 4 + 1];
+        dst[x * 3 + 2] = src[x * 4 + 2];
+    }
+}
+
+void SwapRedBlueScalar(const uint8_t *src, uint8_t *dst, size_t width) {
+    for (size_t x = 0; x < width; ++x) {
+        const uint8_t b = src[x * 4 + 0];
+        const uint8_t r = src[x * 4 + 2];
+        dst[x * 4 + 0] = r;
+        dst[x * 4 + 1] = src[x * 4 + 1];
+        dst[x * 4 + 2] = b;
+        dst[x * 4 + 3] = src[x * 4 + 3];
+    }
+}
+
+#ifdef PIXEL_CONVERT_X86
+
+// ** =====> SSSE3 <===== **
+
+// Packs the BGR bytes of 4 BGRA pixels into the low 12 bytes, zeroing the rest
+TARGET_SSSE3 inline __m128i PackBGR(__m128i bgra) {
+    const __m128i mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    return _mm_shuffle_epi8(bgra, mask);
+}
+
+TARGET_SSSE3 void BGRAToBGRSSSE3(const uint8_t *src, uint8_t *dst, size_t width) {
+    size_t x = 0;
+    // 16 pixels in, 48 bytes out as three full stores
+    for (; x + 16 <= width; x += 16) {
+        const __m128i a = PackBGR(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4)));
+        const __m128i b = PackBGR(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4 + 16)));
+        const __m128i c = PackBGR(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4 + 32)));
+        const __m128i d = PackBGR(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4 + 48)));
+
+        __m128i *out = reinterpret_cast<__m128i *>(dst + x * 3);
+        _mm_storeu_si128(out + 0, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    }
+    BGRAToBGRScalar(src + x * 4, dst + x * 3, width - x);
+}
+
+TARGET_SSSE3 void SwapRedBlueSSSE3(const uint8_t *src, uint8_t *dst, size_t width) {
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), _mm_shuffle_epi8(px, mask));
+    }
+    SwapRedBlueScalar(src + x * 4, dst + x * 4, width - x);
+}
+
+// ** =====> AVX2 <===== **
+
+TARGET_AVX2 void BGRAToBGRAVX2(const uint8_t *src, uint8_t *dst, size_t width) {
+    // The byte shuffle stays within 128-bit lanes, leaving 12 bytes at the
+    // bottom of each lane. The dword permute then joins them into 24 bytes.
+    const __m256i mask = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+    );
+    const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+    size_t x = 0;
+    // 32 pixels in, 96 bytes out as three full stores
+    for (; x + 32 <= width; x += 32) {
+        const __m256i *in = reinterpret_cast<const __m256i *>(src + x * 4);
+        const __m256i a = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256(in + 0), mask), join);
+        const __m256i b = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256(in + 1), mask), join);
+        const __m256i c = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256(in + 2), mask), join);
+        const __m256i d = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256(in + 3), mask), join);
+
+        // a..d each hold 24 valid bytes (6 dwords). Blend them into 3 full vectors:
+        // out0 = a[0..5] b[0..1], out1 = b[2..5] c[0..3], out2 = c[4..5] d[0..5]
+        const __m256i bUp2 = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 0, 1));
+        const __m256i bDown2 = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(2, 3, 4, 5, 0, 0, 0, 0));
+        const __m256i cUp4 = _mm256_permutevar8x32_epi32(c, _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3));
+        const __m256i cDown4 = _mm256_permutevar8x32_epi32(c, _mm256_setr_epi32(4, 5, 0, 0, 0, 0, 0, 0));
+        const __m256i dUp2 = _mm256_permutevar8x32_epi32(d, _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5));
+
+        __m256i *out = reinterpret_cast<__m256i *>(dst + x * 3);
+        _mm256_storeu_si256(out + 0, _mm256_blend_epi32(a, bUp2, 0xC0));
+        _mm256_storeu_si256(out + 1, _mm256_blend_epi32(bDown2, cUp4, 0xF0));
+        _mm256_storeu_si256(out + 2, _mm256_blend_epi32(cDown4, dUp2, 0xFC));
+    }
+    // The SSSE3 tail is not VEX encoded on MSVC, clear the upper halves to avoid the transition stall
+    _mm256_zeroupper();
+    BGRAToBGRSSSE3(src + x * 4, dst + x * 3, width - x);
+}
+
+TARGET_AVX2 void SwapRedBlueAVX2(const uint8_t *src, uint8_t *dst, size_t width) {
+    const __m256i mask = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+    );
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x * 4), _mm256_shuffle_epi8(px, mask));
+    }
+    _mm256_zeroupper();
+    SwapRedBlueSSSE3(src + x * 4, dst + x * 4, width - x);
+}
+
+// ** =====> DISPATCH <===== **
+
+void CpuId(int info[4], int leaf, int subLeaf) {
+#ifdef _MSC_VER
+    __cpuidex(info, leaf, subLeaf);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, subLeaf, a, b, c, d);
+    info[0] = a, info[1] = b, info[2] = c, info[3] = d;
+#endif
+}
+
+PixelConvert::Isa DetectIsa() {
+    int info[4];
+    CpuId(info, 0, 0);
+    const int maxLeaf = info[0];
+
+    CpuId(info, 1, 0);
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!ssse3) return PixelConvert::Isa::Scalar;
+
+    // AVX2 also needs the OS to preserve the YMM registers across context switches
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx) {
+#ifdef _MSC_VER
+        const unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        const unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+        CpuId(info, 7, 0);
+        avx2 = (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? PixelConvert::Isa::AVX2 : PixelConvert::Isa::SSSE3;
+}
+
+#else
+
+PixelConvert::Isa DetectIsa() {
+    return PixelConvert::Isa::Scalar;
+}
+
+#endif // PIXEL_CONVERT_X86
+
+PixelConvert::Isa GetSupportedIsa() {
+    static const PixelConvert::Isa supported = DetectIsa();
+    return supported;
+}
+
+std::atomic<PixelConvert::Isa> maxIsa{PixelConvert::Isa::AVX2};
+
+template <RowKernel Scalar, RowKernel SSSE3, RowKernel AVX2>
+RowKernel Select() {
+    switch (PixelConvert::GetActiveIsa()) {
+    case PixelConvert::Isa::AVX2: return AVX2;
+    case PixelConvert::Isa::SSSE3: return SSSE3;
+    default: return Scalar;
+    }
+}
+
+#ifdef PIXEL_CONVERT_X86
+RowKernel SelectBGRAToBGR() { return Select<BGRAToBGRScalar, BGRAToBGRSSSE3, BGRAToBGRAVX2>(); }
+RowKernel SelectSwapRedBlue() { return Select<SwapRedBlueScalar, SwapRedBlueSSSE3, SwapRedBlueAVX2>(); }
+#else
+RowKernel SelectBGRAToBGR() { return BGRAToBGRScalar; }
+RowKernel SelectSwapRedBlue() { return SwapRedBlueScalar; }
+#endif
+
+} // namespace
+
+PixelConvert::Isa PixelConvert::GetActiveIsa() {
+    const Isa supported = GetSupportedIsa();
+    const Isa limit = maxIsa.load(std::memory_order_relaxed);
+    return static_cast<int>(supported) < static_cast<int>(limit) ? supported : limit;
+}
+
+const char *PixelConvert::GetIsaName(Isa isa) {
+    switch (isa) {
+    case Isa::AVX2: return "AVX2";
+    case Isa::SSSE3: return "SSSE3";
+    default: return "Scalar";
+    }
+}
+
+void PixelConvert::SetMaxIsa(Isa isa) {
+    maxIsa.store(isa, std::memory_order_relaxed);
+}
+
+void PixelConvert::BGRAToBGR(const uint8_t *src, uint8_t *dst, size_t width) {
+    SelectBGRAToBGR()(src, dst, width);
+}
+
+void PixelConvert::SwapRedBlue(const uint8_t *src, uint8_t *dst, size_t width) {
+    SelectSwapRedBlue()(src, dst, width);
+}
+
+void PixelConvert::SetOpaque(uint8_t *pixels, size_t count) {
+    // A plain loop the compiler vectorizes at any baseline, no dispatch needed
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t pixel;
+        std::memcpy(&pixel, pixels + i * 4, 4);
+        pixel |= 0xFF000000u; // Alpha is the high byte on little-endian targets
+        std::memcpy(pixels + i * 4, &pixel, 4);
+    }
+}
+
+void PixelConvert::BGRAToBGRFlipped(
+    const uint8_t *src, size_t srcPitch,
+    uint8_t *dst, size_t dstPitch,
+    int width, int height
+) {
+    if (width <= 0 || height <= 0) return;
+
+    // Resolve the kernel once rather than per row
+    const RowKernel kernel = SelectBGRAToBGR();
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *srcRow = src + static_cast<size_t>(y) * srcPitch;
+        uint8_t *dstRow = dst + static_cast<size_t>(height - 1 - y) * dstPitch;
+        kernel(srcRow, dstRow, static_cast<size_t>(width));
+    }
+}
\ No newline at end of file
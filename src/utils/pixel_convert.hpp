@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Pixel format conversion kernels for 8-bit images. Each kernel has scalar,
+// SSSE3 and AVX2 implementations, the fastest one supported by the CPU is
+// selected on first use.
+namespace PixelConvert {
+
+enum class Isa {
+    Scalar,
+    SSSE3,
+    AVX2
+};
+
+/**
+ * @brief Returns the instruction set the kernels dispatch to on this CPU.
+ */
+Isa GetActiveIsa();
+const char *GetIsaName(Isa isa);
+
+/**
+ * @brief Restricts dispatch to at most the given instruction set.
+ *
+ * Lets callers compare implementations against each other, the effective
+ * level is never higher than what the CPU supports.
+ */
+void SetMaxIsa(Isa isa);
+
+/**
+ * @brief Converts one row of BGRA pixels to packed BGR (24-bit), dropping alpha.
+ *
+ * @param src   width * 4 bytes.
+ * @param dst   width * 3 bytes, must not overlap src.
+ */
+void BGRAToBGR(const uint8_t *src, uint8_t *dst, size_t width);
+
+/**
+ * @brief Swaps the red and blue channels of one row, BGRA <-> RGBA.
+ *
+ * src and dst may be the same buffer.
+ */
+void SwapRedBlue(const uint8_t *src, uint8_t *dst, size_t width);
+
+/**
+ * @brief Sets the alpha byte of every BGRA/RGBA pixel to 255.
+ */
+void SetOpaque(uint8_t *pixels, size_t count);
+
+/**
+ * @brief Converts a BGRA image to packed BGR rows in reverse order.
+ *
+ * Produces the bottom-up layout expected by a 24-bit BI_RGB DIB from a
+ * top-down capture.
+ *
+ * @param srcPitch  Source row size in bytes.
+ * @param dstPitch  Destination row size in bytes, at least width * 3.
+ */
+void BGRAToBGRFlipped(
+    const uint8_t *src, size_t srcPitch,
+    uint8_t *dst, size_t dstPitch,
+    int width, int height
+);
+
+} // namespace PixelConvert
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "rect_packer.hpp"
+#include <algorithm>
+#include <numeric>
+
+static int NextPowerOfTwo(int value) {
+    int result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+// Places rects left to right on shelves, starting a new shelf when the row
+// is full. Returns the used height, or -1 if a rect is wider than the atlas.
+static int PackShelves(std::vector<RectPacker::Rect> &rects, const std::vector<size_t> &order, int padding, int atlasWidth) {
+    int shelfX = 0, shelfY = 0, shelfHeight = 0;
+
+    for (const size_t index : order) {
+        RectPacker::Rect &rect = rects[index];
+        const int paddedWidth = rect.width + padding * 2;
+        const int paddedHeight = rect.height + padding * 2;
+        if (paddedWidth > atlasWidth) return -1;
+
+        if (shelfX + paddedWidth > atlasWidth) {
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+
+        rect.x = shelfX + padding;
+        rect.y = shelfY + padding;
+        shelfX += paddedWidth;
+        shelfHeight = std::max(shelfHeight, paddedHeight);
+    }
+
+    return shelfY + shelfHeight;
+}
+
+bool RectPacker::Pack(std::vector<Rect> &rects, int padding, int maxSize, int &width, int &height) {
+    width = height = 0;
+    if (rects.empty()) return true;
+
+    // Tallest first keeps shelves evenly filled
+    std::vector<size_t> order(rects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&rects](size_t a, size_t b) {
+        return rects[a].height > rects[b].height;
+    });
+
+    long long area = 0;
+    int widest = 0;
+    for (const Rect &rect : rects) {
+        area += static_cast<long long>(rect.width + padding * 2) * (rect.height + padding * 2);
+        widest = std::max(widest, rect.width + padding * 2);
+    }
+
+    // Start near a square atlas and widen until the height fits
+    int atlasWidth = NextPowerOfTwo(widest);
+    while (static_cast<long long>(atlasWidth) * atlasWidth < area)
+        atlasWidth <<= 1;
+
+    for (; atlasWidth <= maxSize; atlasWidth <<= 1) {
+        const int usedHeight = PackShelves(rects, order, padding, atlasWidth);
+        if (usedHeight >= 0 && usedHeight <= maxSize) {
+            width = atlasWidth;
+            height = std::min(NextPowerOfTwo(usedHeight), maxSize);
+            return true;
+        }
+    }
+    return false;
+}
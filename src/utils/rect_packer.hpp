@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+
+// Shelf based rectangle packer used to build texture atlases.
+namespace RectPacker {
+
+struct Rect {
+    int width = 0;
+    int height = 0;
+    int x = 0; // Output position
+    int y = 0;
+};
+
+/**
+ * @brief Assigns non-overlapping positions to every rect.
+ *
+ * @param[in,out] rects   Sizes in, positions out (input order is kept).
+ * @param padding         Empty space kept around every rect.
+ * @param maxSize         Largest allowed atlas width and height.
+ * @param[out] width      Atlas width, a power of two.
+ * @param[out] height     Atlas height, the used height rounded up to a power of two.
+ * @return true if all rects fit within maxSize.
+ */
+bool Pack(std::vector<Rect> &rects, int padding, int maxSize, int &width, int &height);
+
+} // namespace RectPacker
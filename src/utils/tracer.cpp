@@ -0,0 +1,115 @@
+#include "tracer.hpp"
+#include <cstdio>
+#include <fstream>
+
+std::atomic<bool> Tracer::enabled = false;
+std::atomic<bool> Tracer::flushed = false;
+std::string Tracer::filename = "";
+std::mutex Tracer::mutex;
+std::vector<Tracer::Event> Tracer::events = {};
+std::atomic<long long> Tracer::firstFrameUs = -1;
+std::atomic<long long> Tracer::firstNavigationUs = -1;
+
+static long long FileTimeToMicroseconds(const FILETIME &ft) {
+    ULARGE_INTEGER value;
+    value.LowPart = ft.dwLowDateTime;
+    value.HighPart = ft.dwHighDateTime;
+    return static_cast<long long>(value.QuadPart / 10); // 100ns ticks
+}
+
+void Tracer::Enable(const std::string &file) {
+    filename = file;
+    events.reserve(64);
+    enabled = true;
+}
+
+long long Tracer::GetProcessStartTime() {
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        FILETIME now;
+        GetSystemTimePreciseAsFileTime(&now);
+        return FileTimeToMicroseconds(now);
+    }
+    return FileTimeToMicroseconds(creation);
+}
+
+long long Tracer::Now() {
+    // Measured from process creation, so the loader and CRT startup are included
+    static const long long processStart = GetProcessStartTime();
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime(&now);
+    return FileTimeToMicroseconds(now) - processStart;
+}
+
+void Tracer::Record(const Event &event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(event);
+}
+
+void Tracer::Complete(const char *name, long long startUs, long long endUs) {
+    if (!enabled) return;
+    Record({name, 'X', startUs, endUs - startUs, GetCurrentThreadId()});
+}
+
+void Tracer::Instant(const char *name) {
+    if (!enabled) return;
+    Record({name, 'i', Now(), 0, GetCurrentThreadId()});
+}
+
+void Tracer::MarkFirstFrame() {
+    long long unset = -1;
+    if (!enabled || !firstFrameUs.compare_exchange_strong(unset, Now())) return;
+    Instant("First Frame");
+    if (firstNavigationUs >= 0) Flush();
+}
+
+void Tracer::MarkFirstNavigation() {
+    long long unset = -1;
+    if (!enabled || !firstNavigationUs.compare_exchange_strong(unset, Now())) return;
+    Instant("First NavigationCompleted");
+    if (firstFrameUs >= 0) Flush();
+}
+
+// A Release build links as /SUBSYSTEM:windows and starts without a console, so
+// stderr goes nowhere unless it was redirected. Writes to the console the app was
+// started from instead, if there is one.
+static void AttachParentConsole() {
+    const HANDLE handle = GetStdHandle(STD_ERROR_HANDLE);
+    if (handle != nullptr && handle != INVALID_HANDLE_VALUE) return;
+    FILE *stream = nullptr;
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) freopen_s(&stream, "CONOUT$", "w", stderr);
+}
+
+// Reports to stderr and the trace file, in Release the log would be a MessageBox
+void Tracer::Flush() {
+    if (!enabled || flushed.exchange(true)) return;
+    AttachParentConsole();
+
+    const auto toMs = [](long long us) {
+        return us < 0 ? std::string("n/a") : std::to_string(us / 1000) + "." + std::to_string(us / 100 % 10) + " ms";
+    };
+    const long long firstFrame = firstFrameUs;
+    const long long firstNavigation = firstNavigationUs;
+    fprintf(stderr, "Startup: first frame %s, first navigation %s (trace: %s)\n", toMs(firstFrame).c_str(),
+            toMs(firstNavigation).c_str(), filename.c_str());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file) {
+        fprintf(stderr, "Failed to write startup trace: %s\n", filename.c_str());
+        return;
+    }
+
+    const DWORD pid = GetCurrentProcessId();
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event &e = events[i];
+        file << (i == 0 ? "" : ",") << "\n{\"name\":\"" << e.name << "\",\"cat\":\"startup\",\"ph\":\"" << e.phase
+             << "\",\"ts\":" << e.timestamp << ",\"pid\":" << pid << ",\"tid\":" << e.threadId;
+        if (e.phase == 'X') file << ",\"dur\":" << e.duration;
+        if (e.phase == 'i') file << ",\"s\":\"p\"";
+        file << "}";
+    }
+    // Microseconds since process creation, -1 when not reached
+    file << "\n],\"otherData\":{\"firstFrameUs\":" << firstFrame << ",\"firstNavigationUs\":" << firstNavigation << "}}\n";
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <windows.h>
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Tracer::Span TRACE_CONCAT(traceSpan_, __LINE__)(name)
+
+// Lightweight startup tracer producing chrome://tracing compatible JSON.
+// Timestamps are microseconds since process creation, recording is a no-op
+// until Enable() is called. Spans are recorded from any thread.
+class Tracer {
+  public:
+    class Span {
+      public:
+        Span(const char *name) : name(name), start(Tracer::Now()) {}
+        ~Span() { Tracer::Complete(name, start, Tracer::Now()); }
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+      private:
+        const char *name;
+        long long start;
+    };
+
+    static void Enable(const std::string &filename);
+    static bool IsEnabled() { return enabled; }
+    static long long Now();
+
+    static void Complete(const char *name, long long startUs, long long endUs);
+    static void Instant(const char *name);
+    static void MarkFirstFrame();
+    static void MarkFirstNavigation();
+    // Writes the trace file with the summary in its otherData, and the summary to stderr. Only once.
+    static void Flush();
+
+  private:
+    struct Event {
+        const char *name;
+        char phase;
+        long long timestamp;
+        long long duration;
+        DWORD threadId;
+    };
+
+    static void Record(const Event &event);
+    static long long GetProcessStartTime();
+
+  private:
+    static std::atomic<bool> enabled;
+    static std::atomic<bool> flushed;
+    static std::string filename;
+    static std::mutex mutex;
+    static std::vector<Event> events;
+    static std::atomic<long long> firstFrameUs;
+    static std::atomic<long long> firstNavigationUs;
+};
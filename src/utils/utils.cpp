@@ -1,156 +1,216 @@
 #include "utils.hpp"
 #include "Log.hpp"
+#include "tracer.hpp"
+#include "image_resample.hpp"
+#include "pixel_convert.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
 
-#include <fstream>
 #define _CRT_SECURE_NO_WARNINGS
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
 
 namespace Utils {
 
-ID3D11ShaderResourceView *CreateDx11TextureRGBA(
-    const void *data, int width, int height, ID3D11Device *d3dDevice
-) {
-    // Create texture
-    D3D11_TEXTURE2D_DESC desc;
-    ZeroMemory(&desc, sizeof(desc));
-    desc.Width = width;
-    desc.Height = height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    desc.CPUAccessFlags = 0;
+// Bytes used by a texture with its full mip chain, all formats used here are 4 bytes per pixel
+static size_t TextureByteSize(const D3D11_TEXTURE2D_DESC &desc) {
+    size_t bytes = 0;
+    for (UINT level = 0; level < desc.MipLevels; ++level) {
+        const size_t width = std::max(1u, desc.Width >> level);
+        const size_t height = std::max(1u, desc.Height >> level);
+        bytes += width * height * 4;
+    }
+    return bytes * desc.ArraySize;
+}
 
-    ID3D11Texture2D *pTexture = nullptr;
-    D3D11_SUBRESOURCE_DATA subResource;
-    subResource.pSysMem = data;
-    subResource.SysMemPitch = desc.Width * 4;
-    subResource.SysMemSlicePitch = 0;
-    if FAILED (d3dDevice->CreateTexture2D(&desc, &subResource, &pTexture)) {
-        return nullptr;
+static GpuTexture CreateTexture(
+    const D3D11_TEXTURE2D_DESC &desc, const D3D11_SUBRESOURCE_DATA *subResources,
+    ID3D11Device *d3dDevice, const std::source_location &location
+) {
+    ComPtr<ID3D11Texture2D> texture;
+    if FAILED (d3dDevice->CreateTexture2D(&desc, subResources, &texture)) {
+        return {};
     }
 
     // Create texture view
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
     ZeroMemory(&srvDesc, sizeof(srvDesc));
-    srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    srvDesc.Format = desc.Format;
     srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
     srvDesc.Texture2D.MipLevels = desc.MipLevels;
     srvDesc.Texture2D.MostDetailedMip = 0;
-    ID3D11ShaderResourceView *textureView = nullptr;
-    if FAILED (d3dDevice->CreateShaderResourceView(pTexture, &srvDesc, &textureView)) {
-        return nullptr;
+    ComPtr<ID3D11ShaderResourceView> textureView;
+    if FAILED (d3dDevice->CreateShaderResourceView(texture.Get(), &srvDesc, &textureView)) {
+        return {};
     }
 
-    pTexture->Release();
-    return textureView;
+    // The view keeps the texture alive
+    return GpuTexture(std::move(textureView), TextureByteSize(desc), location);
 }
 
-ID3D11ShaderResourceView *CreateDx11TextureBGRA(
-    const void *data, int width, int height, ID3D11Device *d3dDevice
-) {
-    // Create texture
+static D3D11_TEXTURE2D_DESC TextureDesc(int width, int height, UINT mipLevels, DXGI_FORMAT format) {
     D3D11_TEXTURE2D_DESC desc;
     ZeroMemory(&desc, sizeof(desc));
     desc.Width = width;
     desc.Height = height;
-    desc.MipLevels = 1;
+    desc.MipLevels = mipLevels;
     desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.Format = format;
     desc.SampleDesc.Count = 1;
     desc.Usage = D3D11_USAGE_DEFAULT;
     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     desc.CPUAccessFlags = 0;
+    return desc;
+}
 
-    ID3D11Texture2D *pTexture = nullptr;
+GpuTexture CreateDx11TextureRGBA(
+    const void *data, int width, int height, ID3D11Device *d3dDevice, std::source_location location
+) {
+    const D3D11_TEXTURE2D_DESC desc = TextureDesc(width, height, 1, DXGI_FORMAT_R8G8B8A8_UNORM);
     D3D11_SUBRESOURCE_DATA subResource;
     subResource.pSysMem = data;
     subResource.SysMemPitch = desc.Width * 4;
     subResource.SysMemSlicePitch = 0;
-    if FAILED (d3dDevice->CreateTexture2D(&desc, &subResource, &pTexture)) {
-        return nullptr;
-    }
+    return CreateTexture(desc, &subResource, d3dDevice, location);
+}
 
-    // Create texture view
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-    ZeroMemory(&srvDesc, sizeof(srvDesc));
-    srvDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = desc.MipLevels;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-    ID3D11ShaderResourceView *textureView = nullptr;
-    if FAILED (d3dDevice->CreateShaderResourceView(pTexture, &srvDesc, &textureView)) {
-        return nullptr;
+// Create an RGBA texture with a full set of precomputed mip levels
+GpuTexture CreateDx11TextureRGBA(
+    const std::vector<ImageData> &mipChain, ID3D11Device *d3dDevice, std::source_location location
+) {
+    if (mipChain.empty()) return {};
+
+    const D3D11_TEXTURE2D_DESC desc = TextureDesc(
+        mipChain[0].width, mipChain[0].height, static_cast<UINT>(mipChain.size()), DXGI_FORMAT_R8G8B8A8_UNORM
+    );
+    std::vector<D3D11_SUBRESOURCE_DATA> subResources(mipChain.size());
+    for (size_t level = 0; level < mipChain.size(); ++level) {
+        subResources[level].pSysMem = mipChain[level].pixels.data();
+        subResources[level].SysMemPitch = mipChain[level].width * 4;
+        subResources[level].SysMemSlicePitch = 0;
     }
+    return CreateTexture(desc, subResources.data(), d3dDevice, location);
+}
 
-    pTexture->Release();
-    return textureView;
+GpuTexture CreateDx11TextureBGRA(
+    const void *data, int width, int height, ID3D11Device *d3dDevice, std::source_location location
+) {
+    const D3D11_TEXTURE2D_DESC desc = TextureDesc(width, height, 1, DXGI_FORMAT_B8G8R8A8_UNORM);
+    D3D11_SUBRESOURCE_DATA subResource;
+    subResource.pSysMem = data;
+    subResource.SysMemPitch = desc.Width * 4;
+    subResource.SysMemSlicePitch = 0;
+    return CreateTexture(desc, &subResource, d3dDevice, location);
 }
 
-std::vector<char> ReadFileBuffer(const std::string &filepath) {
-    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
-    if (!file) {
-        Log::Error("Failed to open file: %s", filepath.c_str());
-        return {};
-    }
+// A BGRA texture the CPU rewrites with UpdateTexture, whole or in parts, for images replaced at runtime
+GpuTexture CreateUpdatableTextureBGRA(int width, int height, ID3D11Device *d3dDevice, std::source_location location) {
+    // Default usage rather than dynamic: a dynamic texture can only be rewritten whole
+    const D3D11_TEXTURE2D_DESC desc = TextureDesc(width, height, 1, DXGI_FORMAT_B8G8R8A8_UNORM);
+    return CreateTexture(desc, nullptr, d3dDevice, location);
+}
 
-    size_t file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
+// Upload pixels into an area of a texture from CreateUpdatableTextureBGRA, data points at the area's first pixel
+bool UpdateTexture(const GpuTexture &texture, const void *data, size_t pitch, const RECT &area) {
+    if (!texture || area.right <= area.left || area.bottom <= area.top) return false;
 
-    std::vector<char> file_data(file_size);
-    if (!file.read(file_data.data(), file_size)) {
-        Log::Error("Failed to read file: %s", filepath.c_str());
-        return {};
-    }
-    file.close();
-    return file_data;
-}
+    ComPtr<ID3D11Resource> resource;
+    ComPtr<ID3D11Device> device;
+    ComPtr<ID3D11DeviceContext> context;
+    texture.Get()->GetResource(&resource);
+    texture.Get()->GetDevice(&device);
+    device->GetImmediateContext(&context);
 
-// Open and read a file, then forward to LoadTextureFromMemory()
-ID3D11ShaderResourceView *LoadTextureFromFile(const std::string &filepath, ID3D11Device *d3dDevice) {
-    std::vector<char> file_buffer = ReadFileBuffer(filepath);
+    const D3D11_BOX box = {
+        static_cast<UINT>(area.left), static_cast<UINT>(area.top), 0,
+        static_cast<UINT>(area.right), static_cast<UINT>(area.bottom), 1
+    };
+    context->UpdateSubresource(resource.Get(), 0, &box, data, static_cast<UINT>(pitch), 0);
+    return true;
+}
 
-    if (file_buffer.empty()) return nullptr;
+// Decode an in-memory image into a raw RGBA buffer, thread-safe
+ImageData DecodeImage(const Assets::Asset &image) {
+    TRACE_SCOPE("Decode Image");
+    if (image.empty()) return {};
 
-    // Load from disk into a raw RGBA buffer
     int image_width = 0;
     int image_height = 0;
     unsigned char *image_data = stbi_load_from_memory(
-        (const unsigned char *)file_buffer.data(), (int)file_buffer.size(),
+        image.data, static_cast<int>(image.size),
         &image_width, &image_height, NULL, 4
     );
 
     if (image_data == NULL) {
-        Log::Error("Failed to load image: %s", filepath.c_str());
-        return nullptr;
+        Log::Error("Failed to load image: %.*s", static_cast<int>(image.name.size()), image.name.data());
+        return {};
     };
 
-    // Create texture
-    ID3D11ShaderResourceView *textureView =
-        CreateDx11TextureRGBA(image_data, image_width, image_height, d3dDevice);
+    ImageData decoded;
+    decoded.width = image_width;
+    decoded.height = image_height;
+    decoded.pixels.assign(image_data, image_data + static_cast<size_t>(image_width) * image_height * 4);
 
     stbi_image_free(image_data);
-    return textureView;
+    return decoded;
 }
 
-std::vector<ImTextureID> LoadImageTextures(std::vector<std::string> imagePaths, ID3D11Device *d3dDevice) {
-    const ImTextureID placeholder_Texture = ImGui::GetIO().Fonts->TexID;
-    std::vector<ImTextureID> textures;
+// Start decoding every image on its own worker thread. The results are
+// collected by LoadImageTextures, so decoding can overlap device creation.
+std::vector<std::future<ImageData>> DecodeImagesAsync(const std::vector<Assets::Asset> &images) {
+    std::vector<std::future<ImageData>> pendingImages;
+    pendingImages.reserve(images.size());
 
-    for (auto it = imagePaths.begin(); it != imagePaths.end(); ++it) {
-        auto textureView = LoadTextureFromFile(*it, d3dDevice);
+    for (const Assets::Asset &image : images) {
+        pendingImages.push_back(std::async(std::launch::async, DecodeImage, image));
+    }
+    return pendingImages;
+}
 
-        if (textureView != nullptr) {
-            textures.push_back((ImTextureID)(intptr_t)textureView);
-        } else {
-            textures.push_back(placeholder_Texture);
-        }
+std::vector<ImageData> WaitForImages(std::vector<std::future<ImageData>> &pendingImages) {
+    std::vector<ImageData> images;
+    images.reserve(pendingImages.size());
+    for (auto &pending : pendingImages) {
+        images.push_back(pending.get());
     }
+    return images;
+}
 
-    return textures;
+// Gamma-correct resize, used to rasterize icons at their exact on-screen size
+ImageData ResizeImage(const ImageData &image, int width, int height) {
+    if (image.empty() || width <= 0 || height <= 0) return {};
+
+    ImageData resized;
+    resized.width = width;
+    resized.height = height;
+    resized.pixels.resize(static_cast<size_t>(width) * height * 4);
+    ImageResample::Resize(
+        image.pixels.data(), image.width, image.height, static_cast<size_t>(image.width) * 4,
+        resized.pixels.data(), width, height, static_cast<size_t>(width) * 4, true
+    );
+    return resized;
+}
+
+// Copy an RGBA image into the atlas and extrude its edge pixels into the
+// padding, so bilinear filtering at the region borders never samples a neighbour.
+void BlitWithExtrusion(const ImageData &image, unsigned char *atlas, int atlasWidth, int x, int y, int padding) {
+    const size_t atlasPitch = static_cast<size_t>(atlasWidth) * 4;
+
+    for (int row = -padding; row < image.height + padding; ++row) {
+        const int srcRow = std::clamp(row, 0, image.height - 1);
+        const unsigned char *src = image.pixels.data() + static_cast<size_t>(srcRow) * image.width * 4;
+        unsigned char *dst = atlas + (y + row) * atlasPitch + static_cast<size_t>(x) * 4;
+
+        for (int col = -padding; col < 0; ++col)
+            std::memcpy(dst + col * 4, src, 4);
+        std::memcpy(dst, src, static_cast<size_t>(image.width) * 4);
+        for (int col = image.width; col < image.width + padding; ++col)
+            std::memcpy(dst + col * 4, src + (image.width - 1) * 4, 4);
+    }
 }
 
 /**
@@ -163,10 +223,37 @@ std::vector<ImTextureID> LoadImageTextures(std::vector<std::string> imagePaths,
  * @param[out] height Image height.
  * @return true on success, false on error.
  */
-bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height) {
-    // Get screen size
-    width = GetSystemMetrics(SM_CXSCREEN);
-    height = GetSystemMetrics(SM_CYSCREEN);
+bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height, const std::function<void()> &onGrabbed) {
+    // Primary screen
+    const RECT screenRect = {0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN)};
+    return CaptureScreenRegion(screenRect, outBGRAImageBuffer, width, height, onGrabbed);
+}
+
+// Bounds of all monitors, in physical screen coordinates
+RECT GetVirtualScreenRect() {
+    const int x = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    const int y = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    return {x, y, x + GetSystemMetrics(SM_CXVIRTUALSCREEN), y + GetSystemMetrics(SM_CYVIRTUALSCREEN)};
+}
+
+/**
+ * @brief Captures a rectangle of the screen into a top-down BGRA buffer.
+ *
+ * The rectangle is clipped to the virtual screen, so the buffer is only as
+ * large as the visible area requested.
+ *
+ * @param screenRect   Area in screen coordinates, may span monitors.
+ * @param[out] width   Captured width after clipping.
+ * @param[out] height  Captured height after clipping.
+ */
+bool CaptureScreenRegion(const RECT &screenRect, std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height,
+                         const std::function<void()> &onGrabbed) {
+    const RECT virtualScreen = GetVirtualScreenRect();
+    RECT rect;
+    if (!IntersectRect(&rect, &screenRect, &virtualScreen)) return false;
+
+    width = rect.right - rect.left;
+    height = rect.bottom - rect.top;
 
     // Get device context
     HDC hScreenDC = GetDC(NULL);
@@ -189,13 +276,15 @@ bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &h
     SelectObject(hMemoryDC, hBitmap);
 
     // Copy screen to bitmap
-    if (!BitBlt(hMemoryDC, 0, 0, width, height, hScreenDC, 0, 0, SRCCOPY)) {
+    if (!BitBlt(hMemoryDC, 0, 0, width, height, hScreenDC, rect.left, rect.top, SRCCOPY)) {
         DeleteObject(hBitmap);
         DeleteDC(hMemoryDC);
         ReleaseDC(NULL, hScreenDC);
         return false;
     }
 
+    if (onGrabbed) onGrabbed();
+
     // Prepare bitmap info
     BITMAPINFOHEADER bi = {};
     bi.biSize = sizeof(BITMAPINFOHEADER);
@@ -206,7 +295,7 @@ bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &h
     bi.biCompression = BI_RGB;
 
     // Allocate buffer
-    size_t imageSize = width * height * 4;
+    size_t imageSize = static_cast<size_t>(width) * height * 4;
     outBGRAImageBuffer.resize(imageSize);
     if (!GetDIBits(hMemoryDC, hBitmap, 0, height, outBGRAImageBuffer.data(), (BITMAPINFO *)&bi, DIB_RGB_COLORS)) {
         DeleteObject(hBitmap);
@@ -214,6 +303,8 @@ bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &h
         ReleaseDC(NULL, hScreenDC);
         return false;
     }
+    // GDI leaves the alpha channel undefined, the clipboard and PNG keep it
+    PixelConvert::SetOpaque(outBGRAImageBuffer.data(), static_cast<size_t>(width) * height);
 
     // Cleanup
     DeleteObject(hBitmap);
@@ -223,103 +314,55 @@ bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &h
     return true;
 }
 
-/**
- * @brief Copies a top-down BGRA image to the clipboard as a 24-bit CF_BITMAP.
- *
- * @param BGRAImage       Top-down BGRA image data (width * height * 4).
- * @param width           Image width in pixels.
- * @param height          Image height in pixels.
- * @return true           If successfully placed on the clipboard, false otherwise.
- *
- * @note Paint often expects a 24-bit device-dependent bitmap (CF_BITMAP).
- *       This function discards the alpha channel.
- */
-bool Utils::CopyImageToClipboard(const std::vector<BYTE> &BGRAImage, int width, int height) {
-    if (BGRAImage.size() < static_cast<size_t>(width * height * 4))
-        return false;
-
-    // Create a compatible DC/bitmap for the screen
-    HDC hScreenDC = GetDC(nullptr);
-    if (!hScreenDC)
-        return false;
+// Encode a BGRA image as PNG, stb_image_write expects RGBA
+std::vector<unsigned char> EncodePng(const uint8_t *BGRAImage, int width, int height, size_t pitch) {
+    TRACE_SCOPE("Encode PNG");
+    if (width <= 0 || height <= 0) return {};
 
-    HDC hMemoryDC = CreateCompatibleDC(hScreenDC);
-    if (!hMemoryDC) {
-        ReleaseDC(nullptr, hScreenDC);
-        return false;
-    }
-
-    // Create a device-dependent bitmap (DDB)
-    HBITMAP hBitmap = CreateCompatibleBitmap(hScreenDC, width, height);
-    if (!hBitmap) {
-        DeleteDC(hMemoryDC);
-        ReleaseDC(nullptr, hScreenDC);
-        return false;
-    }
-
-    // Select it into the memory DC
-    HBITMAP hOldBmp = (HBITMAP)SelectObject(hMemoryDC, hBitmap);
-
-    // Prepare a BITMAPINFO for 24-bit data
-    BITMAPINFO bi = {};
-    bi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bi.bmiHeader.biWidth = width;
-    bi.bmiHeader.biHeight = height; // positive -> bottom-up
-    bi.bmiHeader.biPlanes = 1;
-    bi.bmiHeader.biBitCount = 24;
-    bi.bmiHeader.biCompression = BI_RGB;
-
-    // Convert top-down BGRA → bottom-up BGR (24-bit, discarding alpha)
-    std::vector<BYTE> bgr24(width * height * 3);
-    const int rowSizeSrc = width * 4; // BGRA
-    const int rowSizeDst = width * 3; // BGR
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    std::vector<unsigned char> rgba(rowSize * height);
     for (int y = 0; y < height; ++y) {
-        // Source row (top-down)
-        const BYTE *srcLine = BGRAImage.data() + (y * rowSizeSrc);
-        // Destination row (bottom-up)
-        BYTE *dstLine = bgr24.data() + ((height - 1 - y) * rowSizeDst);
-        for (int x = 0; x < width; ++x) {
-            // B, G, R from BGRA (ignore alpha)
-            dstLine[x * 3 + 0] = srcLine[x * 4 + 0]; // B
-            dstLine[x * 3 + 1] = srcLine[x * 4 + 1]; // G
-            dstLine[x * 3 + 2] = srcLine[x * 4 + 2]; // R
-        }
+        PixelConvert::SwapRedBlue(BGRAImage + y * pitch, rgba.data() + y * rowSize, width);
     }
 
-    // Transfer the 24-bit data into the device-dependent bitmap
-    if (SetDIBits(hMemoryDC, hBitmap, 0, height, bgr24.data(), &bi, DIB_RGB_COLORS) == 0) {
-        // If SetDIBits fails, cleanup
-        SelectObject(hMemoryDC, hOldBmp);
-        DeleteObject(hBitmap);
-        DeleteDC(hMemoryDC);
-        ReleaseDC(nullptr, hScreenDC);
-        return false;
+    std::vector<unsigned char> encoded;
+    const auto write = [](void *context, void *data, int size) {
+        auto *out = static_cast<std::vector<unsigned char> *>(context);
+        out->insert(out->end(), static_cast<unsigned char *>(data), static_cast<unsigned char *>(data) + size);
+    };
+    if (!stbi_write_png_to_func(write, &encoded, width, height, 4, rgba.data(), static_cast<int>(rowSize))) {
+        return {};
     }
+    return encoded;
+}
 
-    // Restore old bitmap in memory DC
-    SelectObject(hMemoryDC, hOldBmp);
+// stb_image yields RGBA, swapped into the buffer a row at a time
+bool DecodePng(const uint8_t *data, size_t size, std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height,
+               const RECT *crop) {
+    TRACE_SCOPE("Decode PNG");
+    if (!data || size == 0 || size > INT_MAX) return false;
 
-    // Place the HBITMAP on the clipboard
-    if (!OpenClipboard(nullptr)) {
-        DeleteObject(hBitmap);
-        DeleteDC(hMemoryDC);
-        ReleaseDC(nullptr, hScreenDC);
-        return false;
-    }
-    EmptyClipboard();
-    if (!SetClipboardData(CF_BITMAP, hBitmap)) {
-        CloseClipboard();
-        DeleteObject(hBitmap);
-        DeleteDC(hMemoryDC);
-        ReleaseDC(nullptr, hScreenDC);
+    int imageWidth = 0, imageHeight = 0;
+    unsigned char *rgba = stbi_load_from_memory(data, static_cast<int>(size), &imageWidth, &imageHeight, nullptr, 4);
+    if (!rgba) return false;
+
+    // Only the cropped rows are converted, the output never holds the rest of the image
+    RECT area = {0, 0, imageWidth, imageHeight};
+    if (crop && !IntersectRect(&area, &area, crop)) {
+        stbi_image_free(rgba);
         return false;
     }
-    CloseClipboard();
-
-    // hBitmap is now owned by the clipboard; do not delete it
-    DeleteDC(hMemoryDC);
-    ReleaseDC(nullptr, hScreenDC);
+    width = area.right - area.left;
+    height = area.bottom - area.top;
 
+    const size_t sourcePitch = static_cast<size_t>(imageWidth) * 4;
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    outBGRAImageBuffer.resize(rowSize * height);
+    for (int y = 0; y < height; ++y) {
+        const unsigned char *source = rgba + (area.top + y) * sourcePitch + static_cast<size_t>(area.left) * 4;
+        PixelConvert::SwapRedBlue(source, outBGRAImageBuffer.data() + y * rowSize, width);
+    }
+    stbi_image_free(rgba);
     return true;
 }
 
@@ -1,14 +1,54 @@
 #pragma once
 #include <string>
+#include <cstdint>
 #include <vector>
+#include <future>
+#include <functional>
 #include <d3d11.h>
 #include "imgui.h"
+#include "assets.hpp"
+#include "gpu_resources.hpp"
 
 namespace Utils {
 
-bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height);
-bool CopyImageToClipboard(const std::vector<BYTE> &BGRAImageBuffer, int width, int height);
-ID3D11ShaderResourceView *CreateDx11TextureBGRA(const void *data, int width, int height, ID3D11Device *d3dDevice);
-std::vector<ImTextureID> LoadImageTextures(std::vector<std::string> imagePaths, ID3D11Device *d3dDevice);
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels; // Tightly packed RGBA
+
+    bool empty() const { return pixels.empty(); }
+};
+
+struct AtlasRegion {
+    bool valid = false;
+    ImVec2 uv0 = ImVec2(0.0f, 0.0f);
+    ImVec2 uv1 = ImVec2(0.0f, 0.0f);
+};
+
+// Thread-safe. onGrabbed runs once the screen contents are copied, before pixel readback.
+bool CaptureScreenshot(std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height,
+                       const std::function<void()> &onGrabbed = nullptr);
+bool CaptureScreenRegion(const RECT &screenRect, std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height,
+                         const std::function<void()> &onGrabbed = nullptr);
+RECT GetVirtualScreenRect();
+std::vector<unsigned char> EncodePng(const uint8_t *BGRAImage, int width, int height, size_t pitch);
+// Thread-safe. Decodes into top-down BGRA, reusing the buffer's capacity. With crop set only that
+// part, clipped to the image, is converted and returned; fails when it lies outside the image.
+bool DecodePng(const uint8_t *data, size_t size, std::vector<BYTE> &outBGRAImageBuffer, int &width, int &height,
+               const RECT *crop = nullptr);
+GpuTexture CreateDx11TextureRGBA(const void *data, int width, int height, ID3D11Device *d3dDevice,
+                                 std::source_location location = std::source_location::current());
+GpuTexture CreateDx11TextureRGBA(const std::vector<ImageData> &mipChain, ID3D11Device *d3dDevice,
+                                 std::source_location location = std::source_location::current());
+GpuTexture CreateDx11TextureBGRA(const void *data, int width, int height, ID3D11Device *d3dDevice,
+                                 std::source_location location = std::source_location::current());
+GpuTexture CreateUpdatableTextureBGRA(int width, int height, ID3D11Device *d3dDevice,
+                                      std::source_location location = std::source_location::current());
+bool UpdateTexture(const GpuTexture &texture, const void *data, size_t pitch, const RECT &area);
+ImageData DecodeImage(const Assets::Asset &image);
+std::vector<std::future<ImageData>> DecodeImagesAsync(const std::vector<Assets::Asset> &images);
+std::vector<ImageData> WaitForImages(std::vector<std::future<ImageData>> &pendingImages);
+ImageData ResizeImage(const ImageData &image, int width, int height);
+void BlitWithExtrusion(const ImageData &image, unsigned char *atlas, int atlasWidth, int x, int y, int padding);
 
 } // namespace Utils
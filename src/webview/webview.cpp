@@ -4,74 +4,128 @@
 #include <wil/com.h> // Required for wil::unique_cotaskmem_string
 #include <comdef.h>  // For _com_error
 #include "Log.hpp"
+#include "tracer.hpp"
 
 #define HR_MESSAGE(hr) WebView::GetHResultMessage(hr).c_str()
 
 using namespace Microsoft::WRL;
 
-WebView::WebView(HWND hwnd, std::string env_options) {
+namespace {
+
+// Scripts and URLs are UTF-8, widening them byte by byte would mangle anything outside ASCII
+std::wstring Utf8ToWide(const std::string &text) {
+    if (text.empty()) return {};
+    const int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), wide.data(), length);
+    return wide;
+}
+
+} // namespace
+
+// Environment creation spawns the browser process, which dominates
+// time-to-first-page, so it is started before the host window exists.
+// The controller is created once both the environment and the HWND are ready.
+WebView::WebView(std::string env_options, std::string user_data_folder) {
     std::wstring options = std::wstring(env_options.begin(), env_options.end());
-    InitWebView(hwnd, options);
+    std::wstring dataFolder = std::wstring(user_data_folder.begin(), user_data_folder.end());
+    CreateEnvironment(options, dataFolder);
 }
 
 WebView::~WebView() {
     webviewController.Reset();
     webview.Reset();
+    environment.Reset();
 }
 
-void WebView::InitWebView(HWND hwnd, std::wstring env_options) {
+void WebView::Attach(HWND hwnd) {
+    parentHwnd = hwnd;
+    if (environment) {
+        CreateController();
+    }
+}
+
+void WebView::CreateEnvironment(std::wstring env_options, std::wstring user_data_folder) {
     // Set WebView2 additional arguments via environment variable
     SetEnvironmentVariableW(L"WEBVIEW2_ADDITIONAL_BROWSER_ARGUMENTS", env_options.c_str());
 
-    CreateCoreWebView2EnvironmentWithOptions(
-        nullptr, nullptr, nullptr,
+    // Separate user data folders let several instances run side by side
+    const wchar_t *dataFolder = user_data_folder.empty() ? nullptr : user_data_folder.c_str();
+    environmentStart = Tracer::Now();
+
+    const HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(
+        nullptr, dataFolder, nullptr,
         Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
-            [hwnd,
-             this](HRESULT result, ICoreWebView2Environment *env) -> HRESULT {
+            [this](HRESULT result, ICoreWebView2Environment *env) -> HRESULT {
                 if (FAILED(result)) {
                     Log::Critical("Failed to create WebView2 environment. Error: %s", HR_MESSAGE(result));
                     return result;
                 }
 
-                env->CreateCoreWebView2Controller(
-                    hwnd,
-                    Callback<
-                        ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
-                        [hwnd, this](
-                            HRESULT result, ICoreWebView2Controller *controller
-                        ) -> HRESULT {
-                            if (FAILED(result)) {
-                                Log::Critical("Failed to create WebView2 controller. Error: %s", HR_MESSAGE(result));
-                                return result;
-                            }
+                // Overlaps the window, D3D and ImGui spans in the --trace-startup trace
+                Tracer::Complete("WebView2 Environment", environmentStart, Tracer::Now());
+                environment = env;
+
+                // Host window not attached yet, Attach() will continue from here
+                if (parentHwnd != nullptr) {
+                    CreateController();
+                }
+                return S_OK;
+            }
+        ).Get()
+    );
 
-                            webviewController = controller;
-                            webviewController->get_CoreWebView2(&webview);
+    if (FAILED(hr)) {
+        Log::Critical("Failed to start WebView2 environment creation. Error: %s", HR_MESSAGE(hr));
+    }
+}
 
-                            if (initializedCallback) {
-                                initializedCallback();
-                            }
+void WebView::CreateController() {
+    controllerStart = Tracer::Now();
+    environment->CreateCoreWebView2Controller(
+        parentHwnd,
+        Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
+            [this](HRESULT result, ICoreWebView2Controller *controller) -> HRESULT {
+                if (FAILED(result)) {
+                    Log::Critical("Failed to create WebView2 controller. Error: %s", HR_MESSAGE(result));
+                    return result;
+                }
 
-                            webview->add_NavigationStarting(
-                                Callback<ICoreWebView2NavigationStartingEventHandler>(
-                                    [this](ICoreWebView2 *sender, ICoreWebView2NavigationStartingEventArgs *args) -> HRESULT {
-                                        wil::unique_cotaskmem_string uri;
-                                        args->get_Uri(&uri);
-                                        if (urlCallback) {
-                                            std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
-                                            urlCallback(myconv.to_bytes(uri.get()));
-                                        }
-                                        return S_OK;
-                                    }
-                                ).Get(),
-                                nullptr
-                            );
+                Tracer::Complete("WebView2 Controller", controllerStart, Tracer::Now());
+                webviewController = controller;
+                webviewController->get_CoreWebView2(&webview);
 
+                if (initializedCallback) {
+                    initializedCallback();
+                }
+
+                webview->add_NavigationStarting(
+                    Callback<ICoreWebView2NavigationStartingEventHandler>(
+                        [this](ICoreWebView2 *sender, ICoreWebView2NavigationStartingEventArgs *args) -> HRESULT {
+                            wil::unique_cotaskmem_string uri;
+                            args->get_Uri(&uri);
+                            if (urlCallback) {
+                                std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
+                                urlCallback(myconv.to_bytes(uri.get()));
+                            }
                             return S_OK;
                         }
-                    ).Get()
+                    ).Get(),
+                    nullptr
                 );
 
+                if (Tracer::IsEnabled()) {
+                    webview->add_NavigationCompleted(
+                        Callback<ICoreWebView2NavigationCompletedEventHandler>(
+                            [](ICoreWebView2 *sender, ICoreWebView2NavigationCompletedEventArgs *args) -> HRESULT {
+                                Tracer::MarkFirstNavigation();
+                                return S_OK;
+                            }
+                        ).Get(),
+                        nullptr
+                    );
+                }
+
                 return S_OK;
             }
         ).Get()
@@ -109,7 +163,7 @@ void WebView::Reload() {
 }
 
 void WebView::Navigate(std::string url) {
-    std::wstring uri = std::wstring(url.begin(), url.end());
+    std::wstring uri = Utf8ToWide(url);
 
     if (webview) {
         webview->Navigate(uri.c_str());
@@ -124,13 +178,14 @@ void WebView::ExecuteScript(std::string script, std::function<void(std::string)>
         return;
     }
 
-    std::wstring script_w = std::wstring(script.begin(), script.end());
+    std::wstring script_w = Utf8ToWide(script);
 
     const HRESULT hr = webview->ExecuteScript(
         script_w.c_str(),
         Callback<ICoreWebView2ExecuteScriptCompletedHandler>([resultCallback](HRESULT errorCode, LPCWSTR result) -> HRESULT {
             if (SUCCEEDED(errorCode) && result) {
-                std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
+                // UTF-16 in, so characters outside the BMP come back as one UTF-8 sequence
+                std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> myconv;
                 std::string resultStr = myconv.to_bytes(result);
                 resultCallback(resultStr);
             }
@@ -143,6 +198,46 @@ void WebView::ExecuteScript(std::string script, std::function<void(std::string)>
     }
 }
 
+bool WebView::CapturePreview(std::function<void(std::vector<unsigned char>)> pngCallback) {
+    if (!webview) {
+        Log::Warning("CapturePreview Failed. WebView2 not initialized.");
+        return false;
+    }
+
+    // Grows as the browser writes into it, freed with the stream
+    ComPtr<IStream> stream;
+    HRESULT hr = CreateStreamOnHGlobal(nullptr, TRUE, &stream);
+    if (FAILED(hr)) {
+        Log::Error("CapturePreview Failed. Error: %s", HR_MESSAGE(hr));
+        return false;
+    }
+
+    hr = webview->CapturePreview(
+        COREWEBVIEW2_CAPTURE_PREVIEW_IMAGE_FORMAT_PNG, stream.Get(),
+        Callback<ICoreWebView2CapturePreviewCompletedHandler>([this, stream, pngCallback](HRESULT errorCode) -> HRESULT {
+            std::vector<unsigned char> png;
+            HGLOBAL memory = nullptr;
+            STATSTG stat = {};
+            if (FAILED(errorCode)) {
+                Log::Error("CapturePreview Failed. Error: %s", HR_MESSAGE(errorCode));
+            } else if (SUCCEEDED(GetHGlobalFromStream(stream.Get(), &memory)) && SUCCEEDED(stream->Stat(&stat, STATFLAG_NONAME))) {
+                if (const auto *data = static_cast<const unsigned char *>(GlobalLock(memory))) {
+                    png.assign(data, data + stat.cbSize.QuadPart);
+                    GlobalUnlock(memory);
+                }
+            }
+            pngCallback(std::move(png));
+            return S_OK;
+        }).Get()
+    );
+
+    if (FAILED(hr)) {
+        Log::Error("CapturePreview Failed. Error: %s", HR_MESSAGE(hr));
+        return false;
+    }
+    return true;
+}
+
 std::string WebView::GetHResultMessage(HRESULT hr) {
     // First, try _com_error
     _com_error err(hr);
@@ -1,19 +1,24 @@
 #pragma once
 #include <string>
 #include <functional>
+#include <vector>
 #include <windows.h>
 #include <wrl.h>
 #include <webview2.h>
 
 class WebView {
   public:
-    WebView(HWND hwnd, std::string env_options);
+    WebView(std::string env_options, std::string user_data_folder = "");
     ~WebView();
+    void Attach(HWND hwnd);
     void GoBack();
     void GoForward();
     void Reload();
     void Navigate(std::string url);
     void ExecuteScript(std::string script, std::function<void(std::string)> resultCallback);
+    // Renders the page to PNG in memory, unaffected by overlapping or hidden windows. The callback
+    // runs on the UI thread, with no data on failure. Returns false when nothing was started.
+    bool CapturePreview(std::function<void(std::vector<unsigned char>)> pngCallback);
 
   public:
     void OnInitialized(std::function<void()> cb) { initializedCallback = cb; };
@@ -23,12 +28,17 @@ class WebView {
     void Resize(const RECT &bounds);
 
   private:
-    void InitWebView(HWND hwnd, std::wstring env_options);
+    void CreateEnvironment(std::wstring env_options, std::wstring user_data_folder);
+    void CreateController();
     std::string GetHResultMessage(HRESULT hr);
     std::function<void()> initializedCallback = nullptr;
     std::function<void(std::string url)> urlCallback = nullptr;
 
   private:
+    HWND parentHwnd = nullptr;
+    long long environmentStart = 0; // Tracer timestamps (us)
+    long long controllerStart = 0;
+    Microsoft::WRL::ComPtr<ICoreWebView2Environment> environment;
     Microsoft::WRL::ComPtr<ICoreWebView2Controller> webviewController;
     Microsoft::WRL::ComPtr<ICoreWebView2> webview;
 };
@@ -0,0 +1,11 @@
+#include "widgets.hpp"
+
+static float dpiScale = 1.0f;
+
+void Widgets::SetDpiScale(float scale) {
+    dpiScale = scale;
+}
+
+float Widgets::GetDpiScale() {
+    return dpiScale;
+}
\ No newline at end of file
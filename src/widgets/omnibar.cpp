@@ -5,18 +5,9 @@
 
 #define BTN_WIDTH(B) ((B).size.x + (B).padding.x)
 
-struct ButtonProperties {
-    ImVec2 size;
-    ImVec2 padding;
-};
-
-struct Button {
-    static constexpr ButtonProperties Arrow = {{30, 30}, {0, 1}};
-    static constexpr ButtonProperties Refresh = {{25, 25}, {5, 3.5}};
-    static constexpr ButtonProperties Screenshot = {{25, 25}, {5, 3.5}};
-    static constexpr ButtonProperties Settings = {{22, 22}, {5, 3.5}};
-};
+using Button = OmniBarButton;
 
+// In logical pixels, scaled by the DPI factor when used
 constexpr float CombinedWidth =
     BTN_WIDTH(Button::Arrow) * 2 +
     BTN_WIDTH(Button::Refresh) +
@@ -24,28 +15,32 @@ constexpr float CombinedWidth =
     BTN_WIDTH(Button::Settings) +
     46.0f; // MysteryPadding
 
+static bool ImageButton(const char *str_id, const ImageRegion &image, const ImVec2 &size) {
+    return ImGui::ImageButton(str_id, image.textureId, Widgets::Scaled(size), image.uv0, image.uv1);
+}
+
 void Widgets::OmniBar(std::string &url, const OmniBarImageTextures &textures, const OmniBarCallbacks &callbacks) {
     const float full_width = ImGui::GetContentRegionAvail().x; // Get available width
-    const float input_width = full_width - CombinedWidth;      // Remaining space for address bar
+    const float input_width = full_width - Scaled(CombinedWidth); // Remaining space for address bar
 
     ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.18f, 0.18f, 0.18f, 1.0f));
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.12f, 0.12f, 0.20f, 1.0f));
     ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4(0.12f, 0.12f, 0.12f, 1.0f));
-    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Button::Arrow.padding);
+    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Scaled(Button::Arrow.padding));
 
-    if (ImGui::ImageButton("BackwardButton", textures.backward_button, Button::Arrow.size)) {
+    if (ImageButton("BackwardButton", textures.backward_button, Button::Arrow.size)) {
         CALL_IF_VALID(callbacks.backwardButtonCallback);
     }
     ImGui::SameLine();
-    if (ImGui::ImageButton("ForwardButton", textures.forward_button, Button::Arrow.size)) {
+    if (ImageButton("ForwardButton", textures.forward_button, Button::Arrow.size)) {
         CALL_IF_VALID(callbacks.forwardButtonCallback);
     }
 
     ImGui::PopStyleVar();
-    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Button::Refresh.padding);
+    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Scaled(Button::Refresh.padding));
 
     ImGui::SameLine();
-    if (ImGui::ImageButton("RefreshButton", textures.refresh_button, Button::Refresh.size)) {
+    if (ImageButton("RefreshButton", textures.refresh_button, Button::Refresh.size)) {
         CALL_IF_VALID(callbacks.refreshButtonCallback);
     }
 
@@ -54,8 +49,8 @@ void Widgets::OmniBar(std::string &url, const OmniBarImageTextures &textures, co
     ImGui::SetNextItemWidth(input_width);
     // Address bar
     {
-        ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 10.0f);                    // Rounded corners
-        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(15, 5));             // Padding inside the bar
+        ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, Scaled(10.0f));            // Rounded corners
+        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Scaled(ImVec2(15, 5)));     // Padding inside the bar
         ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.12f, 0.12f, 0.12f, 1.0f)); // Dark gray background
         ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, 1, 1, 1));                   // White text
 
@@ -81,18 +76,18 @@ void Widgets::OmniBar(std::string &url, const OmniBarImageTextures &textures, co
     } // Address bar End
 
     ImGui::SameLine();
-    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Button::Screenshot.padding);
+    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Scaled(Button::Screenshot.padding));
 
-    if (ImGui::ImageButton("ScreenshotButton", textures.screenshot_button, Button::Screenshot.size)) {
+    if (ImageButton("ScreenshotButton", textures.screenshot_button, Button::Screenshot.size)) {
         CALL_IF_VALID(callbacks.screenshotButtonCallback);
     }
 
     ImGui::PopStyleVar();
 
     ImGui::SameLine();
-    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Button::Settings.padding);
+    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, Scaled(Button::Settings.padding));
 
-    if (ImGui::ImageButton("SettingsButton", textures.settings_button, Button::Settings.size)) {
+    if (ImageButton("SettingsButton", textures.settings_button, Button::Settings.size)) {
         CALL_IF_VALID(callbacks.settingsButtonCallback);
     }
 
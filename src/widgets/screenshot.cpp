@@ -1,4 +1,44 @@
 #include "widgets.hpp"
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+// Swaps the sampler for the draw commands that follow, reset by ImDrawCallback_ResetRenderState
+static void SetSampler(const ImDrawList *, const ImDrawCmd *cmd) {
+    const auto *state = static_cast<ImGui_ImplDX11_RenderState *>(ImGui::GetPlatformIO().Renderer_RenderState);
+    ID3D11SamplerState *sampler = static_cast<ID3D11SamplerState *>(cmd->UserCallbackData);
+    state->DeviceContext->PSSetSamplers(0, 1, &sampler);
+}
+
+// Magnified view of the preview texture around an image pixel, drawn as a sub-rect
+// by UV so nothing is copied or uploaded
+static void DrawLoupe(const ScreenshotImage &screenshotImage, float scale, int pixelX, int pixelY) {
+    // Span the same number of texels at any scale: the preview is panel-sized, so below 1:1
+    // one texel covers 1/scale image pixels
+    const int span = static_cast<int>(std::lround(15.0f / min(scale, 1.0f))) | 1;
+    const float loupeSize = Scaled(150.0f);
+    const float imgWidth = static_cast<float>(screenshotImage.width);
+    const float imgHeight = static_cast<float>(screenshotImage.height);
+    const ImVec2 uv0 = {(pixelX - span / 2) / imgWidth, (pixelY - span / 2) / imgHeight};
+    const ImVec2 uv1 = {uv0.x + span / imgWidth, uv0.y + span / imgHeight};
+
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+    const ImVec2 pos = ImGui::GetCursorScreenPos();
+    const ImVec2 end = {pos.x + loupeSize, pos.y + loupeSize};
+    drawList->AddRectFilled(pos, end, IM_COL32(0, 0, 0, 255));
+    if (screenshotImage.pointSampler) drawList->AddCallback(SetSampler, screenshotImage.pointSampler);
+    drawList->AddImage((ImTextureID)(intptr_t)screenshotImage.textureView, pos, end, uv0, uv1);
+    if (screenshotImage.pointSampler) drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+
+    // Outline the hovered pixel, in black and white to show on any colour
+    const float cell = loupeSize / span;
+    const ImVec2 cellMin = {pos.x + (span / 2) * cell, pos.y + (span / 2) * cell};
+    const ImVec2 cellMax = {cellMin.x + cell, cellMin.y + cell};
+    drawList->AddRect({cellMin.x - 1.0f, cellMin.y - 1.0f}, {cellMax.x + 1.0f, cellMax.y + 1.0f}, IM_COL32(0, 0, 0, 255));
+    drawList->AddRect(cellMin, cellMax, IM_COL32(255, 255, 255, 255));
+    drawList->AddRect(pos, end, ImGui::GetColorU32(ImGuiCol_Border));
+    ImGui::Dummy({loupeSize, loupeSize});
+}
 
 void Widgets::Screenshot(const ScreenshotImage &screenshotImage, const ScreenshotCallbacks &callbacks) {
     // Get available size inside the window (excluding padding)
@@ -8,31 +48,199 @@ void Widgets::Screenshot(const ScreenshotImage &screenshotImage, const Screensho
     const float imgWidth = static_cast<float>(screenshotImage.width);
     const float imgHeight = static_cast<float>(screenshotImage.height);
 
-    // Calculate aspect-ratio-preserving size
-    const float scale = min(availableSize.x / imgWidth, availableSize.y / imgHeight);
-    const ImVec2 newSize = ImVec2(imgWidth * scale, imgHeight * scale);
+    // Calculate aspect-ratio-preserving size, without an image reserve the whole area
+    const bool hasSize = imgWidth > 0.0f && imgHeight > 0.0f;
+    const float scale = hasSize ? min(availableSize.x / imgWidth, availableSize.y / imgHeight) : 1.0f;
+    const ImVec2 newSize = hasSize ? ImVec2(imgWidth * scale, imgHeight * scale)
+                                   : ImVec2(availableSize.x, availableSize.y - ImGui::GetFrameHeightWithSpacing());
+
+    // Image pixel under the mouse, also shown next to the capture controls
+    std::optional<POINT> hoveredPixel;
+    std::optional<uint32_t> hoveredColor;
 
     if (screenshotImage.textureView != nullptr) {
         ImGui::Image((ImTextureID)(intptr_t)screenshotImage.textureView, newSize);
+
+        const ImVec2 origin = ImGui::GetItemRectMin();
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+        for (const RECT &region : screenshotImage.changedRegions) {
+            drawList->AddRect(
+                {origin.x + region.left * scale, origin.y + region.top * scale},
+                {origin.x + region.right * scale, origin.y + region.bottom * scale},
+                IM_COL32(255, 64, 64, 255), 0.0f, 0, Scaled(2.0f)
+            );
+        }
+
+        // Dragging over the image selects the area to redact. The button also
+        // keeps the drag from moving the window.
+        if (screenshotImage.redactTool != RedactTool::None) {
+            static ImVec2 dragStart;
+            const ImVec2 mouse = ImGui::GetIO().MousePos;
+            ImGui::SetCursorScreenPos(origin);
+            ImGui::InvisibleButton("##RedactArea", newSize);
+            if (ImGui::IsItemActivated()) dragStart = mouse;
+            const ImVec2 dragMin = {min(dragStart.x, mouse.x), min(dragStart.y, mouse.y)};
+            const ImVec2 dragMax = {max(dragStart.x, mouse.x), max(dragStart.y, mouse.y)};
+            if (ImGui::IsItemActive()) {
+                drawList->AddRect(dragMin, dragMax, IM_COL32(255, 255, 255, 255), 0.0f, 0, Scaled(1.0f));
+            }
+            if (ImGui::IsItemDeactivated() && dragMax.x > dragMin.x && dragMax.y > dragMin.y) {
+                const RECT area = {
+                    static_cast<LONG>((dragMin.x - origin.x) / scale), static_cast<LONG>((dragMin.y - origin.y) / scale),
+                    static_cast<LONG>(std::ceil((dragMax.x - origin.x) / scale)),
+                    static_cast<LONG>(std::ceil((dragMax.y - origin.y) / scale))
+                };
+                CALL_IF_VALID(callbacks.redactCallback, area);
+            }
+        }
+
+        // Loupe and colour picker, hidden while dragging out a redaction
+        const ImVec2 mouse = ImGui::GetIO().MousePos;
+        const ImVec2 imageEnd = {origin.x + newSize.x, origin.y + newSize.y};
+        if (ImGui::IsMouseHoveringRect(origin, imageEnd) && ImGui::IsWindowHovered() && !ImGui::IsItemActive()) {
+            // Panel to image coordinates, undoing the aspect-ratio fit
+            const LONG x = static_cast<LONG>((mouse.x - origin.x) / scale);
+            const LONG y = static_cast<LONG>((mouse.y - origin.y) / scale);
+            hoveredPixel = POINT{std::clamp(x, 0L, static_cast<LONG>(screenshotImage.width) - 1),
+                                 std::clamp(y, 0L, static_cast<LONG>(screenshotImage.height) - 1)};
+            if (callbacks.pixelCallback) hoveredColor = callbacks.pixelCallback(hoveredPixel->x, hoveredPixel->y);
+
+            ImGui::BeginTooltip();
+            DrawLoupe(screenshotImage, scale, hoveredPixel->x, hoveredPixel->y);
+            if (hoveredColor) {
+                const uint32_t bgra = *hoveredColor;
+                const int r = (bgra >> 16) & 0xFF, g = (bgra >> 8) & 0xFF, b = bgra & 0xFF;
+                ImGui::ColorButton("##PixelColor", ImVec4(r / 255.0f, g / 255.0f, b / 255.0f, 1.0f),
+                                   ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoAlpha);
+                ImGui::SameLine();
+                ImGui::Text("#%02X%02X%02X\nRGB %d, %d, %d", r, g, b, r, g, b);
+                ImGui::TextDisabled("Right-click to copy");
+
+                if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
+                    char hex[8];
+                    snprintf(hex, sizeof(hex), "#%02X%02X%02X", r, g, b);
+                    ImGui::SetClipboardText(hex);
+                }
+            }
+            ImGui::EndTooltip();
+        }
     } else {
         // Center text within the reserved (newSize) image space
         const ImVec2 spacingY = {newSize.x, newSize.y / 2.2f};
         ImGui::Dummy(spacingY);
         ImGui::Dummy({newSize.x / 3.0f, 0.0f});
         ImGui::SameLine();
-        ImGui::Text("Screenshot not available");
+        const char *status = screenshotImage.pending          ? "Capturing screenshot..."
+                             : screenshotImage.pickingElement ? "Click an element in the page..."
+                             : screenshotImage.mode == CaptureMode::Element && screenshotImage.elementSelector.empty()
+                                 ? "Type a CSS selector or pick an element"
+                                 : "Screenshot not available";
+        ImGui::Text("%s", status);
         ImGui::Dummy(spacingY);
     }
 
-    static const ImGuiIO &io = ImGui::GetIO();
+    static constexpr const char *modeNames[] = {"WebView", "Window", "Region", "Screen", "Element"};
+    int mode = static_cast<int>(screenshotImage.mode);
+    ImGui::SetNextItemWidth(Scaled(90.0f));
+    if (ImGui::Combo("##CaptureMode", &mode, modeNames, IM_ARRAYSIZE(modeNames))) {
+        CALL_IF_VALID(callbacks.captureModeCallback, static_cast<CaptureMode>(mode));
+    }
+    if (screenshotImage.mode == CaptureMode::Element) {
+        // Edited in place, ImGui keeps the text while the field is active
+        std::string elementSelector = screenshotImage.elementSelector;
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(Scaled(140.0f));
+        if (InputTextWithHint("##ElementSelector", "CSS selector", elementSelector)) {
+            CALL_IF_VALID(callbacks.elementSelectorCallback, elementSelector);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button(screenshotImage.pickingElement ? "Cancel pick" : "Pick")) {
+            CALL_IF_VALID(callbacks.pickElementCallback);
+        }
+        if (ImGui::IsItemHovered() && !screenshotImage.pickingElement) {
+            ImGui::SetTooltip("Click an element in the page to capture it, Escape cancels");
+        }
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(screenshotImage.pending);
+    if (ImGui::Button("Retake")) {
+        CALL_IF_VALID(callbacks.retakeCallback);
+    }
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    if (screenshotImage.recording) ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(255, 80, 80, 255));
+    if (ImGui::Button(screenshotImage.recording ? "Stop" : "Record")) {
+        CALL_IF_VALID(callbacks.recordCallback, !screenshotImage.recording);
+    }
+    if (screenshotImage.recording) ImGui::PopStyleColor();
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(screenshotImage.fullPageActive);
+    if (ImGui::Button(screenshotImage.fullPageActive ? "Scrolling..." : "Full page")) {
+        CALL_IF_VALID(callbacks.fullPageCallback);
+    }
+    ImGui::EndDisabled();
+
+    bool highlightChanges = screenshotImage.highlightChanges;
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Changes", &highlightChanges)) {
+        CALL_IF_VALID(callbacks.highlightChangesCallback, highlightChanges);
+    }
 
-    ImGui::Text("Coordinates x: %.f, y: %.f", io.MousePos.x, io.MousePos.y);
-    // Move the "Copy to Clipboard" button to the right
-    constexpr float buttonWidth = 130.0f;
-    const float cursorPosX = availableSize.x + ImGui::GetCursorPosX() - buttonWidth;
-    ImGui::SameLine(cursorPosX);
+    static constexpr const char *redactToolNames[] = {"No redaction", "Blur", "Pixelate"};
+    int redactTool = static_cast<int>(screenshotImage.redactTool);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(Scaled(110.0f));
+    if (ImGui::Combo("##RedactTool", &redactTool, redactToolNames, IM_ARRAYSIZE(redactToolNames))) {
+        CALL_IF_VALID(callbacks.redactToolCallback, static_cast<RedactTool>(redactTool));
+    }
 
+    // Second row: history browsing, also with the arrow keys while the panel is focused
+    if (screenshotImage.historyCount > 0) {
+        const int position = screenshotImage.historyPosition;
+        const bool hasOlder = !screenshotImage.pending && position > 1;
+        const bool hasNewer = !screenshotImage.pending && position > 0 && position < screenshotImage.historyCount;
+        const bool focused = ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows);
+
+        ImGui::BeginDisabled(!hasOlder);
+        if (ImGui::ArrowButton("##OlderScreenshot", ImGuiDir_Left) || (hasOlder && focused && ImGui::IsKeyPressed(ImGuiKey_LeftArrow))) {
+            CALL_IF_VALID(callbacks.historyCallback, -1);
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        if (position > 0)
+            ImGui::Text("%d/%d", position, screenshotImage.historyCount);
+        else
+            ImGui::Text("-/%d", screenshotImage.historyCount);
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!hasNewer);
+        if (ImGui::ArrowButton("##NewerScreenshot", ImGuiDir_Right) || (hasNewer && focused && ImGui::IsKeyPressed(ImGuiKey_RightArrow))) {
+            CALL_IF_VALID(callbacks.historyCallback, 1);
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+    }
+    if (hoveredPixel)
+        ImGui::Text("Coordinates x: %ld, y: %ld", hoveredPixel->x, hoveredPixel->y);
+    else
+        ImGui::TextDisabled("Coordinates x: -, y: -");
+    // Move the "Save" and "Copy to Clipboard" buttons to the right
+    const float buttonWidth = Scaled(130.0f);
+    const float saveButtonWidth = Scaled(60.0f);
+    const float spacing = ImGui::GetStyle().ItemSpacing.x;
+    const float cursorPosX = availableSize.x + ImGui::GetCursorPosX() - buttonWidth - saveButtonWidth - spacing;
+    // In a narrow panel they wrap below rather than being drawn over the coordinates
+    const float lineEndX = ImGui::GetItemRectMax().x - ImGui::GetWindowPos().x + ImGui::GetScrollX() + spacing;
+    if (lineEndX <= cursorPosX) ImGui::SameLine(cursorPosX);
+
+    ImGui::BeginDisabled(screenshotImage.textureView == nullptr);
+    if (ImGui::Button("Save", ImVec2(saveButtonWidth, 0))) {
+        CALL_IF_VALID(callbacks.saveCallback);
+    }
+    ImGui::SameLine();
     if (ImGui::Button("Copy to Clipboard", ImVec2(buttonWidth, 0))) {
         CALL_IF_VALID(callbacks.copyToClipboardCallback);
     }
+    ImGui::EndDisabled();
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "widgets.hpp"
+#include "gpu_resources.hpp"
 
 // Forward declaration
 bool ToggleSwitch(const char *str_id, bool *v);
+void Diagnostics();
 
 inline void AddColumnSpacing(const float &spacing) {
     ImGui::Dummy(ImVec2(spacing, 0));
@@ -99,7 +101,7 @@ void Widgets::Settings(SettingsArgs &args, const SettingsCallbacks &callbacks) {
     ImGui::SeparatorText("Keyboard Shortcuts");
 
     if (ImGui::BeginTable("KeyboardTable", 3, ImGuiTableFlags_SizingFixedFit)) {
-        constexpr float columnSpacing = 15.0f;
+        const float columnSpacing = Scaled(15.0f);
 
         // Row 1 - Visibility Hotkey
         ImGui::TableNextRow();
@@ -128,17 +130,57 @@ void Widgets::Settings(SettingsArgs &args, const SettingsCallbacks &callbacks) {
         AddColumnSpacing(columnSpacing);
         ImGui::Text(args.clickThroughHotKey.c_str());
 
+        // Row 4 - Screenshot Hotkey
+        ImGui::TableNextRow();
+        ImGui::TableSetColumnIndex(0);
+        ImGui::Text("Save Screenshot to File");
+
+        ImGui::TableSetColumnIndex(1);
+        AddColumnSpacing(columnSpacing);
+        ImGui::Text(args.screenshotHotKey.c_str());
+
         ImGui::EndTable();
     }
+
+    ImGui::Spacing();
+    ImGui::SeparatorText("Diagnostics");
+    Diagnostics();
+    CALL_IF_VALID(callbacks.diagnosticsCallback);
+}
+
+static double ToMegabytes(uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// GPU memory as reported by DXGI, plus the textures owned by the application
+void Diagnostics() {
+    const GpuResources::VideoMemoryInfo memory = GpuResources::QueryVideoMemory();
+    if (memory.valid) {
+        ImGui::Text("Video Memory: %.1f MB of %.1f MB budget", ToMegabytes(memory.usage), ToMegabytes(memory.budget));
+    } else {
+        ImGui::TextDisabled("Video Memory: unavailable");
+    }
+
+    const std::vector<GpuResources::Entry> textures = GpuResources::GetLiveEntries();
+    ImGui::Text("Textures: %zu, %.2f MB (peak %.2f MB)", textures.size(),
+                ToMegabytes(GpuResources::GetLiveBytes()), ToMegabytes(GpuResources::GetPeakBytes()));
+
+    if (ImGui::TreeNode("Live Textures")) {
+        for (const GpuResources::Entry &texture : textures) {
+            ImGui::BulletText("#%llu  %.2f MB  %s", static_cast<unsigned long long>(texture.id),
+                              ToMegabytes(texture.bytes), texture.site.c_str());
+        }
+        ImGui::TreePop();
+    }
 }
 
 bool ToggleSwitch(const char *str_id, bool *v) {
     ImVec2 p = ImGui::GetCursorScreenPos();
     ImDrawList *draw_list = ImGui::GetWindowDrawList();
 
-    constexpr float height = 20.0f;
-    constexpr float width = height * 1.8f;
-    constexpr float radius = height * 0.5f;
+    const float height = Widgets::Scaled(20.0f);
+    const float width = height * 1.8f;
+    const float radius = height * 0.5f;
 
     bool clicked = ImGui::InvisibleButton(str_id, ImVec2(width, height));
 
@@ -149,7 +191,7 @@ bool ToggleSwitch(const char *str_id, bool *v) {
     ImU32 col_circle = IM_COL32(255, 255, 255, 255);
 
     draw_list->AddRectFilled(p, ImVec2(p.x + width, p.y + height), col_bg, radius);
-    draw_list->AddCircleFilled(ImVec2(p.x + (*v ? width - radius : radius), p.y + radius), radius - 2, col_circle);
+    draw_list->AddCircleFilled(ImVec2(p.x + (*v ? width - radius : radius), p.y + radius), radius - Widgets::Scaled(2.0f), col_circle);
 
     return clicked;
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
+#include <span>
 #include <string>
 #include <vector>
 #include <functional>
+#include <optional>
+#include <cstdint>
 #include <d3d11.h>
 #include "imgui.h"
 #include "imgui_impl_win32.h"
@@ -12,12 +15,34 @@
         if (fn) fn(__VA_ARGS__); \
     } while (0)
 
+struct ButtonProperties {
+    ImVec2 size;
+    ImVec2 padding;
+};
+
+// OmniBar button geometry in logical (96 DPI) pixels
+struct OmniBarButton {
+    static constexpr ButtonProperties Arrow = {{30, 30}, {0, 1}};
+    static constexpr ButtonProperties Refresh = {{25, 25}, {5, 3.5}};
+    static constexpr ButtonProperties Screenshot = {{25, 25}, {5, 3.5}};
+    static constexpr ButtonProperties Settings = {{22, 22}, {5, 3.5}};
+};
+
+// A sub-rectangle of a (possibly shared) texture
+struct ImageRegion {
+    ImTextureID textureId;
+    ImVec2 uv0 = ImVec2(0.0f, 0.0f);
+    ImVec2 uv1 = ImVec2(1.0f, 1.0f);
+};
+
+// The icons are packed into the font atlas, so the toolbar's icons, button
+// frames and URL text all draw from one texture in a single batch
 struct OmniBarImageTextures {
-    ImTextureID backward_button;
-    ImTextureID forward_button;
-    ImTextureID refresh_button;
-    ImTextureID settings_button;
-    ImTextureID screenshot_button;
+    ImageRegion backward_button;
+    ImageRegion forward_button;
+    ImageRegion refresh_button;
+    ImageRegion settings_button;
+    ImageRegion screenshot_button;
 };
 
 struct OmniBarCallbacks {
@@ -32,6 +57,7 @@ struct OmniBarCallbacks {
 struct SettingsArgs {
     std::string website_url;
     std::string env_options;
+    std::string profile; // WebView2 user data folder, empty for default
     bool topmost;
     bool borderless;
     bool toolWindow;
@@ -40,6 +66,7 @@ struct SettingsArgs {
     std::string quitHotKey;
     std::string visibilityHotKey;
     std::string clickThroughHotKey;
+    std::string screenshotHotKey;
 };
 
 struct SettingsCallbacks {
@@ -50,20 +77,67 @@ struct SettingsCallbacks {
     std::function<void(bool)> toolWindowCallback;
     std::function<void(bool)> cursorLockCallback;
     std::function<void(int)> transparencyCallback;
+    std::function<void()> diagnosticsCallback; // Draws extra rows in the Diagnostics section
+};
+
+// Area a screenshot is taken of
+enum class CaptureMode {
+    WebView, // Page area below the toolbar
+    Window,  // Whole WebFrame window
+    Region,  // Rectangle dragged over a frozen image of all monitors
+    Screen,  // Primary monitor
+    Element  // Page element matching a CSS selector
+};
+
+// Filter the Screenshot panel applies to rectangles dragged over the image
+enum class RedactTool {
+    None,
+    Blur,
+    Pixelate
 };
 
 struct ScreenshotImage {
     int width;
     int height;
     ID3D11ShaderResourceView *textureView = nullptr;
+    bool pending = false; // Capture or region selection still running, show a placeholder
+    CaptureMode mode = CaptureMode::WebView;
+    int historyPosition = 0; // 1-based position of the shown capture in the history, 0 when not stored
+    int historyCount = 0;
+    bool highlightChanges = false;
+    std::span<const RECT> changedRegions; // Outlined over the image, in image pixels. Valid for the frame.
+    RedactTool redactTool = RedactTool::None;
+    ID3D11SamplerState *pointSampler = nullptr; // Used by the loupe, null keeps ImGui's linear sampler
+    bool recording = false;
+    bool fullPageActive = false; // Scrolling through the page for a full-page capture
+    std::string elementSelector;  // CSS selector of Element mode
+    bool pickingElement = false;  // Waiting for a click on an element in the page
 };
 
 struct ScreenshotCallbacks {
     std::function<void()> copyToClipboardCallback;
+    std::function<void()> saveCallback;
+    std::function<void(CaptureMode)> captureModeCallback;
+    std::function<void()> retakeCallback;
+    std::function<void(int)> historyCallback; // Step to an older (-1) or newer (+1) capture
+    std::function<void(bool)> highlightChangesCallback;
+    std::function<void(RedactTool)> redactToolCallback;
+    std::function<void(RECT)> redactCallback; // Area in image pixels, unclipped
+    std::function<std::optional<uint32_t>(int, int)> pixelCallback; // BGRA of an image pixel, if available
+    std::function<void(bool)> recordCallback;                         // Start (true) or stop a screen recording
+    std::function<void()> fullPageCallback;
+    std::function<void(std::string)> elementSelectorCallback;
+    std::function<void()> pickElementCallback; // Start or stop picking an element in the page
 };
 
 namespace Widgets {
 
+// Factor from logical (96 DPI) to physical pixels, set by the host window
+void SetDpiScale(float scale);
+float GetDpiScale();
+inline float Scaled(float value) { return value * GetDpiScale(); }
+inline ImVec2 Scaled(const ImVec2 &value) { return ImVec2(value.x * GetDpiScale(), value.y * GetDpiScale()); }
+
 void OmniBar(std::string &url, const OmniBarImageTextures &textures, const OmniBarCallbacks &callbacks);
 void Settings(SettingsArgs &args, const SettingsCallbacks &callbacks);
 void Screenshot(const ScreenshotImage &screenshotImage, const ScreenshotCallbacks &callbacks);
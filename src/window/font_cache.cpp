@@ -0,0 +1,242 @@
+#include "font_cache.hpp"
+#include "Log.hpp"
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <windows.h>
+
+namespace {
+
+constexpr uint32_t CacheMagic = 0x43464657; // "WFFC"
+constexpr uint32_t CacheVersion = 2;
+
+// Load restores the atlas through pre-1.92 internals: AddGlyph with a null config,
+// TexPixelsAlpha8 and TexReady. The dynamic atlas of 1.92 removed them, so the cache
+// must be reworked (or dropped in favour of the normal atlas build) before upgrading.
+static_assert(IMGUI_VERSION_NUM < 19200, "FontCache relies on the pre-1.92 ImFontAtlas internals");
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    FontCache::Key key;
+    int32_t texWidth;
+    int32_t texHeight;
+    ImVec2 texUvWhitePixel;
+    ImVec4 texUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    float fontSize;
+    float ascent;
+    float descent;
+    uint32_t glyphCount;
+};
+
+struct GlyphRecord {
+    uint32_t codepoint;
+    float advanceX;
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+};
+
+struct RectRecord {
+    uint16_t x, y;
+};
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    // FNV-1a, fast enough for a few hundred KB of TTF data
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool KeysEqual(const FontCache::Key &a, const FontCache::Key &b) {
+    return a.imguiVersion == b.imguiVersion && a.dpi == b.dpi &&
+           a.fontHash == b.fontHash && a.glyphRangesHash == b.glyphRangesHash &&
+           a.sizePixels == b.sizePixels && a.oversampleH == b.oversampleH &&
+           a.oversampleV == b.oversampleV && a.atlasFlags == b.atlasFlags &&
+           a.customRectCount == b.customRectCount && a.customRectsHash == b.customRectsHash;
+}
+
+} // namespace
+
+FontCache::Key FontCache::MakeKey(const ImFontAtlas *atlas, const void *fontData, size_t fontSize, const ImFontConfig &config, uint32_t dpi) {
+    // Ranges are zero terminated pairs
+    size_t rangeCount = 0;
+    if (config.GlyphRanges != nullptr) {
+        while (config.GlyphRanges[rangeCount] != 0)
+            ++rangeCount;
+    }
+
+    uint64_t rectsHash = HashBytes(&atlas->CustomRects.Size, sizeof(atlas->CustomRects.Size));
+    for (const ImFontAtlasCustomRect &rect : atlas->CustomRects) {
+        rectsHash = HashBytes(&rect.Width, sizeof(rect.Width), rectsHash);
+        rectsHash = HashBytes(&rect.Height, sizeof(rect.Height), rectsHash);
+    }
+
+    return {
+        .imguiVersion = IMGUI_VERSION_NUM,
+        .dpi = dpi,
+        .fontHash = HashBytes(fontData, fontSize),
+        .glyphRangesHash = HashBytes(config.GlyphRanges, rangeCount * sizeof(ImWchar)),
+        .sizePixels = config.SizePixels,
+        .oversampleH = config.OversampleH,
+        .oversampleV = config.OversampleV,
+        .atlasFlags = static_cast<uint32_t>(atlas->Flags),
+        .customRectCount = static_cast<uint32_t>(atlas->CustomRects.Size),
+        .customRectsHash = rectsHash,
+    };
+}
+
+std::string FontCache::GetPath(const Key &key) {
+    // Field by field, the struct's padding is not hashed
+    uint64_t hash = HashBytes(&key.imguiVersion, sizeof(key.imguiVersion));
+    hash = HashBytes(&key.dpi, sizeof(key.dpi), hash);
+    hash = HashBytes(&key.fontHash, sizeof(key.fontHash), hash);
+    hash = HashBytes(&key.glyphRangesHash, sizeof(key.glyphRangesHash), hash);
+    hash = HashBytes(&key.sizePixels, sizeof(key.sizePixels), hash);
+    hash = HashBytes(&key.oversampleH, sizeof(key.oversampleH), hash);
+    hash = HashBytes(&key.oversampleV, sizeof(key.oversampleV), hash);
+    hash = HashBytes(&key.atlasFlags, sizeof(key.atlasFlags), hash);
+    hash = HashBytes(&key.customRectCount, sizeof(key.customRectCount), hash);
+    hash = HashBytes(&key.customRectsHash, sizeof(key.customRectsHash), hash);
+    char name[40];
+    snprintf(name, sizeof(name), "font_atlas_%016llx.cache", static_cast<unsigned long long>(hash));
+
+    char localAppData[MAX_PATH];
+    const DWORD length = GetEnvironmentVariableA("LOCALAPPDATA", localAppData, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) return name;
+
+    const std::string directory = std::string(localAppData) + "\\WebFrame";
+    CreateDirectoryA(directory.c_str(), nullptr); // Fails harmlessly if it exists
+    return directory + "\\" + name;
+}
+
+bool FontCache::Load(ImFontAtlas *atlas, const Key &key, const std::string &path) {
+    if (atlas->Fonts.Size != 1 || atlas->CustomRects.Size != static_cast<int>(key.customRectCount)) return false;
+
+    // Read the whole file with a single call
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    const std::streamsize fileSize = file.tellg();
+    if (fileSize < static_cast<std::streamsize>(sizeof(Header))) return false;
+
+    std::vector<char> data(static_cast<size_t>(fileSize));
+    file.seekg(0, std::ios::beg);
+    if (!file.read(data.data(), fileSize)) return false;
+
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(Header));
+    if (header.magic != CacheMagic || header.version != CacheVersion || !KeysEqual(header.key, key)) {
+        return false;
+    }
+
+    const size_t glyphBytes = static_cast<size_t>(header.glyphCount) * sizeof(GlyphRecord);
+    const size_t rectBytes = static_cast<size_t>(header.key.customRectCount) * sizeof(RectRecord);
+    const size_t pixelBytes = static_cast<size_t>(header.texWidth) * header.texHeight;
+    if (header.texWidth <= 0 || header.texHeight <= 0 || data.size() != sizeof(Header) + glyphBytes + rectBytes + pixelBytes) {
+        Log::Debug("Font atlas cache is corrupt, rebuilding: %s", path.c_str());
+        return false;
+    }
+
+    atlas->ClearTexData();
+    atlas->TexWidth = header.texWidth;
+    atlas->TexHeight = header.texHeight;
+    atlas->TexUvScale = ImVec2(1.0f / header.texWidth, 1.0f / header.texHeight);
+    atlas->TexUvWhitePixel = header.texUvWhitePixel;
+    std::memcpy(atlas->TexUvLines, header.texUvLines, sizeof(header.texUvLines));
+
+    ImFont *font = atlas->Fonts[0];
+    font->ClearOutputData();
+    font->ContainerAtlas = atlas;
+    font->FontSize = header.fontSize;
+    font->Ascent = header.ascent;
+    font->Descent = header.descent;
+    font->Glyphs.reserve(static_cast<int>(header.glyphCount));
+
+    const char *glyphData = data.data() + sizeof(Header);
+    for (uint32_t i = 0; i < header.glyphCount; ++i) {
+        GlyphRecord g;
+        std::memcpy(&g, glyphData + i * sizeof(GlyphRecord), sizeof(GlyphRecord));
+        // Metrics were already adjusted by the font config when baked
+        font->AddGlyph(nullptr, static_cast<ImWchar>(g.codepoint), g.x0, g.y0, g.x1, g.y1, g.u0, g.v0, g.u1, g.v1, g.advanceX);
+    }
+    font->BuildLookupTable();
+
+    // Left empty in the pixels, the caller fills them in
+    const char *rectData = glyphData + glyphBytes;
+    for (int i = 0; i < atlas->CustomRects.Size; ++i) {
+        RectRecord r;
+        std::memcpy(&r, rectData + i * sizeof(RectRecord), sizeof(RectRecord));
+        atlas->CustomRects[i].X = r.x;
+        atlas->CustomRects[i].Y = r.y;
+    }
+
+    // Owned and freed by the atlas
+    atlas->TexPixelsAlpha8 = static_cast<unsigned char *>(IM_ALLOC(pixelBytes));
+    std::memcpy(atlas->TexPixelsAlpha8, rectData + rectBytes, pixelBytes);
+    atlas->TexReady = true;
+    return true;
+}
+
+bool FontCache::Save(ImFontAtlas *atlas, const Key &key, const std::string &path) {
+    if (atlas->Fonts.Size != 1 || !atlas->IsBuilt()) return false;
+
+    unsigned char *pixels = nullptr;
+    int width = 0, height = 0;
+    atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+    if (pixels == nullptr) return false;
+
+    const ImFont *font = atlas->Fonts[0];
+    Header header = {};
+    header.magic = CacheMagic;
+    header.version = CacheVersion;
+    header.key = key;
+    header.texWidth = width;
+    header.texHeight = height;
+    header.texUvWhitePixel = atlas->TexUvWhitePixel;
+    std::memcpy(header.texUvLines, atlas->TexUvLines, sizeof(header.texUvLines));
+    header.fontSize = font->FontSize;
+    header.ascent = font->Ascent;
+    header.descent = font->Descent;
+    header.glyphCount = static_cast<uint32_t>(font->Glyphs.Size);
+
+    std::vector<GlyphRecord> glyphs;
+    glyphs.reserve(font->Glyphs.Size);
+    for (const ImFontGlyph &g : font->Glyphs) {
+        glyphs.push_back({g.Codepoint, g.AdvanceX, g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1, g.V1});
+    }
+
+    // Only the rects the key was made with, the build appends its own after them
+    if (atlas->CustomRects.Size < static_cast<int>(key.customRectCount)) return false;
+    std::vector<RectRecord> rects;
+    rects.reserve(key.customRectCount);
+    for (uint32_t i = 0; i < key.customRectCount; ++i) {
+        const ImFontAtlasCustomRect &rect = atlas->CustomRects[static_cast<int>(i)];
+        if (!rect.IsPacked()) return false;
+        rects.push_back({rect.X, rect.Y});
+    }
+
+    // Write to a temporary file first, other instances may be reading the cache
+    const std::string tempPath = path + "." + std::to_string(GetCurrentProcessId()) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(glyphs.data()), glyphs.size() * sizeof(GlyphRecord));
+        file.write(reinterpret_cast<const char *>(rects.data()), rects.size() * sizeof(RectRecord));
+        file.write(reinterpret_cast<const char *>(pixels), static_cast<size_t>(width) * height);
+        if (!file) {
+            file.close();
+            DeleteFileA(tempPath.c_str());
+            return false;
+        }
+    }
+
+    if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileA(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
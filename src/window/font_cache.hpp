@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "imgui.h"
+
+// Persists a baked font atlas (pixels, glyph metrics and the positions of the
+// custom rects added before the bake) so startup can skip rasterizing the TTF.
+// Entries are keyed by everything that affects the bake.
+namespace FontCache {
+
+struct Key {
+    uint32_t imguiVersion;
+    uint32_t dpi;
+    uint64_t fontHash;
+    uint64_t glyphRangesHash;
+    float sizePixels;
+    int32_t oversampleH;
+    int32_t oversampleV;
+    uint32_t atlasFlags;
+    uint32_t customRectCount;
+    uint64_t customRectsHash; // Sizes of the custom rects, which move every glyph
+};
+
+// Call after adding the font and the custom rects, before building
+Key MakeKey(const ImFontAtlas *atlas, const void *fontData, size_t fontSize, const ImFontConfig &config, uint32_t dpi);
+// One file per key, so monitors with different DPIs do not overwrite each other's atlas
+std::string GetPath(const Key &key);
+
+// Restores the atlas of the single font added to `atlas` and places its custom rects, false on key mismatch.
+bool Load(ImFontAtlas *atlas, const Key &key, const std::string &path);
+// Stores an atlas that has already been built.
+bool Save(ImFontAtlas *atlas, const Key &key, const std::string &path);
+
+} // namespace FontCache
@@ -1,6 +1,13 @@
 #include "window.hpp"
+#include "tracer.hpp"
+#include "assets.hpp"
+#include "font_cache.hpp"
+#include "Log.hpp"
+
+#include <algorithm>
 
 Window::Window(WindowParams p) {
+    TRACE_SCOPE("Window Creation");
     std::wstring windowName = std::wstring(
         p.windowName.begin(), p.windowName.end()
     );
@@ -35,6 +42,9 @@ Window::~Window() {
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
 
+    // Every texture owner has been destroyed by now, anything left is a leak
+    GpuResources::ReportLeaks();
+    GpuResources::SetDevice(nullptr);
     CleanupDeviceD3D();
     ::DestroyWindow(hwnd);
     ::UnregisterClassW(wc.lpszClassName, wc.hInstance);
@@ -48,28 +58,33 @@ bool Window::Init() {
         return false;
     }
 
+    // Fonts, style and icons are rasterized for the monitor's DPI
+    dpiScale = ImGui_ImplWin32_GetDpiScaleForHwnd(hwnd);
+
     // Show the window
     ::ShowWindow(hwnd, SW_SHOWDEFAULT);
     ::UpdateWindow(hwnd);
 
-    // Setup Dear ImGui context
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
+    {
+        TRACE_SCOPE("ImGui Init");
+        // Setup Dear ImGui context
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
 
-    // Setup Dear ImGui style
-    ImGui::StyleColorsDark();
-    // ImGui::StyleColorsLight();
+        // Setup Dear ImGui style
+        ApplyStyle();
 
-    // Setup Platform/Renderer backends
-    ImGui_ImplWin32_Init(hwnd);
-    ImGui_ImplDX11_Init(d3dDevice, d3dDeviceContext);
+        // Setup Platform/Renderer backends
+        ImGui_ImplWin32_Init(hwnd);
+        ImGui_ImplDX11_Init(d3dDevice.Get(), d3dDeviceContext.Get());
+    }
 
-    // Load default font
-    ImFontConfig fontConfig;
-    fontConfig.FontDataOwnedByAtlas = false;
-    ImGui::GetIO().Fonts->AddFontFromFileTTF(
-        "fonts/Roboto-Regular.ttf", 18.0f, &fontConfig
-    );
+    {
+        TRACE_SCOPE("Font Atlas Build");
+        LoadFonts();
+        // Upload the atlas now rather than lazily in the first NewFrame
+        ImGui_ImplDX11_CreateDeviceObjects();
+    }
 
     return true; // success
 }
@@ -111,6 +126,22 @@ bool Window::Draw() {
         resizeWidth = resizeHeight = 0;
         CreateRenderTarget();
     }
+    // Handle the window moving to a monitor with a different DPI. Fonts and
+    // style are rebuilt here, between frames, like the resize above.
+    if (newDpi != 0) {
+        dpiScale = static_cast<float>(newDpi) / USER_DEFAULT_SCREEN_DPI;
+        newDpi = 0;
+
+        ImGui_ImplDX11_InvalidateDeviceObjects();
+        ImGui::GetIO().Fonts->Clear();
+        LoadFonts();
+        ImGui_ImplDX11_CreateDeviceObjects();
+        ApplyStyle();
+
+        if (dpiChangeCallback) {
+            dpiChangeCallback(dpiScale);
+        }
+    }
     // Handle window being moved
     if (posX != 0 && posY != 0) {
         if (moveCallback) {
@@ -133,21 +164,109 @@ void Window::Render() {
         clear_color.x * clear_color.w, clear_color.y * clear_color.w,
         clear_color.z * clear_color.w, clear_color.w
     };
-    d3dDeviceContext->OMSetRenderTargets(1, &mainRenderTargetView, nullptr);
+    d3dDeviceContext->OMSetRenderTargets(1, mainRenderTargetView.GetAddressOf(), nullptr);
     d3dDeviceContext->ClearRenderTargetView(
-        mainRenderTargetView, clear_color_with_alpha
+        mainRenderTargetView.Get(), clear_color_with_alpha
     );
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 
     // Present
+    const long long presentStart = Tracer::Now();
     HRESULT hr = swapChain->Present(1, 0); // Present with vsync
     // HRESULT hr = pSwapChain->Present(0, 0); // Present without vsync
     swapChainOccluded = (hr == DXGI_STATUS_OCCLUDED);
+
+    if (!firstFramePresented) {
+        firstFramePresented = true;
+        Tracer::Complete("First Present", presentStart, Tracer::Now());
+        Tracer::MarkFirstFrame();
+    }
 }
 
 // ** =====> HELPER FUNCTIONS <===== **
 
+void Window::ApplyStyle() {
+    ImGuiStyle &style = ImGui::GetStyle();
+    style = ImGuiStyle();
+    ImGui::StyleColorsDark();
+    // ImGui::StyleColorsLight();
+    style.ScaleAllSizes(dpiScale);
+}
+
+void Window::LoadFonts() {
+    ImFontAtlas *atlas = ImGui::GetIO().Fonts;
+    // No software cursor is drawn, leaving its shapes out keeps the atlas cacheable
+    atlas->Flags |= ImFontAtlasFlags_NoMouseCursors;
+
+    // Rects for the images are reserved before the bake, with a border for their extruded edges
+    const std::vector<Utils::ImageData> images = atlasImageSource ? atlasImageSource(dpiScale) : std::vector<Utils::ImageData>();
+    std::vector<int> rectIds(images.size(), -1);
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (!images[i].empty()) rectIds[i] = atlas->AddCustomRectRegular(images[i].width + 2, images[i].height + 2);
+    }
+
+    BakeFont(atlas);
+    CopyAtlasImages(atlas, images, rectIds);
+}
+
+void Window::BakeFont(ImFontAtlas *atlas) {
+    // Load default font, the embedded data must not be freed by the atlas
+    const Assets::Asset &font = Assets::Get("fonts/Roboto-Regular.ttf");
+    if (font.empty()) {
+        atlas->AddFontDefault();
+        return;
+    }
+
+    ImFontConfig fontConfig;
+    fontConfig.FontDataOwnedByAtlas = false;
+    fontConfig.GlyphRanges = atlas->GetGlyphRangesDefault();
+    atlas->AddFontFromMemoryTTF(
+        const_cast<unsigned char *>(font.data), static_cast<int>(font.size), 18.0f * dpiScale, &fontConfig
+    );
+
+    // Reuse the atlas baked by a previous run when nothing affecting it changed
+    const FontCache::Key key = FontCache::MakeKey(
+        atlas, font.data, font.size, fontConfig, GetDpiForWindow(hwnd)
+    );
+    const std::string cachePath = FontCache::GetPath(key);
+    if (FontCache::Load(atlas, key, cachePath)) return;
+
+    atlas->Build();
+    // Only startup time is lost, not worth a MessageBox in Release
+    if (!FontCache::Save(atlas, key, cachePath)) {
+        Log::Debug("Failed to write font atlas cache: %s", cachePath.c_str());
+    }
+}
+
+// Writes the images into the RGBA copy of the atlas the backend uploads
+void Window::CopyAtlasImages(ImFontAtlas *atlas, const std::vector<Utils::ImageData> &images, const std::vector<int> &rectIds) {
+    atlasImages.assign(images.size(), {});
+    if (std::ranges::all_of(rectIds, [](int id) { return id < 0; })) return;
+
+    // Converted from the baked alpha, or built first if the default font was added unbaked
+    unsigned char *pixels = nullptr;
+    int width = 0, height = 0;
+    atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    if (pixels == nullptr) return;
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (rectIds[i] < 0) continue;
+        const ImFontAtlasCustomRect *rect = atlas->GetCustomRectByIndex(rectIds[i]);
+        if (!rect->IsPacked()) continue;
+
+        // The image sits inside the rect's one pixel border
+        const int x = rect->X + 1, y = rect->Y + 1;
+        Utils::BlitWithExtrusion(images[i], pixels, width, x, y, 1);
+        atlasImages[i] = {
+            .valid = true,
+            .uv0 = ImVec2(x * atlas->TexUvScale.x, y * atlas->TexUvScale.y),
+            .uv1 = ImVec2((x + images[i].width) * atlas->TexUvScale.x, (y + images[i].height) * atlas->TexUvScale.y),
+        };
+    }
+}
+
 bool Window::CreateDeviceD3D(HWND hWnd) {
+    TRACE_SCOPE("CreateDeviceD3D");
     // Setup swap chain
     DXGI_SWAP_CHAIN_DESC sd;
     ZeroMemory(&sd, sizeof(sd));
@@ -186,40 +305,28 @@ bool Window::CreateDeviceD3D(HWND hWnd) {
         );
     if (res != S_OK) return false;
 
+    GpuResources::SetDevice(d3dDevice.Get());
     CreateRenderTarget();
     return true;
 }
 
 void Window::CleanupDeviceD3D() {
     CleanupRenderTarget();
-    if (swapChain) {
-        swapChain->Release();
-        swapChain = nullptr;
-    }
-    if (d3dDeviceContext) {
-        d3dDeviceContext->Release();
-        d3dDeviceContext = nullptr;
-    }
-    if (d3dDevice) {
-        d3dDevice->Release();
-        d3dDevice = nullptr;
-    }
+    swapChain.Reset();
+    d3dDeviceContext.Reset();
+    d3dDevice.Reset();
 }
 
 void Window::CreateRenderTarget() {
-    ID3D11Texture2D *pBackBuffer;
+    ComPtr<ID3D11Texture2D> pBackBuffer;
     swapChain->GetBuffer(0, IID_PPV_ARGS(&pBackBuffer));
     d3dDevice->CreateRenderTargetView(
-        pBackBuffer, nullptr, &mainRenderTargetView
+        pBackBuffer.Get(), nullptr, &mainRenderTargetView
     );
-    pBackBuffer->Release();
 }
 
 void Window::CleanupRenderTarget() {
-    if (mainRenderTargetView) {
-        mainRenderTargetView->Release();
-        mainRenderTargetView = nullptr;
-    }
+    mainRenderTargetView.Reset();
 }
 
 // Forward declare message handler from imgui_impl_win32.cpp
@@ -252,6 +359,17 @@ Window::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         resizeWidth = (UINT)LOWORD(lParam); // Queue resize
         resizeHeight = (UINT)HIWORD(lParam);
         return 0;
+    case WM_DPICHANGED: {
+        // Move to the rect Windows suggests for the new DPI, rebuild in Draw()
+        const RECT *suggested = reinterpret_cast<const RECT *>(lParam);
+        ::SetWindowPos(
+            hWnd, nullptr, suggested->left, suggested->top,
+            suggested->right - suggested->left, suggested->bottom - suggested->top,
+            SWP_NOZORDER | SWP_NOACTIVATE
+        );
+        newDpi = HIWORD(wParam);
+        return 0;
+    }
     case WM_SYSCOMMAND:
         if ((wParam & 0xfff0) == SC_KEYMENU) // Disable ALT application menu
             return 0;
@@ -266,3 +384,4 @@ Window::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 // Initialize the static variable definitions
 int Window::posX = 0, Window::posY = 0;
 UINT Window::resizeWidth = 0, Window::resizeHeight = 0;
+UINT Window::newDpi = 0;
@@ -6,6 +6,8 @@
 #include "imgui.h"
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx11.h"
+#include "gpu_resources.hpp"
+#include "utils.hpp"
 
 struct WindowParams {
     std::string windowName;
@@ -27,13 +29,20 @@ class Window {
     void StopRunning() { running = false; }
     void OnMove(std::function<void()> callback) { moveCallback = callback; }
     void OnResize(std::function<void()> callback) { resizeCallback = callback; }
+    void OnDpiChange(std::function<void(float)> callback) { dpiChangeCallback = callback; }
     void TriggerResizeCallback() {
         if (resizeCallback) resizeCallback();
     }
+    // Images packed into the font atlas whenever it is built, sized by the source for the DPI scale.
+    // Set before Init(). Drawn from the font texture, they batch with text and frames.
+    void SetAtlasImages(std::function<std::vector<Utils::ImageData>(float)> source) { atlasImageSource = source; }
 
   public:
     HWND GetWindowHandle() { return hwnd; }
-    ID3D11Device *GetDevice() { return d3dDevice; }
+    ID3D11Device *GetDevice() { return d3dDevice.Get(); }
+    float GetDpiScale() { return dpiScale; }
+    // Regions of the atlas images in the font texture, in SetAtlasImages order
+    const std::vector<Utils::AtlasRegion> &GetAtlasImages() const { return atlasImages; }
 
   private:
     HWND hwnd;
@@ -41,8 +50,16 @@ class Window {
     bool running = true;
     std::function<void()> moveCallback = nullptr;
     std::function<void()> resizeCallback = nullptr;
+    std::function<void(float)> dpiChangeCallback = nullptr;
+    float dpiScale = 1.0f; // Monitor DPI relative to 96
+    std::function<std::vector<Utils::ImageData>(float)> atlasImageSource = nullptr;
+    std::vector<Utils::AtlasRegion> atlasImages;
 
   private:
+    void LoadFonts();
+    void BakeFont(ImFontAtlas *atlas);
+    void CopyAtlasImages(ImFontAtlas *atlas, const std::vector<Utils::ImageData> &images, const std::vector<int> &rectIds);
+    void ApplyStyle();
     bool CreateDeviceD3D(HWND hWnd);
     void CleanupDeviceD3D();
     void CreateRenderTarget();
@@ -50,14 +67,16 @@ class Window {
 
   private:
     bool swapChainOccluded = false;
-    IDXGISwapChain *swapChain = nullptr;
-    ID3D11Device *d3dDevice = nullptr;
-    ID3D11DeviceContext *d3dDeviceContext = nullptr;
-    ID3D11RenderTargetView *mainRenderTargetView = nullptr;
+    bool firstFramePresented = false;
+    ComPtr<IDXGISwapChain> swapChain;
+    ComPtr<ID3D11Device> d3dDevice;
+    ComPtr<ID3D11DeviceContext> d3dDeviceContext;
+    ComPtr<ID3D11RenderTargetView> mainRenderTargetView;
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
   private:
     static int posX, posY;
     static UINT resizeWidth, resizeHeight;
+    static UINT newDpi;
     static LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 };
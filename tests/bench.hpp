@@ -0,0 +1,27 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+// Throughput benchmarks, registered like tests but not pass/fail and so not run
+// by ctest. Build them optimized, e.g. --config Release, for meaningful numbers.
+#define BENCH(suite, name)                                                                          \
+    static void suite##_##name();                                                                   \
+    static const bool suite##_##name##_registered = Bench::Register(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+namespace Bench {
+
+struct Case {
+    const char *suite;
+    const char *name;
+    void (*run)();
+};
+
+std::vector<Case> &GetCases();
+bool Register(const char *suite, const char *name, void (*run)());
+// Best time of one call in seconds, over repeated calls for about a quarter of a second
+double Time(const std::function<void()> &fn);
+// Prints the throughput of processing `bytes` in `seconds`
+void Report(const char *label, double bytes, double seconds);
+
+} // namespace Bench
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "bench.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+std::vector<Bench::Case> &Bench::GetCases() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+bool Bench::Register(const char *suite, const char *name, void (*run)()) {
+    GetCases().push_back({suite, name, run});
+    return true;
+}
+
+double Bench::Time(const std::function<void()> &fn) {
+    using Clock = std::chrono::steady_clock;
+    fn(); // Warms caches and lazy initialization
+    double best = 1e30;
+    const Clock::time_point end = Clock::now() + std::chrono::milliseconds(250);
+    int runs = 0;
+    // At least a few runs even when one call takes longer than the budget
+    while (runs < 3 || Clock::now() < end) {
+        const Clock::time_point start = Clock::now();
+        fn();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (seconds < best) best = seconds;
+        ++runs;
+    }
+    return best;
+}
+
+void Bench::Report(const char *label, double bytes, double seconds) {
+    const double mbPerSecond = bytes / seconds / (1024.0 * 1024.0);
+    printf("  %-44s %10.1f MB/s %8.2f GB/s\n", label, mbPerSecond, mbPerSecond / 1024.0);
+}
+
+// Usage: WebFrameBench [suite], runs every suite without an argument
+int main(int argc, char *argv[]) {
+    const char *suite = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    for (const Bench::Case &benchCase : Bench::GetCases()) {
+        if (suite && strcmp(suite, benchCase.suite) != 0) continue;
+        printf("%s.%s\n", benchCase.suite, benchCase.name);
+        benchCase.run();
+        ++run;
+    }
+    if (run == 0) {
+        fprintf(stderr, "No benchmarks match \"%s\"\n", suite ? suite : "");
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
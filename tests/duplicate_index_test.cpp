@@ -0,0 +1,58 @@
+#include "test.hpp"
+#include "duplicate_index.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(duplicate_index, MatchesWithinThreshold) {
+    DuplicateIndex index(8, 3);
+    CHECK(!index.CheckAndInsert(0xF0F0));
+    CHECK(index.CheckAndInsert(0xF0F0));
+    // Three bits apart matches, four does not and is remembered
+    CHECK(index.CheckAndInsert(0xF0F0 ^ 0x0111));
+    CHECK(!index.CheckAndInsert(0xF0F0 ^ 0x1111));
+    CHECK(index.CheckAndInsert(0xF0F0 ^ 0x1111));
+
+    DuplicateIndex exact(8, 0);
+    CHECK(!exact.CheckAndInsert(1));
+    CHECK(exact.CheckAndInsert(1));
+    CHECK(!exact.CheckAndInsert(3));
+}
+
+TEST(duplicate_index, ForgetsOldest) {
+    DuplicateIndex index(2, 0);
+    CHECK(!index.CheckAndInsert(1));
+    CHECK(!index.CheckAndInsert(2));
+    // A match is not inserted again, so it does not keep the hash alive
+    CHECK(index.CheckAndInsert(1));
+    CHECK(!index.CheckAndInsert(3));
+    CHECK(!index.CheckAndInsert(1));
+    CHECK(index.CheckAndInsert(3));
+    CHECK(!index.CheckAndInsert(2));
+}
+
+TEST(duplicate_index, Disabled) {
+    DuplicateIndex negative(8, -1);
+    CHECK(!negative.CheckAndInsert(5));
+    CHECK(!negative.CheckAndInsert(5));
+
+    DuplicateIndex empty(0, 64);
+    CHECK(!empty.CheckAndInsert(5));
+    CHECK(!empty.CheckAndInsert(5));
+}
+
+TEST(duplicate_index, ParallelInsertsPassOnce) {
+    for (int round = 0; round < 20; ++round) {
+        DuplicateIndex index(16, 2);
+        std::atomic<int> passed = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&index, &passed, i]() {
+                // Near-duplicates of each other, exactly one may be saved
+                if (!index.CheckAndInsert(0xABCDull ^ (i & 1))) ++passed;
+            });
+        }
+        for (std::thread &thread : threads) thread.join();
+        CHECK(passed == 1);
+    }
+}
\ No newline at end of file
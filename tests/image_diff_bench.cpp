@@ -0,0 +1,29 @@
+#include "bench.hpp"
+#include "image_diff.hpp"
+#include "pixel_convert.hpp"
+#include <cstdio>
+#include <vector>
+
+// Two 1080p captures, identical except for a few small changes: the common
+// case, where almost every tile has to be compared to the end
+BENCH(image_diff, Compare) {
+    constexpr int width = 1920, height = 1080;
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> a(pitch * height), b;
+    for (size_t i = 0; i < a.size(); ++i) a[i] = static_cast<uint8_t>(i * 7 + i / pitch);
+    b = a;
+    for (int i = 0; i < 20; ++i) b[(i * 53 % height) * pitch + (i * 97 % width) * 4] ^= 0x40;
+
+    for (const PixelConvert::Isa isa : {PixelConvert::Isa::Scalar, PixelConvert::Isa::SSSE3, PixelConvert::Isa::AVX2}) {
+        PixelConvert::SetMaxIsa(isa);
+        if (PixelConvert::GetActiveIsa() != isa) continue;
+        for (const uint8_t tolerance : {0, 8}) {
+            const double seconds = Bench::Time([&]() { ImageDiff::Compare(a.data(), b.data(), width, height, pitch, {16, tolerance}); });
+            char label[64];
+            snprintf(label, sizeof(label), "%s, tolerance %d", PixelConvert::GetIsaName(isa), tolerance);
+            // Both images are read
+            Bench::Report(label, static_cast<double>(a.size()) * 2, seconds);
+        }
+    }
+    PixelConvert::SetMaxIsa(PixelConvert::Isa::AVX2);
+}
\ No newline at end of file
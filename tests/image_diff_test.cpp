@@ -0,0 +1,169 @@
+#include "test.hpp"
+#include "image_diff.hpp"
+#include "pixel_convert.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr PixelConvert::Isa isas[] = {PixelConvert::Isa::Scalar, PixelConvert::Isa::SSSE3, PixelConvert::Isa::AVX2};
+
+// ImageDiff follows PixelConvert's dispatch, SSSE3 selects its SSE2 kernel
+template <typename Fn>
+void ForEachIsa(Fn &&fn) {
+    for (const PixelConvert::Isa isa : isas) {
+        PixelConvert::SetMaxIsa(isa);
+        if (PixelConvert::GetActiveIsa() == isa) fn(isa);
+    }
+    PixelConvert::SetMaxIsa(PixelConvert::Isa::AVX2);
+}
+
+bool RowDiffersReference(const uint8_t *a, const uint8_t *b, size_t bytes, uint8_t tolerance) {
+    for (size_t i = 0; i < bytes; ++i) {
+        if (std::abs(a[i] - b[i]) > tolerance) return true;
+    }
+    return false;
+}
+
+struct Images {
+    int width = 0;
+    int height = 0;
+    size_t pitch = 0;
+    std::vector<uint8_t> a, b;
+
+    Images(int width, int height, unsigned seed) : width(width), height(height), pitch(static_cast<size_t>(width) * 4 + 8) {
+        std::mt19937 random(seed);
+        a.resize(pitch * height);
+        for (uint8_t &byte : a) byte = static_cast<uint8_t>(random());
+        b = a;
+    }
+
+    uint8_t &At(std::vector<uint8_t> &image, int x, int y, int channel = 0) { return image[y * pitch + x * 4 + channel]; }
+
+    ImageDiff::Result Compare(int tileSize, uint8_t tolerance = 0) const {
+        return ImageDiff::Compare(a.data(), b.data(), width, height, pitch, {tileSize, tolerance});
+    }
+};
+
+} // namespace
+
+TEST(image_diff, RowDiffersMatchesReference) {
+    std::mt19937 random(3);
+    std::vector<uint8_t> a(100), b(100);
+    for (uint8_t &byte : a) byte = static_cast<uint8_t>(random());
+
+    ForEachIsa([&](PixelConvert::Isa) {
+        // Every length through the 32, 16 and scalar steps, a difference at every position and around the tolerance
+        for (size_t bytes = 0; bytes <= a.size(); ++bytes) {
+            CHECK(!ImageDiff::RowDiffers(a.data(), a.data(), bytes, 0));
+            for (size_t position = 0; position < bytes; ++position) {
+                for (const int delta : {1, 4, 5, -5, -6, 200}) {
+                    b = a;
+                    b[position] = static_cast<uint8_t>(b[position] + delta);
+                    for (const uint8_t tolerance : {0, 4, 5}) {
+                        CHECK(ImageDiff::RowDiffers(a.data(), b.data(), bytes, tolerance) ==
+                              RowDiffersReference(a.data(), b.data(), bytes, tolerance));
+                    }
+                }
+            }
+        }
+    });
+}
+
+TEST(image_diff, IsasAgree) {
+    // Sparse random changes, the mask and regions must not depend on the kernel
+    for (const int size : {1, 15, 16, 17, 63, 100}) {
+        Images images(size + 3, size, static_cast<unsigned>(size));
+        std::mt19937 random(static_cast<unsigned>(size) + 1);
+        for (int i = 0; i < 6; ++i) {
+            images.At(images.b, random() % images.width, random() % images.height, random() % 4) ^= 1 + random() % 8;
+        }
+        std::vector<ImageDiff::Result> results;
+        ForEachIsa([&](PixelConvert::Isa) {
+            for (const uint8_t tolerance : {0, 3}) results.push_back(images.Compare(16, tolerance));
+        });
+        for (size_t i = 2; i < results.size(); ++i) {
+            CHECK(results[i].mask == results[i % 2].mask);
+            CHECK(results[i].changedTiles == results[i % 2].changedTiles);
+            CHECK(results[i].regions.size() == results[i % 2].regions.size());
+        }
+    }
+}
+
+TEST(image_diff, TileEdges) {
+    ForEachIsa([](PixelConvert::Isa) {
+        // 37x21 with 16 pixel tiles: 3x2 tiles, the last column 5 and the last row 5 pixels
+        Images images(37, 21, 5);
+        ImageDiff::Result result = images.Compare(16);
+        CHECK(result.columns == 3 && result.rows == 2);
+        CHECK(result.changedTiles == 0 && result.regions.empty());
+
+        // The last pixel changes only the partial corner tile, clipped to the image
+        images.At(images.b, 36, 20, 3) ^= 0x80;
+        result = images.Compare(16);
+        CHECK(result.changedTiles == 1 && result.mask[5] == 1);
+        CHECK(result.regions.size() == 1);
+        if (result.regions.size() == 1) {
+            const ImageDiff::Rect &region = result.regions[0];
+            CHECK(region.x == 32 && region.y == 16 && region.width == 5 && region.height == 5);
+        }
+
+        // Either side of a tile border
+        images.b = images.a;
+        images.At(images.b, 15, 0) ^= 1;
+        result = images.Compare(16);
+        CHECK(result.changedTiles == 1 && result.mask[0] == 1);
+        images.b = images.a;
+        images.At(images.b, 16, 15) ^= 1;
+        result = images.Compare(16);
+        CHECK(result.changedTiles == 1 && result.mask[1] == 1);
+
+        // Row padding is not compared
+        images.b = images.a;
+        images.b[images.pitch * 3 + 37 * 4] ^= 0xFF;
+        CHECK(images.Compare(16).changedTiles == 0);
+    });
+}
+
+TEST(image_diff, Tolerance) {
+    Images images(20, 20, 9);
+    uint8_t &pixel = images.At(images.b, 10, 10, 1);
+    pixel = images.At(images.a, 10, 10, 1) < 128 ? pixel + 6 : pixel - 6;
+    CHECK(images.Compare(8, 6).changedTiles == 0);
+    CHECK(images.Compare(8, 5).changedTiles == 1);
+}
+
+TEST(image_diff, Regions) {
+    // Diagonal neighbours form one region, a distant tile its own
+    Images images(64, 64, 11);
+    images.At(images.b, 0, 0) ^= 1;
+    images.At(images.b, 8, 8) ^= 1;
+    images.At(images.b, 60, 60) ^= 1;
+    ImageDiff::Result result = images.Compare(8);
+    CHECK(result.changedTiles == 3);
+    CHECK(result.regions.size() == 2);
+
+    // An L whose bounds contain a separate tile is merged with it
+    images.b = images.a;
+    for (int y = 0; y < 32; y += 8) images.At(images.b, 0, y) ^= 1;
+    for (int x = 0; x < 32; x += 8) images.At(images.b, x, 24) ^= 1;
+    images.At(images.b, 24, 0) ^= 1;
+    result = images.Compare(8);
+    CHECK(result.regions.size() == 1);
+    if (result.regions.size() == 1) {
+        const ImageDiff::Rect &region = result.regions[0];
+        CHECK(region.x == 0 && region.y == 0 && region.width == 32 && region.height == 32);
+    }
+}
+
+TEST(image_diff, FindVerticalShift) {
+    // b is a scrolled by 24 rows
+    Images images(40, 200, 13);
+    for (int y = 0; y + 24 < images.height; ++y) {
+        std::copy_n(images.a.begin() + (y + 24) * images.pitch, images.pitch, images.b.begin() + y * images.pitch);
+    }
+    CHECK(ImageDiff::FindVerticalShift(images.a.data(), images.b.data(), images.width, images.pitch, 0, 150, 1, 100) == 24);
+    CHECK(ImageDiff::FindVerticalShift(images.a.data(), images.a.data(), images.width, images.pitch, 0, 150, 1, 100) == -1);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "bench.hpp"
+#include "image_encode.hpp"
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace {
+
+// A page-like 1080p capture: flat background, text-like noise in bands
+std::vector<uint8_t> MakeCapture(int width, int height) {
+    std::vector<uint8_t> bgra(static_cast<size_t>(width) * height * 4, 0xFF);
+    std::mt19937 random(1);
+    for (int y = 0; y < height; ++y) {
+        if ((y / 20) % 3 != 0) continue;
+        uint8_t *row = bgra.data() + static_cast<size_t>(y) * width * 4;
+        for (int x = 100; x < width - 100; ++x) {
+            const uint8_t value = (random() & 3) == 0 ? static_cast<uint8_t>(random()) : 0xFF;
+            row[x * 4] = row[x * 4 + 1] = row[x * 4 + 2] = value;
+        }
+    }
+    return bgra;
+}
+
+constexpr int width = 1920, height = 1080;
+
+} // namespace
+
+// Throughput is of the uncompressed BGRA input
+BENCH(image_encode, WritePng) {
+    const std::vector<uint8_t> bgra = MakeCapture(width, height);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "webframe_bench.png";
+    for (const int level : {1, 6}) {
+        const double seconds = Bench::Time([&]() { ImageEncode::WritePng(path, bgra.data(), width, height, width * 4, level); });
+        Bench::Report(level == 1 ? "level 1" : "level 6", static_cast<double>(bgra.size()), seconds);
+    }
+    std::filesystem::remove(path);
+}
+
+BENCH(image_encode, WriteQoi) {
+    const std::vector<uint8_t> bgra = MakeCapture(width, height);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "webframe_bench.qoi";
+    const double seconds = Bench::Time([&]() { ImageEncode::WriteQoi(path, bgra.data(), width, height, width * 4); });
+    Bench::Report("file", static_cast<double>(bgra.size()), seconds);
+    std::filesystem::remove(path);
+}
+
+BENCH(image_encode, QoiMemory) {
+    const std::vector<uint8_t> bgra = MakeCapture(width, height);
+    std::vector<uint8_t> ops;
+    Bench::Report("encode", static_cast<double>(bgra.size()), Bench::Time([&]() {
+        ops = ImageEncode::EncodeQoi(bgra.data(), width, height, width * 4);
+    }));
+    std::vector<uint8_t> decoded(bgra.size());
+    Bench::Report("decode", static_cast<double>(bgra.size()), Bench::Time([&]() {
+        ImageEncode::DecodeQoi(ops.data(), ops.size(), decoded.data(), width, height, width * 4);
+    }));
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "test.hpp"
+#include "image_encode.hpp"
+#include "png_reader.hpp"
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using PngReader::DecodePng;
+using PngReader::LoadU32;
+using PngReader::ReadFile;
+
+namespace {
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    size_t pitch = 0;
+    std::vector<uint8_t> bgra;
+};
+
+// Noise over gradients with flat runs, so every filter type and QOI op is used
+Image MakeImage(int width, int height, unsigned seed) {
+    Image image{width, height, static_cast<size_t>(width) * 4 + 12, {}};
+    image.bgra.assign(image.pitch * height, 0xEE); // Row padding must not leak into the output
+    std::mt19937 random(seed);
+    for (int y = 0; y < height; ++y) {
+        uint8_t *row = image.bgra.data() + y * image.pitch;
+        for (int x = 0; x < width; ++x) {
+            uint8_t *p = row + static_cast<size_t>(x) * 4;
+            if ((x / 7 + y / 5) % 3 == 0) {
+                p[0] = p[1] = p[2] = 40;
+                p[3] = 255;
+            } else {
+                p[0] = static_cast<uint8_t>(x + (random() & 3));
+                p[1] = static_cast<uint8_t>(y * 3 + (random() & 1));
+                p[2] = static_cast<uint8_t>(random());
+                p[3] = (random() & 7) == 0 ? static_cast<uint8_t>(random()) : 255;
+            }
+        }
+    }
+    return image;
+}
+
+bool SamePixels(const Image &image, const uint8_t *bgra, size_t pitch) {
+    for (int y = 0; y < image.height; ++y) {
+        if (std::memcmp(image.bgra.data() + y * image.pitch, bgra + y * pitch, static_cast<size_t>(image.width) * 4) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::filesystem::path TempPath(const char *name) {
+    return std::filesystem::temp_directory_path() / name;
+}
+
+// Odd widths, single rows and columns, and images spanning several 256 KB deflate chunks
+constexpr struct {
+    int width;
+    int height;
+} sizes[] = {
+    {1, 1}, {1, 37}, {37, 1}, {3, 5}, {17, 9}, {255, 3},
+    {1001, 300},  // About 4 KB rows, 5 chunks
+    {1, 150000},  // 5 byte rows, 3 chunks
+    {100001, 3},  // Rows larger than a chunk, one chunk each
+};
+
+} // namespace
+
+TEST(image_encode, PngRoundTrip) {
+    const std::filesystem::path path = TempPath("webframe_test_image_encode.png");
+    for (const auto &size : sizes) {
+        const Image image = MakeImage(size.width, size.height, size.width * 31 + size.height);
+        for (const int level : {1, 6}) {
+            CHECK(ImageEncode::WritePng(path, image.bgra.data(), image.width, image.height, image.pitch, level));
+            std::vector<uint8_t> decoded;
+            int width = 0, height = 0;
+            CHECK(DecodePng(ReadFile(path), decoded, width, height));
+            CHECK(width == image.width && height == image.height);
+            if (width == image.width && height == image.height) {
+                CHECK(SamePixels(image, decoded.data(), static_cast<size_t>(width) * 4));
+            }
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(image_encode, PngStreamRoundTrip) {
+    const std::filesystem::path path = TempPath("webframe_test_image_encode_stream.png");
+    for (const auto &size : sizes) {
+        const Image image = MakeImage(size.width, size.height, size.width + size.height);
+        ImageEncode::PngStreamWriter writer;
+        CHECK(writer.Open(path, image.width));
+        // Uneven strips, as the full page capture appends them
+        for (int y = 0, strip = 1; y < image.height; y += strip, strip = strip * 2 + 1) {
+            const int rows = std::min(strip, image.height - y);
+            CHECK(writer.AddRows(image.bgra.data() + y * image.pitch, image.pitch, rows));
+        }
+        CHECK(writer.GetHeight() == image.height);
+        CHECK(writer.Finish());
+
+        std::vector<uint8_t> decoded;
+        int width = 0, height = 0;
+        CHECK(DecodePng(ReadFile(path), decoded, width, height));
+        CHECK(width == image.width && height == image.height);
+        if (width == image.width && height == image.height) {
+            CHECK(SamePixels(image, decoded.data(), static_cast<size_t>(width) * 4));
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(image_encode, QoiRoundTrip) {
+    for (const auto &size : sizes) {
+        const Image image = MakeImage(size.width, size.height, size.width * 7 + size.height);
+        const std::vector<uint8_t> ops = ImageEncode::EncodeQoi(image.bgra.data(), image.width, image.height, image.pitch);
+        CHECK(!ops.empty());
+
+        const size_t pitch = static_cast<size_t>(image.width) * 4;
+        std::vector<uint8_t> decoded(pitch * image.height);
+        CHECK(ImageEncode::DecodeQoi(ops.data(), ops.size(), decoded.data(), image.width, image.height, pitch));
+        CHECK(SamePixels(image, decoded.data(), pitch));
+        // A truncated stream is rejected, not read past
+        if (ops.size() > 1) {
+            CHECK(!ImageEncode::DecodeQoi(ops.data(), ops.size() / 2, decoded.data(), image.width, image.height, pitch));
+        }
+    }
+}
+
+TEST(image_encode, QoiFile) {
+    const std::filesystem::path path = TempPath("webframe_test_image_encode.qoi");
+    for (const auto &size : sizes) {
+        const Image image = MakeImage(size.width, size.height, size.height * 13 + size.width);
+        CHECK(ImageEncode::WriteQoi(path, image.bgra.data(), image.width, image.height, image.pitch));
+
+        // 14 byte header, the op stream, then the 8 byte end marker
+        const std::vector<uint8_t> file = ReadFile(path);
+        constexpr uint8_t endMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+        CHECK(file.size() > 22);
+        if (file.size() <= 22) continue;
+        CHECK(std::memcmp(file.data(), "qoif", 4) == 0);
+        CHECK(LoadU32(&file[4]) == static_cast<uint32_t>(image.width));
+        CHECK(LoadU32(&file[8]) == static_cast<uint32_t>(image.height));
+        CHECK(file[12] == 4);
+        CHECK(std::memcmp(file.data() + file.size() - 8, endMarker, 8) == 0);
+
+        const size_t pitch = static_cast<size_t>(image.width) * 4;
+        std::vector<uint8_t> decoded(pitch * image.height);
+        CHECK(ImageEncode::DecodeQoi(file.data() + 14, file.size() - 22, decoded.data(), image.width, image.height, pitch));
+        CHECK(SamePixels(image, decoded.data(), pitch));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(image_encode, InvalidInput) {
+    const Image image = MakeImage(4, 4, 1);
+    const std::filesystem::path missing = TempPath("webframe_missing_dir") / "sub" / "image.png";
+    CHECK(!ImageEncode::WritePng(missing, image.bgra.data(), 4, 4, image.pitch));
+    CHECK(!ImageEncode::WritePng(TempPath("webframe_unused.png"), image.bgra.data(), 0, 4, image.pitch));
+    CHECK(!ImageEncode::WriteQoi(missing, image.bgra.data(), 4, 4, image.pitch));
+    CHECK(ImageEncode::EncodeQoi(nullptr, 4, 4, image.pitch).empty());
+}
+
+TEST(image_encode, ApngRoundTrip) {
+    const std::filesystem::path path = TempPath("webframe_test_image_encode.apng");
+    // A full canvas, then two partial frames the way the recorder sends changed areas
+    const Image canvas = MakeImage(67, 41, 1);
+    const Image first = MakeImage(10, 7, 2);
+    const Image second = MakeImage(67, 1, 3);
+    struct Frame {
+        const Image *image;
+        int x, y;
+        uint32_t time;
+    };
+    const Frame frames[] = {{&canvas, 0, 0, 0}, {&first, 57, 34, 40}, {&second, 0, 20, 1040}};
+
+    ImageEncode::ApngWriter writer;
+    CHECK(writer.Open(path, canvas.width, canvas.height));
+    // The first frame must cover the canvas
+    CHECK(!writer.AddFrame(first.bgra.data(), first.pitch, 57, 34, first.width, first.height, 0));
+    for (const Frame &frame : frames) {
+        CHECK(writer.AddFrame(frame.image->bgra.data(), frame.image->pitch, frame.x, frame.y, frame.image->width,
+                              frame.image->height, frame.time));
+    }
+    // Outside the canvas
+    CHECK(!writer.AddFrame(first.bgra.data(), first.pitch, 60, 0, first.width, first.height, 1500));
+    CHECK(writer.Finish(1100));
+
+    std::vector<PngReader::Chunk> chunks;
+    CHECK(PngReader::ReadChunks(ReadFile(path), chunks));
+    // Each frame is small enough for one data chunk
+    const char *types[] = {"IHDR", "acTL", "fcTL", "IDAT", "fcTL", "fdAT", "fcTL", "fdAT", "IEND"};
+    CHECK(chunks.size() == std::size(types));
+    if (chunks.size() != std::size(types)) return;
+    for (size_t i = 0; i < chunks.size(); ++i) CHECK(chunks[i].type == types[i]);
+
+    // Patched by Finish(): the frame count, looping forever
+    CHECK(chunks[1].data.size() == 8);
+    CHECK(LoadU32(chunks[1].data.data()) == 3);
+    CHECK(LoadU32(chunks[1].data.data() + 4) == 0);
+
+    // fcTL and fdAT share one sequence, counting up from 0 without gaps
+    uint32_t sequence = 0;
+    for (const PngReader::Chunk &chunk : chunks) {
+        if (chunk.type == "fcTL" || chunk.type == "fdAT") CHECK(LoadU32(chunk.data.data()) == sequence++);
+    }
+    CHECK(sequence == 5);
+
+    size_t frameIndex = 0;
+    for (size_t i = 2; i < chunks.size() && frameIndex < 3; ++i) {
+        if (chunks[i].type != "fcTL") continue;
+        const Frame &frame = frames[frameIndex];
+        const uint8_t *fctl = chunks[i].data.data();
+        CHECK(chunks[i].data.size() == 26);
+        CHECK(LoadU32(fctl + 4) == static_cast<uint32_t>(frame.image->width));
+        CHECK(LoadU32(fctl + 8) == static_cast<uint32_t>(frame.image->height));
+        CHECK(LoadU32(fctl + 12) == static_cast<uint32_t>(frame.x));
+        CHECK(LoadU32(fctl + 16) == static_cast<uint32_t>(frame.y));
+        // Shown until the next frame's time, the last one until Finish(), in milliseconds
+        const uint32_t end = frameIndex + 1 < 3 ? frames[frameIndex + 1].time : 1100;
+        CHECK((fctl[20] << 8 | fctl[21]) == static_cast<int>(end - frame.time));
+        CHECK((fctl[22] << 8 | fctl[23]) == 1000);
+
+        // Frame data, after the sequence number for fdAT
+        std::vector<uint8_t> zlib;
+        for (size_t j = i + 1; j < chunks.size() && (chunks[j].type == "IDAT" || chunks[j].type == "fdAT"); ++j) {
+            const size_t skip = chunks[j].type == "fdAT" ? 4 : 0;
+            zlib.insert(zlib.end(), chunks[j].data.begin() + skip, chunks[j].data.end());
+        }
+        std::vector<uint8_t> decoded;
+        CHECK(PngReader::Unfilter(zlib, frame.image->width, frame.image->height, decoded));
+        CHECK(SamePixels(*frame.image, decoded.data(), static_cast<size_t>(frame.image->width) * 4));
+        ++frameIndex;
+    }
+    CHECK(frameIndex == 3);
+    std::filesystem::remove(path);
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "test.hpp"
+#include "image_filter.hpp"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+// A rectangle of a larger image, the filters must only touch the rectangle
+struct Canvas {
+    int width = 0;
+    int height = 0;
+    size_t pitch = 0;
+    std::vector<uint8_t> bgra;
+
+    Canvas(int width, int height, unsigned seed) : width(width), height(height), pitch(static_cast<size_t>(width) * 4 + 8) {
+        std::mt19937 random(seed);
+        bgra.resize(pitch * height);
+        for (uint8_t &byte : bgra) byte = static_cast<uint8_t>(random());
+    }
+
+    // Tightly packed copy of a rectangle
+    std::vector<uint8_t> Extract(int x, int y, int w, int h) const {
+        std::vector<uint8_t> out(static_cast<size_t>(w) * h * 4);
+        for (int row = 0; row < h; ++row) {
+            std::memcpy(out.data() + static_cast<size_t>(row) * w * 4, bgra.data() + (y + row) * pitch + x * 4,
+                        static_cast<size_t>(w) * 4);
+        }
+        return out;
+    }
+};
+
+uint8_t Round(int sum, float scale) {
+    return static_cast<uint8_t>(static_cast<float>(sum) * scale + 0.5f);
+}
+
+// Three horizontal then three vertical box passes, each window summed directly with
+// clamped indices and rounded half up, the order and rounding BoxBlur documents
+std::vector<uint8_t> BoxBlurReference(std::vector<uint8_t> pixels, int width, int height, int radius) {
+    const float scale = 1.0f / static_cast<float>(2 * radius + 1);
+    std::vector<uint8_t> source;
+    for (int pass = 0; pass < 3; ++pass) {
+        source = pixels;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                for (int c = 0; c < 4; ++c) {
+                    int sum = 0;
+                    for (int i = -radius; i <= radius; ++i) sum += source[(y * width + std::clamp(x + i, 0, width - 1)) * 4 + c];
+                    pixels[(y * width + x) * 4 + c] = Round(sum, scale);
+                }
+            }
+        }
+    }
+    for (int pass = 0; pass < 3; ++pass) {
+        source = pixels;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                for (int c = 0; c < 4; ++c) {
+                    int sum = 0;
+                    for (int i = -radius; i <= radius; ++i) sum += source[(std::clamp(y + i, 0, height - 1) * width + x) * 4 + c];
+                    pixels[(y * width + x) * 4 + c] = Round(sum, scale);
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+std::vector<uint8_t> PixelateReference(std::vector<uint8_t> pixels, int width, int height, int blockSize) {
+    for (int top = 0; top < height; top += blockSize) {
+        for (int left = 0; left < width; left += blockSize) {
+            const int right = std::min(width, left + blockSize), bottom = std::min(height, top + blockSize);
+            const uint64_t count = static_cast<uint64_t>(right - left) * (bottom - top);
+            for (int c = 0; c < 4; ++c) {
+                uint64_t sum = 0;
+                for (int y = top; y < bottom; ++y) {
+                    for (int x = left; x < right; ++x) sum += pixels[(y * width + x) * 4 + c];
+                }
+                const uint8_t average = static_cast<uint8_t>((sum + count / 2) / count);
+                for (int y = top; y < bottom; ++y) {
+                    for (int x = left; x < right; ++x) pixels[(y * width + x) * 4 + c] = average;
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+// Everything outside the rectangle, row padding included, is unchanged
+bool OutsideUnchanged(const Canvas &before, const Canvas &after, int x, int y, int w, int h) {
+    for (int row = 0; row < before.height; ++row) {
+        for (size_t i = 0; i < before.pitch; ++i) {
+            const bool inside = row >= y && row < y + h && i >= static_cast<size_t>(x) * 4 && i < static_cast<size_t>(x + w) * 4;
+            if (!inside && before.bgra[row * before.pitch + i] != after.bgra[row * after.pitch + i]) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(image_filter, BoxBlurMatchesReference) {
+    struct Case {
+        int x, y, width, height, radius;
+    };
+    const Case cases[] = {
+        {3, 2, 37, 21, 1},  {0, 0, 64, 64, 4},  {5, 1, 17, 9, 3},
+        {2, 3, 1, 15, 2},   {2, 3, 15, 1, 2},   // A single column or row
+        {4, 4, 23, 6, 9},   {1, 1, 7, 5, 40},   // Radius reaching past the rectangle on both sides
+        {0, 0, 130, 70, 6},                     // Several 64 pixel stripes and a partial one
+    };
+    for (const Case &test : cases) {
+        Canvas canvas(test.x + test.width + 5, test.y + test.height + 4, static_cast<unsigned>(test.width * 7 + test.radius));
+        const Canvas before = canvas;
+        const std::vector<uint8_t> expected =
+            BoxBlurReference(canvas.Extract(test.x, test.y, test.width, test.height), test.width, test.height, test.radius);
+        ImageFilter::BoxBlur(canvas.bgra.data(), canvas.pitch, test.x, test.y, test.width, test.height, test.radius);
+        CHECK(canvas.Extract(test.x, test.y, test.width, test.height) == expected);
+        CHECK(OutsideUnchanged(before, canvas, test.x, test.y, test.width, test.height));
+    }
+}
+
+TEST(image_filter, BoxBlurLargeRectangle) {
+    // Over the threshold where rows and stripes are split across cores
+    Canvas canvas(620, 460, 17);
+    const Canvas before = canvas;
+    const std::vector<uint8_t> expected = BoxBlurReference(canvas.Extract(10, 10, 600, 440), 600, 440, 3);
+    ImageFilter::BoxBlur(canvas.bgra.data(), canvas.pitch, 10, 10, 600, 440, 3);
+    CHECK(canvas.Extract(10, 10, 600, 440) == expected);
+    CHECK(OutsideUnchanged(before, canvas, 10, 10, 600, 440));
+}
+
+TEST(image_filter, PixelateMatchesReference) {
+    struct Case {
+        int x, y, width, height, blockSize;
+    };
+    const Case cases[] = {
+        {3, 2, 37, 21, 8}, {0, 0, 32, 32, 8},  // Remainder blocks, exact blocks
+        {1, 1, 23, 17, 5}, {2, 0, 3, 4, 10},   // Block larger than the rectangle
+        {0, 0, 700, 3, 600},                   // Rows wider than the 16-bit lane sums hold at once
+        {4, 3, 1, 9, 2},
+    };
+    for (const Case &test : cases) {
+        Canvas canvas(test.x + test.width + 3, test.y + test.height + 2, static_cast<unsigned>(test.height * 5 + test.blockSize));
+        const Canvas before = canvas;
+        const std::vector<uint8_t> expected =
+            PixelateReference(canvas.Extract(test.x, test.y, test.width, test.height), test.width, test.height, test.blockSize);
+        ImageFilter::Pixelate(canvas.bgra.data(), canvas.pitch, test.x, test.y, test.width, test.height, test.blockSize);
+        CHECK(canvas.Extract(test.x, test.y, test.width, test.height) == expected);
+        CHECK(OutsideUnchanged(before, canvas, test.x, test.y, test.width, test.height));
+    }
+}
+
+TEST(image_filter, NoOpArguments) {
+    Canvas canvas(8, 8, 3);
+    const Canvas before = canvas;
+    ImageFilter::BoxBlur(canvas.bgra.data(), canvas.pitch, 0, 0, 8, 8, 0);
+    ImageFilter::BoxBlur(canvas.bgra.data(), canvas.pitch, 0, 0, 0, 8, 3);
+    ImageFilter::Pixelate(canvas.bgra.data(), canvas.pitch, 0, 0, 8, 8, 1);
+    ImageFilter::Pixelate(canvas.bgra.data(), canvas.pitch, 0, 0, 8, 0, 4);
+    CHECK(canvas.bgra == before.bgra);
+}
\ No newline at end of file
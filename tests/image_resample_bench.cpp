@@ -0,0 +1,20 @@
+#include "bench.hpp"
+#include "image_resample.hpp"
+#include <vector>
+
+// A 4K capture shrunk to a typical panel preview, the work BuildPreview does per capture
+BENCH(image_resample, Preview) {
+    constexpr int width = 3840, height = 2160, previewWidth = 1000, previewHeight = 563;
+    const size_t pitch = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> src(pitch * height), dst(static_cast<size_t>(previewWidth) * previewHeight * 4);
+    for (size_t i = 0; i < src.size(); ++i) src[i] = static_cast<uint8_t>(i * 7 + i / pitch);
+
+    const double resize = Bench::Time([&]() {
+        ImageResample::Resize(src.data(), width, height, pitch, dst.data(), previewWidth, previewHeight, previewWidth * 4, false);
+    });
+    Bench::Report("Resize", static_cast<double>(src.size()), resize);
+    const double downscale = Bench::Time([&]() {
+        ImageResample::Downscale(src.data(), width, height, pitch, dst.data(), previewWidth, previewHeight, previewWidth * 4);
+    });
+    Bench::Report("Downscale", static_cast<double>(src.size()), downscale);
+}
\ No newline at end of file
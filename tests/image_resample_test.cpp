@@ -0,0 +1,263 @@
+#include "test.hpp"
+#include "image_resample.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    size_t pitch = 0;
+    std::vector<uint8_t> bgra;
+
+    Image(int width, int height, size_t padding = 0)
+        : width(width), height(height), pitch(static_cast<size_t>(width) * 4 + padding), bgra(pitch * height) {}
+
+    static Image Random(int width, int height, unsigned seed) {
+        Image image(width, height, 12);
+        std::mt19937 random(seed);
+        for (uint8_t &byte : image.bgra) byte = static_cast<uint8_t>(random());
+        return image;
+    }
+
+    uint8_t *At(int x, int y) { return bgra.data() + y * pitch + static_cast<size_t>(x) * 4; }
+    const uint8_t *At(int x, int y) const { return bgra.data() + y * pitch + static_cast<size_t>(x) * 4; }
+};
+
+// Each destination pixel summed directly over its bin, the mapping Downscale documents
+Image DownscaleReference(const Image &src, int dstWidth, int dstHeight) {
+    Image dst(dstWidth, dstHeight);
+    for (int y = 0; y < dstHeight; ++y) {
+        const int top = static_cast<int>(static_cast<int64_t>(y) * src.height / dstHeight);
+        const int bottom = static_cast<int>(static_cast<int64_t>(y + 1) * src.height / dstHeight);
+        for (int x = 0; x < dstWidth; ++x) {
+            const int left = static_cast<int>(static_cast<int64_t>(x) * src.width / dstWidth);
+            const int right = static_cast<int>(static_cast<int64_t>(x + 1) * src.width / dstWidth);
+            const uint64_t count = static_cast<uint64_t>(right - left) * (bottom - top);
+            for (int c = 0; c < 4; ++c) {
+                uint64_t sum = 0;
+                for (int sy = top; sy < bottom; ++sy) {
+                    for (int sx = left; sx < right; ++sx) sum += src.At(sx, sy)[c];
+                }
+                dst.At(x, y)[c] = static_cast<uint8_t>((sum + count / 2) / count);
+            }
+        }
+    }
+    return dst;
+}
+
+// Taps of one destination pixel along an axis as Resize documents them: coverage
+// when shrinking, bilinear between the two nearest pixel centres when enlarging
+std::vector<std::pair<int, double>> AxisWeights(int i, int srcSize, int dstSize) {
+    std::vector<std::pair<int, double>> taps;
+    const double ratio = static_cast<double>(srcSize) / dstSize;
+    if (ratio > 1.0) {
+        const double start = i * ratio, end = start + ratio;
+        for (int s = static_cast<int>(start); s < srcSize && s < end; ++s) {
+            taps.push_back({s, (std::min<double>(s + 1, end) - std::max<double>(s, start)) / ratio});
+        }
+    } else {
+        const double center = (i + 0.5) * ratio - 0.5;
+        const int left = static_cast<int>(std::floor(center));
+        const double t = center - left;
+        taps.push_back({std::clamp(left, 0, srcSize - 1), 1.0 - t});
+        taps.push_back({std::clamp(left + 1, 0, srcSize - 1), t});
+    }
+    return taps;
+}
+
+double ToLinear(double v) { return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4); }
+double ToSrgb(double v) { return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055; }
+
+// Resize in double precision with the exact sRGB curves
+Image ResizeReference(const Image &src, int dstWidth, int dstHeight, bool gammaCorrect) {
+    Image dst(dstWidth, dstHeight);
+    for (int y = 0; y < dstHeight; ++y) {
+        const auto rows = AxisWeights(y, src.height, dstHeight);
+        for (int x = 0; x < dstWidth; ++x) {
+            const auto columns = AxisWeights(x, src.width, dstWidth);
+            double sum[4] = {};
+            for (const auto &[sy, wy] : rows) {
+                for (const auto &[sx, wx] : columns) {
+                    const uint8_t *p = src.At(sx, sy);
+                    const double alpha = p[3] / 255.0;
+                    for (int c = 0; c < 3; ++c) sum[c] += wx * wy * (gammaCorrect ? ToLinear(p[c] / 255.0) * alpha : p[c] / 255.0);
+                    sum[3] += wx * wy * alpha;
+                }
+            }
+            uint8_t *out = dst.At(x, y);
+            const double alpha = std::clamp(sum[3], 0.0, 1.0);
+            for (int c = 0; c < 3; ++c) {
+                double v = sum[c];
+                if (gammaCorrect) v = alpha > 0.0 ? ToSrgb(std::clamp(v / alpha, 0.0, 1.0)) : 0.0;
+                out[c] = static_cast<uint8_t>(std::lround(std::clamp(v, 0.0, 1.0) * 255.0));
+            }
+            out[3] = static_cast<uint8_t>(std::lround(alpha * 255.0));
+        }
+    }
+    return dst;
+}
+
+// Largest difference of any channel
+int MaxDifference(const Image &a, const Image &b) {
+    int difference = 0;
+    for (int y = 0; y < a.height; ++y) {
+        for (int x = 0; x < a.width * 4; ++x) difference = std::max(difference, std::abs(a.At(0, y)[x] - b.At(0, y)[x]));
+    }
+    return difference;
+}
+
+Image Resize(const Image &src, int dstWidth, int dstHeight, bool gammaCorrect) {
+    Image dst(dstWidth, dstHeight, 4);
+    ImageResample::Resize(src.bgra.data(), src.width, src.height, src.pitch, dst.bgra.data(), dstWidth, dstHeight, dst.pitch, gammaCorrect);
+    return dst;
+}
+
+} // namespace
+
+TEST(image_resample, ResizeMatchesReference) {
+    struct Case {
+        int srcWidth, srcHeight, dstWidth, dstHeight;
+    };
+    // Integer and non-integer ratios, shrinking and enlarging, mixed per axis
+    constexpr Case cases[] = {
+        {64, 48, 32, 24}, {100, 75, 33, 29}, {37, 19, 37, 19}, {7, 5, 16, 11},
+        {10, 90, 31, 13}, {3, 3, 1, 1},      {1, 1, 5, 3},     {250, 40, 9, 8},
+    };
+    unsigned seed = 11;
+    for (const Case &c : cases) {
+        const Image src = Image::Random(c.srcWidth, c.srcHeight, seed++);
+        for (const bool gammaCorrect : {false, true}) {
+            // The float kernels and the 4096 entry sRGB table are a unit off at most
+            CHECK(MaxDifference(Resize(src, c.dstWidth, c.dstHeight, gammaCorrect),
+                                ResizeReference(src, c.dstWidth, c.dstHeight, gammaCorrect)) <= 1);
+        }
+    }
+}
+
+TEST(image_resample, GammaCorrectAverage) {
+    // Black and white columns average to half the light, sRGB 188, not half the code value
+    Image stripes(8, 4);
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            uint8_t *p = stripes.At(x, y);
+            p[0] = p[1] = p[2] = x % 2 ? 255 : 0;
+            p[3] = 255;
+        }
+    }
+    const Image linear = Resize(stripes, 4, 2, false);
+    const Image gamma = Resize(stripes, 4, 2, true);
+    CHECK(std::abs(linear.At(1, 1)[0] - 128) <= 1);
+    CHECK(std::abs(gamma.At(1, 1)[0] - 188) <= 1);
+    CHECK(gamma.At(1, 1)[3] == 255);
+}
+
+TEST(image_resample, PremultipliedAlpha) {
+    // A transparent red pixel next to an opaque green one
+    Image pair(2, 1);
+    const uint8_t transparentRed[4] = {0, 0, 255, 0}, green[4] = {0, 255, 0, 255};
+    std::memcpy(pair.At(0, 0), transparentRed, 4);
+    std::memcpy(pair.At(1, 0), green, 4);
+
+    // Weighted by alpha the invisible red does not bleed, the result is half transparent green
+    const Image gamma = Resize(pair, 1, 1, true);
+    CHECK(gamma.At(0, 0)[2] == 0);
+    CHECK(gamma.At(0, 0)[1] == 255);
+    CHECK(std::abs(gamma.At(0, 0)[3] - 128) <= 1);
+
+    // Plain averaging mixes the stored channels
+    const Image plain = Resize(pair, 1, 1, false);
+    CHECK(std::abs(plain.At(0, 0)[2] - 128) <= 1);
+    CHECK(std::abs(plain.At(0, 0)[1] - 128) <= 1);
+
+    // Fully transparent areas stay transparent black rather than dividing by zero
+    Image clear(6, 6);
+    CHECK(Resize(clear, 4, 4, true).bgra == Image(4, 4, 4).bgra);
+}
+
+TEST(image_resample, UniformColourAtAnyRatio) {
+    Image flat(97, 61);
+    for (int y = 0; y < flat.height; ++y) {
+        for (int x = 0; x < flat.width; ++x) {
+            const uint8_t colour[4] = {10, 200, 30, 255};
+            std::memcpy(flat.At(x, y), colour, 4);
+        }
+    }
+    // The weights of every destination pixel sum to one
+    for (const bool gammaCorrect : {false, true}) {
+        for (const auto &[w, h] : {std::pair{13, 7}, std::pair{60, 59}, std::pair{150, 100}}) {
+            const Image out = Resize(flat, w, h, gammaCorrect);
+            bool uniform = true;
+            for (int y = 0; y < h; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    const uint8_t *p = out.At(x, y);
+                    uniform = uniform && std::abs(p[0] - 10) <= 1 && std::abs(p[1] - 200) <= 1 && std::abs(p[2] - 30) <= 1 && p[3] == 255;
+                }
+            }
+            CHECK(uniform);
+        }
+    }
+}
+
+TEST(image_resample, DownscaleMatchesReference) {
+    struct Case {
+        int srcWidth, srcHeight, dstWidth, dstHeight;
+    };
+    // Integer and fractional ratios, bins narrower and wider than the 4-pixel SIMD step, unchanged axes
+    constexpr Case cases[] = {
+        {64, 48, 16, 12}, {100, 75, 33, 29}, {37, 19, 37, 19}, {250, 3, 7, 1},
+        {9, 211, 2, 50},  {1, 1, 1, 1},      {1000, 9, 1, 9},  {513, 130, 200, 129},
+    };
+    unsigned seed = 1;
+    for (const Case &c : cases) {
+        const Image src = Image::Random(c.srcWidth, c.srcHeight, seed++);
+        const Image expected = DownscaleReference(src, c.dstWidth, c.dstHeight);
+
+        Image dst(c.dstWidth, c.dstHeight, 8);
+        CHECK(ImageResample::Downscale(src.bgra.data(), src.width, src.height, src.pitch,
+                                       dst.bgra.data(), dst.width, dst.height, dst.pitch));
+        bool same = true;
+        for (int y = 0; y < dst.height; ++y) {
+            same = same && memcmp(dst.At(0, y), expected.At(0, y), static_cast<size_t>(dst.width) * 4) == 0;
+        }
+        CHECK(same);
+    }
+}
+
+TEST(image_resample, DownscaleAreaMatchesFull) {
+    const Image src = Image::Random(301, 187, 7);
+    constexpr int dstWidth = 120, dstHeight = 77;
+    Image full(dstWidth, dstHeight);
+    CHECK(ImageResample::Downscale(src.bgra.data(), src.width, src.height, src.pitch, full.bgra.data(), dstWidth, dstHeight, full.pitch));
+
+    // Areas at the edges and in the middle, written to a buffer of their own size
+    constexpr int areas[][4] = {{0, 0, dstWidth, dstHeight}, {0, 0, 32, 32}, {96, 64, 24, 13}, {37, 5, 1, 70}, {119, 76, 1, 1}};
+    for (const auto &area : areas) {
+        const int x = area[0], y = area[1], width = area[2], height = area[3];
+        Image part(width, height, 4);
+        CHECK(ImageResample::DownscaleArea(src.bgra.data(), src.width, src.height, src.pitch, dstWidth, dstHeight,
+                                           x, y, width, height, part.bgra.data(), part.pitch));
+        bool same = true;
+        for (int row = 0; row < height; ++row) {
+            same = same && memcmp(part.At(0, row), full.At(x, y + row), static_cast<size_t>(width) * 4) == 0;
+        }
+        CHECK(same);
+    }
+}
+
+TEST(image_resample, DownscaleRejectsEnlarging) {
+    const Image src = Image::Random(10, 10, 3);
+    Image dst(11, 10);
+    const std::vector<uint8_t> untouched = dst.bgra;
+    CHECK(!ImageResample::Downscale(src.bgra.data(), 10, 10, src.pitch, dst.bgra.data(), 11, 10, dst.pitch));
+    CHECK(!ImageResample::Downscale(src.bgra.data(), 10, 10, src.pitch, dst.bgra.data(), 10, 11, dst.pitch));
+    CHECK(!ImageResample::Downscale(src.bgra.data(), 10, 10, src.pitch, dst.bgra.data(), 0, 5, dst.pitch));
+    CHECK(!ImageResample::DownscaleArea(src.bgra.data(), 10, 10, src.pitch, 5, 5, 3, 0, 3, 5, dst.bgra.data(), dst.pitch));
+    CHECK(dst.bgra == untouched);
+}
\ No newline at end of file
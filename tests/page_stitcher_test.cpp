@@ -0,0 +1,155 @@
+#include "test.hpp"
+#include "page_stitcher.hpp"
+#include "png_reader.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+// A page of pageRows scrolling rows under a fixed header and footer. Rows are
+// unique and change smoothly, so a viewport between two rows is close to both.
+constexpr int width = 48, headerRows = 12, footerRows = 10, viewportRows = 100, pageRows = 240;
+constexpr int contentRows = viewportRows - headerRows - footerRows;
+constexpr int maxScroll = pageRows - contentRows;
+
+void PagePixel(int x, int y, double out[4]) {
+    out[0] = y;
+    out[1] = static_cast<double>(y * y) / pageRows;
+    out[2] = x * 5;
+    out[3] = 255;
+}
+
+void FixedPixel(int x, int y, bool header, uint8_t out[4]) {
+    out[0] = header ? 200 : 30;
+    out[1] = static_cast<uint8_t>(x * 3 + y);
+    out[2] = header ? 90 : 160;
+    out[3] = 255;
+}
+
+// The viewport at a scroll position, a fractional one blends the two page rows it falls between
+std::vector<uint8_t> RenderViewport(double scroll) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * viewportRows * 4);
+    for (int y = 0; y < viewportRows; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t *p = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+            if (y < headerRows || y >= viewportRows - footerRows) {
+                FixedPixel(x, y, y < headerRows, p);
+                continue;
+            }
+            const double position = scroll + (y - headerRows);
+            const int above = static_cast<int>(std::floor(position));
+            const double t = position - above;
+            double a[4], b[4];
+            PagePixel(x, above, a);
+            PagePixel(x, std::min(above + 1, pageRows - 1), b);
+            for (int c = 0; c < 4; ++c) p[c] = static_cast<uint8_t>(std::lround(a[c] * (1.0 - t) + b[c] * t));
+        }
+    }
+    return pixels;
+}
+
+std::filesystem::path TempPath(const char *name) {
+    return std::filesystem::temp_directory_path() / name;
+}
+
+// Stitches viewports at the given scroll positions, each hinted with the rounded distance scrolled
+bool Stitch(const std::filesystem::path &path, const std::vector<double> &scrolls, PageStitcher &stitcher) {
+    stitcher.Begin(path, 1);
+    long previous = 0;
+    for (const double scroll : scrolls) {
+        const long rounded = std::lround(scroll);
+        if (stitcher.AddFrame(RenderViewport(scroll), width, viewportRows, static_cast<int>(rounded - previous)) < 0) return false;
+        previous = rounded;
+    }
+    return stitcher.Finish();
+}
+
+// The stitched file is header, the whole page and footer, content rows within tolerance
+bool MatchesPage(const std::filesystem::path &path, int tolerance) {
+    std::vector<uint8_t> bgra;
+    int w = 0, h = 0;
+    if (!PngReader::DecodePng(PngReader::ReadFile(path), bgra, w, h)) return false;
+    if (w != width || h != headerRows + pageRows + footerRows) return false;
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint8_t *p = bgra.data() + (static_cast<size_t>(y) * width + x) * 4;
+            if (y < headerRows || y >= headerRows + pageRows) {
+                uint8_t expected[4];
+                FixedPixel(x, y < headerRows ? y : y - maxScroll, y < headerRows, expected);
+                for (int c = 0; c < 4; ++c) {
+                    if (p[c] != expected[c]) return false;
+                }
+                continue;
+            }
+            double expected[4];
+            PagePixel(x, y - headerRows, expected);
+            for (int c = 0; c < 4; ++c) {
+                if (std::abs(p[c] - static_cast<int>(std::lround(expected[c]))) > tolerance) return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(page_stitcher, WholeRowScroll) {
+    const std::filesystem::path path = TempPath("webframe_test_stitch.png");
+    PageStitcher stitcher;
+    CHECK(Stitch(path, {0, 50, 100, 150, maxScroll}, stitcher));
+
+    // Header and footer found and written once, every page row exactly once in between
+    CHECK(stitcher.GetFrames() == 5);
+    CHECK(stitcher.GetScrollingRows() == contentRows);
+    CHECK(stitcher.GetInexactFrames() == 0);
+    CHECK(stitcher.GetHeight() == headerRows + pageRows + footerRows);
+    CHECK(MatchesPage(path, 0));
+    std::filesystem::remove(path);
+}
+
+TEST(page_stitcher, FractionalScroll) {
+    // A zoomed page scrolls by fractions of a device pixel, no shift matches those frames exactly
+    const std::filesystem::path path = TempPath("webframe_test_stitch_fraction.png");
+    PageStitcher stitcher;
+    CHECK(Stitch(path, {0, 50, 100.5, 151, maxScroll}, stitcher));
+
+    // Placed by the hinted scroll position instead, off by at most half a row
+    CHECK(stitcher.GetInexactFrames() > 0);
+    CHECK(stitcher.GetHeight() == headerRows + pageRows + footerRows);
+    CHECK(MatchesPage(path, 2));
+    std::filesystem::remove(path);
+}
+
+TEST(page_stitcher, SingleFrame) {
+    const std::filesystem::path path = TempPath("webframe_test_stitch_single.png");
+    PageStitcher stitcher;
+    stitcher.Begin(path);
+    CHECK(stitcher.AddFrame(RenderViewport(0), width, viewportRows, 0) == 0);
+    CHECK(stitcher.Finish());
+
+    // Written whole, with nothing to tell a header from content
+    std::vector<uint8_t> bgra;
+    int w = 0, h = 0;
+    CHECK(PngReader::DecodePng(PngReader::ReadFile(path), bgra, w, h));
+    CHECK(w == width && h == viewportRows);
+    CHECK(bgra == RenderViewport(0));
+    std::filesystem::remove(path);
+}
+
+TEST(page_stitcher, InvalidFrames) {
+    const std::filesystem::path path = TempPath("webframe_test_stitch_invalid.png");
+    PageStitcher stitcher;
+    stitcher.Begin(path);
+    CHECK(!stitcher.Finish());
+
+    stitcher.Begin(path);
+    CHECK(stitcher.AddFrame(std::vector<uint8_t>(16), width, viewportRows, 0) == -1);
+    CHECK(stitcher.AddFrame(RenderViewport(0), width, viewportRows, 0) == 0);
+    // The viewport was resized while scrolling
+    CHECK(stitcher.AddFrame(RenderViewport(50), width, viewportRows - 1, 50) == -1);
+    CHECK(stitcher.Finish());
+    std::filesystem::remove(path);
+}
\ No newline at end of file
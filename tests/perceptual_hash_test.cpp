@@ -0,0 +1,85 @@
+#include "test.hpp"
+#include "perceptual_hash.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace {
+
+// Renders shade(u, v) over [0, 1) into a grey BGRA image with padded rows
+struct Image {
+    int width = 0;
+    int height = 0;
+    size_t pitch = 0;
+    std::vector<uint8_t> bgra;
+
+    Image(int width, int height, const std::function<int(double, double)> &shade)
+        : width(width), height(height), pitch(static_cast<size_t>(width) * 4 + 12), bgra(pitch * height) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) Set(x, y, shade(static_cast<double>(x) / width, static_cast<double>(y) / height));
+        }
+    }
+
+    void Set(int x, int y, int value) {
+        uint8_t *p = bgra.data() + y * pitch + static_cast<size_t>(x) * 4;
+        p[0] = p[1] = p[2] = static_cast<uint8_t>(value);
+        p[3] = 255;
+    }
+
+    uint64_t Hash() const { return PerceptualHash::DHash(bgra.data(), width, height, pitch); }
+};
+
+// Smooth content with brightness changing in both directions, like a page with large areas
+int Landscape(double u, double v) {
+    return static_cast<int>(128 + 60 * std::sin(u * 11.0 + v * 3.0) + 50 * std::cos(v * 7.0 - u * 5.0));
+}
+
+} // namespace
+
+TEST(perceptual_hash, InvalidInput) {
+    const uint8_t pixel[4] = {};
+    CHECK(PerceptualHash::DHash(nullptr, 4, 4, 16) == 0);
+    CHECK(PerceptualHash::DHash(pixel, 0, 1, 4) == 0);
+    CHECK(PerceptualHash::DHash(pixel, 1, 0, 4) == 0);
+}
+
+TEST(perceptual_hash, BitsCompareNeighbours) {
+    // Every sample brighter than its right neighbour sets every bit, darker clears them
+    CHECK(Image(90, 40, [](double u, double) { return static_cast<int>(255 - u * 255); }).Hash() == ~0ull);
+    CHECK(Image(90, 40, [](double u, double) { return static_cast<int>(u * 255); }).Hash() == 0);
+    CHECK(Image(37, 23, [](double, double) { return 200; }).Hash() == 0);
+
+    // Bits run row by row from the top, the first row's are the highest
+    const uint64_t topDark = Image(90, 80, [](double u, double v) { return v < 0.125 ? static_cast<int>(255 - u * 255) : 100; }).Hash();
+    CHECK(topDark == 0xFFull << 56);
+}
+
+TEST(perceptual_hash, IgnoresPitchAndScale) {
+    const Image large(640, 480, Landscape);
+    const Image small(320, 240, Landscape);
+    CHECK(PerceptualHash::Distance(large.Hash(), small.Hash()) <= 2);
+
+    // The same pixels in tightly packed rows
+    std::vector<uint8_t> packed(static_cast<size_t>(large.width) * large.height * 4);
+    for (int y = 0; y < large.height; ++y) {
+        std::copy_n(large.bgra.data() + y * large.pitch, large.width * 4, packed.data() + static_cast<size_t>(y) * large.width * 4);
+    }
+    CHECK(PerceptualHash::DHash(packed.data(), large.width, large.height, static_cast<size_t>(large.width) * 4) == large.Hash());
+}
+
+TEST(perceptual_hash, NearDuplicatesStayClose) {
+    const Image original(800, 600, Landscape);
+
+    // A blinking caret and a changed clock digit
+    Image edited = original;
+    for (int y = 300; y < 318; ++y) edited.Set(410, y, 0);
+    for (int y = 580; y < 592; ++y) {
+        for (int x = 760; x < 768; ++x) edited.Set(x, y, 255);
+    }
+    CHECK(PerceptualHash::Distance(original.Hash(), edited.Hash()) <= 2);
+
+    // Different content is far apart
+    const Image mirrored(800, 600, [](double u, double v) { return Landscape(1.0 - u, v); });
+    CHECK(PerceptualHash::Distance(original.Hash(), mirrored.Hash()) > 16);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "bench.hpp"
+#include "pixel_convert.hpp"
+#include <cstdio>
+#include <vector>
+
+// A 1080p capture, converted like the clipboard does
+BENCH(pixel_convert, BGRAToBGRFlipped) {
+    constexpr int width = 1920, height = 1080;
+    const size_t srcPitch = static_cast<size_t>(width) * 4;
+    const size_t dstPitch = (static_cast<size_t>(width) * 3 + 3) & ~size_t(3);
+    std::vector<uint8_t> src(srcPitch * height, 0x5A), dst(dstPitch * height);
+
+    for (const PixelConvert::Isa isa : {PixelConvert::Isa::Scalar, PixelConvert::Isa::SSSE3, PixelConvert::Isa::AVX2}) {
+        PixelConvert::SetMaxIsa(isa);
+        if (PixelConvert::GetActiveIsa() != isa) continue;
+        const double seconds = Bench::Time([&]() {
+            PixelConvert::BGRAToBGRFlipped(src.data(), srcPitch, dst.data(), dstPitch, width, height);
+        });
+        Bench::Report(PixelConvert::GetIsaName(isa), static_cast<double>(src.size()), seconds);
+    }
+    PixelConvert::SetMaxIsa(PixelConvert::Isa::AVX2);
+}
+
+BENCH(pixel_convert, SwapRedBlue) {
+    constexpr size_t width = 1920, height = 1080;
+    std::vector<uint8_t> pixels(width * height * 4, 0x5A);
+
+    for (const PixelConvert::Isa isa : {PixelConvert::Isa::Scalar, PixelConvert::Isa::SSSE3, PixelConvert::Isa::AVX2}) {
+        PixelConvert::SetMaxIsa(isa);
+        if (PixelConvert::GetActiveIsa() != isa) continue;
+        const double seconds = Bench::Time([&]() {
+            for (size_t y = 0; y < height; ++y) {
+                uint8_t *row = pixels.data() + y * width * 4;
+                PixelConvert::SwapRedBlue(row, row, width);
+            }
+        });
+        Bench::Report(PixelConvert::GetIsaName(isa), static_cast<double>(pixels.size()), seconds);
+    }
+    PixelConvert::SetMaxIsa(PixelConvert::Isa::AVX2);
+}
\ No newline at end of file
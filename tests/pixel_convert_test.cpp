@@ -0,0 +1,119 @@
+#include "test.hpp"
+#include "pixel_convert.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr PixelConvert::Isa isas[] = {PixelConvert::Isa::Scalar, PixelConvert::Isa::SSSE3, PixelConvert::Isa::AVX2};
+constexpr uint8_t guard = 0xA5; // Fills the bytes after the output, a kernel must leave them alone
+
+std::vector<uint8_t> RandomBytes(size_t count, unsigned seed) {
+    std::mt19937 random(seed);
+    std::vector<uint8_t> bytes(count);
+    for (uint8_t &byte : bytes) byte = static_cast<uint8_t>(random());
+    return bytes;
+}
+
+// Runs the test for every instruction set this CPU supports, restoring full dispatch afterwards
+template <typename Fn>
+void ForEachIsa(Fn &&fn) {
+    for (const PixelConvert::Isa isa : isas) {
+        PixelConvert::SetMaxIsa(isa);
+        if (PixelConvert::GetActiveIsa() == isa) fn(isa);
+    }
+    PixelConvert::SetMaxIsa(PixelConvert::Isa::AVX2);
+}
+
+} // namespace
+
+TEST(pixel_convert, BGRAToBGRMatchesReference) {
+    ForEachIsa([](PixelConvert::Isa) {
+        for (size_t width = 1; width <= 67; ++width) {
+            const std::vector<uint8_t> src = RandomBytes(width * 4, static_cast<unsigned>(width));
+            std::vector<uint8_t> dst(width * 3 + 16, guard);
+            PixelConvert::BGRAToBGR(src.data(), dst.data(), width);
+            for (size_t x = 0; x < width; ++x) {
+                CHECK(dst[x * 3 + 0] == src[x * 4 + 0]);
+                CHECK(dst[x * 3 + 1] == src[x * 4 + 1]);
+                CHECK(dst[x * 3 + 2] == src[x * 4 + 2]);
+            }
+            for (size_t i = width * 3; i < dst.size(); ++i) CHECK(dst[i] == guard);
+        }
+    });
+}
+
+TEST(pixel_convert, SwapRedBlueMatchesReference) {
+    ForEachIsa([](PixelConvert::Isa) {
+        for (size_t width = 1; width <= 67; ++width) {
+            const std::vector<uint8_t> src = RandomBytes(width * 4, static_cast<unsigned>(width) + 100);
+            std::vector<uint8_t> dst(width * 4 + 16, guard);
+            PixelConvert::SwapRedBlue(src.data(), dst.data(), width);
+            for (size_t x = 0; x < width; ++x) {
+                CHECK(dst[x * 4 + 0] == src[x * 4 + 2]);
+                CHECK(dst[x * 4 + 1] == src[x * 4 + 1]);
+                CHECK(dst[x * 4 + 2] == src[x * 4 + 0]);
+                CHECK(dst[x * 4 + 3] == src[x * 4 + 3]);
+            }
+            for (size_t i = width * 4; i < dst.size(); ++i) CHECK(dst[i] == guard);
+
+            // In place, twice gives the input back
+            std::vector<uint8_t> pixels = src;
+            PixelConvert::SwapRedBlue(pixels.data(), pixels.data(), width);
+            PixelConvert::SwapRedBlue(pixels.data(), pixels.data(), width);
+            CHECK(pixels == src);
+        }
+    });
+}
+
+TEST(pixel_convert, IsasAgree) {
+    // Every kernel must produce exactly the scalar output, byte for byte
+    for (size_t width = 1; width <= 67; ++width) {
+        const std::vector<uint8_t> src = RandomBytes(width * 4, static_cast<unsigned>(width) + 200);
+        std::vector<uint8_t> bgr[3], swapped[3];
+        size_t tested = 0;
+        ForEachIsa([&](PixelConvert::Isa isa) {
+            const int i = static_cast<int>(isa);
+            bgr[i].assign(width * 3, 0);
+            swapped[i].assign(width * 4, 0);
+            PixelConvert::BGRAToBGR(src.data(), bgr[i].data(), width);
+            PixelConvert::SwapRedBlue(src.data(), swapped[i].data(), width);
+            if (i > 0) {
+                CHECK(bgr[i] == bgr[0]);
+                CHECK(swapped[i] == swapped[0]);
+            }
+            ++tested;
+        });
+        CHECK(tested >= 1);
+    }
+}
+
+TEST(pixel_convert, BGRAToBGRFlippedReversesRows) {
+    ForEachIsa([](PixelConvert::Isa) {
+        for (const int width : {1, 3, 31, 33, 67}) {
+            const int height = 5;
+            const size_t srcPitch = width * 4 + 8; // Padded rows
+            const size_t dstPitch = (width * 3 + 3) & ~size_t(3);
+            const std::vector<uint8_t> src = RandomBytes(srcPitch * height, width);
+            std::vector<uint8_t> dst(dstPitch * height, guard);
+            PixelConvert::BGRAToBGRFlipped(src.data(), srcPitch, dst.data(), dstPitch, width, height);
+            for (int y = 0; y < height; ++y) {
+                const uint8_t *srcRow = src.data() + y * srcPitch;
+                const uint8_t *dstRow = dst.data() + (height - 1 - y) * dstPitch;
+                for (int x = 0; x < width; ++x) {
+                    CHECK(dstRow[x * 3 + 0] == srcRow[x * 4 + 0] && dstRow[x * 3 + 1] == srcRow[x * 4 + 1] &&
+                          dstRow[x * 3 + 2] == srcRow[x * 4 + 2]);
+                }
+                // DIB row padding is untouched
+                for (size_t i = width * 3; i < dstPitch; ++i) CHECK(dstRow[i] == guard);
+            }
+        }
+    });
+}
+
+TEST(pixel_convert, SetOpaque) {
+    std::vector<uint8_t> pixels = RandomBytes(37 * 4, 7);
+    const std::vector<uint8_t> before = pixels;
+    PixelConvert::SetOpaque(pixels.data(), 37);
+    for (size_t i = 0; i < pixels.size(); ++i) CHECK(pixels[i] == (i % 4 == 3 ? 255 : before[i]));
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "png_reader.hpp"
+#include <zlib.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+int Paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+} // namespace
+
+std::vector<uint8_t> PngReader::ReadFile(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+uint32_t PngReader::LoadU32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+bool PngReader::ReadChunks(const std::vector<uint8_t> &file, std::vector<Chunk> &chunks) {
+    constexpr uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    chunks.clear();
+    if (file.size() < 8 || std::memcmp(file.data(), signature, 8) != 0) return false;
+
+    for (size_t pos = 8; pos < file.size();) {
+        if (file.size() - pos < 12) return false;
+        const uint32_t length = LoadU32(&file[pos]);
+        if (file.size() - pos - 12 < length) return false;
+        const uint8_t *type = &file[pos + 4];
+        const uint8_t *data = type + 4;
+        if (crc32(0, type, length + 4) != LoadU32(data + length)) return false;
+
+        chunks.push_back({std::string(reinterpret_cast<const char *>(type), 4), std::vector<uint8_t>(data, data + length)});
+        pos += 12 + length;
+        if (chunks.back().type == "IEND") return pos == file.size();
+    }
+    return false;
+}
+
+bool PngReader::Unfilter(const std::vector<uint8_t> &zlib, int width, int height, std::vector<uint8_t> &bgra) {
+    if (width <= 0 || height <= 0) return false;
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> filtered((rowSize + 1) * height);
+    uLongf filteredSize = static_cast<uLongf>(filtered.size());
+    // Fails on a bad adler32 or a stream that is longer than the image
+    if (uncompress(filtered.data(), &filteredSize, zlib.data(), static_cast<uLong>(zlib.size())) != Z_OK) return false;
+    if (filteredSize != filtered.size()) return false;
+
+    std::vector<uint8_t> previous(rowSize, 0), current(rowSize);
+    bgra.resize(rowSize * height);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *line = filtered.data() + (rowSize + 1) * y;
+        for (size_t i = 0; i < rowSize; ++i) {
+            const int a = i >= 4 ? current[i - 4] : 0;
+            const int b = previous[i];
+            const int c = i >= 4 ? previous[i - 4] : 0;
+            int predicted;
+            switch (line[0]) {
+            case 0: predicted = 0; break;
+            case 1: predicted = a; break;
+            case 2: predicted = b; break;
+            case 3: predicted = (a + b) / 2; break;
+            case 4: predicted = Paeth(a, b, c); break;
+            default: return false;
+            }
+            current[i] = static_cast<uint8_t>(line[1 + i] + predicted);
+        }
+        uint8_t *out = bgra.data() + rowSize * y;
+        for (size_t i = 0; i < rowSize; i += 4) {
+            out[i] = current[i + 2];
+            out[i + 1] = current[i + 1];
+            out[i + 2] = current[i];
+            out[i + 3] = current[i + 3];
+        }
+        std::swap(previous, current);
+    }
+    return true;
+}
+
+bool PngReader::DecodePng(const std::vector<uint8_t> &file, std::vector<uint8_t> &bgra, int &width, int &height) {
+    width = height = 0;
+    std::vector<Chunk> chunks;
+    if (!ReadChunks(file, chunks) || chunks.front().type != "IHDR") return false;
+
+    const std::vector<uint8_t> &header = chunks.front().data;
+    if (header.size() != 13 || header[8] != 8 || header[9] != 6 || header[12] != 0) return false;
+    width = static_cast<int>(LoadU32(header.data()));
+    height = static_cast<int>(LoadU32(header.data() + 4));
+
+    std::vector<uint8_t> idat;
+    for (const Chunk &chunk : chunks) {
+        if (chunk.type == "IDAT") idat.insert(idat.end(), chunk.data.begin(), chunk.data.end());
+    }
+    return Unfilter(idat, width, height, bgra);
+}
\ No newline at end of file
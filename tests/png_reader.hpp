@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Strict reading of the PNG and APNG files the encoders write: 8-bit RGBA, no
+// interlace. Kept in the tests rather than using Utils::DecodePng, which needs
+// stb_image and Direct3D, and so every chunk CRC and zlib checksum is checked.
+namespace PngReader {
+
+struct Chunk {
+    std::string type;
+    std::vector<uint8_t> data;
+};
+
+std::vector<uint8_t> ReadFile(const std::filesystem::path &path);
+uint32_t LoadU32(const uint8_t *p);
+// The chunks after the signature, through IEND. False on a bad signature, length or CRC.
+bool ReadChunks(const std::vector<uint8_t> &file, std::vector<Chunk> &chunks);
+// Inflates a zlib stream of filtered scanlines into top-down BGRA, false unless it is exactly the image
+bool Unfilter(const std::vector<uint8_t> &zlib, int width, int height, std::vector<uint8_t> &bgra);
+// A still PNG, the IDAT chunks joined
+bool DecodePng(const std::vector<uint8_t> &file, std::vector<uint8_t> &bgra, int &width, int &height);
+
+} // namespace PngReader
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "test.hpp"
+#include "rect_packer.hpp"
+#include <random>
+
+namespace {
+
+bool Overlap(const RectPacker::Rect &a, const RectPacker::Rect &b, int padding) {
+    // Padding belongs to each rect, so padded areas must not overlap either
+    return a.x - padding < b.x + b.width + padding && b.x - padding < a.x + a.width + padding &&
+           a.y - padding < b.y + b.height + padding && b.y - padding < a.y + a.height + padding;
+}
+
+void CheckPacking(const std::vector<RectPacker::Rect> &rects, int padding, int width, int height) {
+    for (size_t i = 0; i < rects.size(); ++i) {
+        const RectPacker::Rect &rect = rects[i];
+        CHECK(rect.x - padding >= 0 && rect.y - padding >= 0);
+        CHECK(rect.x + rect.width + padding <= width);
+        CHECK(rect.y + rect.height + padding <= height);
+        for (size_t j = i + 1; j < rects.size(); ++j) {
+            CHECK(!Overlap(rect, rects[j], padding));
+        }
+    }
+}
+
+bool IsPowerOfTwo(int value) { return value > 0 && (value & (value - 1)) == 0; }
+
+} // namespace
+
+TEST(rect_packer, Empty) {
+    std::vector<RectPacker::Rect> rects;
+    int width = -1, height = -1;
+    CHECK(RectPacker::Pack(rects, 1, 1024, width, height));
+    CHECK(width == 0 && height == 0);
+}
+
+TEST(rect_packer, RandomSizesNeverOverlap) {
+    std::mt19937 random(1234);
+    for (int round = 0; round < 200; ++round) {
+        std::uniform_int_distribution<int> count(1, 60), size(1, 70), padding(0, 3);
+        std::vector<RectPacker::Rect> rects(count(random));
+        for (RectPacker::Rect &rect : rects) {
+            rect.width = size(random);
+            rect.height = size(random);
+        }
+        const std::vector<RectPacker::Rect> input = rects;
+        const int pad = padding(random);
+
+        int width = 0, height = 0;
+        CHECK(RectPacker::Pack(rects, pad, 4096, width, height));
+        CHECK(IsPowerOfTwo(width) && IsPowerOfTwo(height));
+        CHECK(width <= 4096 && height <= 4096);
+        CheckPacking(rects, pad, width, height);
+        // Input order and sizes are kept
+        for (size_t i = 0; i < rects.size(); ++i) {
+            CHECK(rects[i].width == input[i].width && rects[i].height == input[i].height);
+        }
+    }
+}
+
+TEST(rect_packer, ExactFit) {
+    // Four 16x16 icons fill a 32x32 atlas with no padding
+    std::vector<RectPacker::Rect> rects(4, {16, 16});
+    int width = 0, height = 0;
+    CHECK(RectPacker::Pack(rects, 0, 32, width, height));
+    CHECK(width == 32 && height == 32);
+    CheckPacking(rects, 0, width, height);
+}
+
+TEST(rect_packer, FullAtlasFails) {
+    // One icon more than fits
+    std::vector<RectPacker::Rect> rects(5, {16, 16});
+    int width = -1, height = -1;
+    CHECK(!RectPacker::Pack(rects, 0, 32, width, height));
+    CHECK(width == 0 && height == 0);
+
+    // With padding the exact fit above no longer fits
+    std::vector<RectPacker::Rect> padded(4, {16, 16});
+    CHECK(!RectPacker::Pack(padded, 1, 32, width, height));
+    CHECK(width == 0 && height == 0);
+}
+
+TEST(rect_packer, TooWideFails) {
+    std::vector<RectPacker::Rect> rects = {{8, 8}, {300, 4}};
+    int width = -1, height = -1;
+    CHECK(!RectPacker::Pack(rects, 0, 256, width, height));
+    CHECK(width == 0 && height == 0);
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "test.hpp"
+#include "screenshot_history.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Random BGRA with padded rows
+struct Capture {
+    int width = 0;
+    int height = 0;
+    size_t pitch = 0;
+    std::vector<uint8_t> bgra;
+
+    Capture(int width, int height, unsigned seed) : width(width), height(height), pitch(static_cast<size_t>(width) * 4 + 16) {
+        std::mt19937 random(seed);
+        bgra.resize(pitch * height);
+        for (uint8_t &byte : bgra) byte = static_cast<uint8_t>(random());
+    }
+
+    uint8_t *At(int x, int y) { return bgra.data() + y * pitch + static_cast<size_t>(x) * 4; }
+
+    uint64_t AddTo(ScreenshotHistory &history, uint64_t perceptualHash = 0) const {
+        return history.Add(bgra.data(), width, height, pitch, perceptualHash);
+    }
+
+    // Decoded pixels are these, tightly packed
+    bool Matches(const std::vector<uint8_t> &out, int w, int h) const {
+        if (w != width || h != height || out.size() != static_cast<size_t>(w) * h * 4) return false;
+        for (int y = 0; y < height; ++y) {
+            if (memcmp(out.data() + static_cast<size_t>(y) * width * 4, bgra.data() + y * pitch, static_cast<size_t>(width) * 4) != 0) return false;
+        }
+        return true;
+    }
+
+    bool DecodesFrom(const ScreenshotHistory &history, uint64_t id) const {
+        std::vector<uint8_t> out;
+        int w = 0, h = 0;
+        return history.Decode(id, out, w, h) && Matches(out, w, h);
+    }
+};
+
+constexpr size_t unlimited = SIZE_MAX;
+
+} // namespace
+
+TEST(screenshot_history, RoundTrip) {
+    ScreenshotHistory history(16, unlimited);
+    // Exact tiles, partial edge tiles and images smaller than one tile
+    const Capture captures[] = {{128, 64, 1}, {130, 70, 2}, {1, 1, 3}, {63, 200, 4}, {300, 5, 5}};
+    std::vector<uint64_t> ids;
+    for (const Capture &capture : captures) ids.push_back(capture.AddTo(history));
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        CHECK(ids[i] != 0);
+        CHECK(captures[i].DecodesFrom(history, ids[i]));
+    }
+    CHECK(history.GetIds() == ids);
+
+    int position = 0, count = 0;
+    history.GetPosition(ids[2], position, count);
+    CHECK(position == 3 && count == 5);
+    history.GetPosition(12345, position, count);
+    CHECK(position == 0 && count == 5);
+
+    std::vector<uint8_t> out;
+    int w = 0, h = 0;
+    CHECK(!history.Decode(12345, out, w, h));
+}
+
+TEST(screenshot_history, InvalidInput) {
+    const Capture capture(8, 8, 1);
+    ScreenshotHistory disabled(0, unlimited);
+    CHECK(capture.AddTo(disabled) == 0);
+
+    ScreenshotHistory history(4, unlimited);
+    CHECK(history.Add(nullptr, 8, 8, 32, 0) == 0);
+    CHECK(history.Add(capture.bgra.data(), 0, 8, 32, 0) == 0);
+    CHECK(history.Add(capture.bgra.data(), 8, 0, 32, 0) == 0);
+    CHECK(history.GetStats().entries == 0);
+}
+
+TEST(screenshot_history, SharesTiles) {
+    ScreenshotHistory history(16, unlimited);
+    Capture first(256, 192, 1);
+    Capture second = first;
+    second.At(100, 100)[1] ^= 0xFF; // Inside tile (1, 1) only
+
+    const uint64_t firstId = first.AddTo(history);
+    const size_t firstBytes = history.GetStats().compressedBytes;
+    const uint64_t secondId = second.AddTo(history);
+
+    const ScreenshotHistory::Stats stats = history.GetStats();
+    CHECK(stats.entries == 2);
+    CHECK(stats.tileReferences == 24);
+    CHECK(stats.uniqueTiles == 13);
+    CHECK(stats.compressedBytes < firstBytes + firstBytes / 6);
+    CHECK(stats.rawBytes == 2u * 256 * 192 * 4);
+    CHECK(first.DecodesFrom(history, firstId));
+    CHECK(second.DecodesFrom(history, secondId));
+
+    // The same capture again adds an entry but no tiles
+    first.AddTo(history);
+    CHECK(history.GetStats().uniqueTiles == 13);
+    CHECK(history.GetStats().compressedBytes == stats.compressedBytes);
+}
+
+TEST(screenshot_history, RepeatedContent) {
+    // A blank capture is one tile, an edge tile of the same colour is another size and not shared with it
+    Capture blank(256, 128, 1);
+    Capture edge(100, 64, 1);
+    for (Capture *capture : {&blank, &edge}) std::fill(capture->bgra.begin(), capture->bgra.end(), 0x7F);
+
+    ScreenshotHistory history(16, unlimited);
+    const uint64_t blankId = blank.AddTo(history);
+    CHECK(history.GetStats().uniqueTiles == 1);
+    const uint64_t edgeId = edge.AddTo(history);
+    CHECK(history.GetStats().uniqueTiles == 2);
+    CHECK(blank.DecodesFrom(history, blankId));
+    CHECK(edge.DecodesFrom(history, edgeId));
+}
+
+TEST(screenshot_history, EvictsByCount) {
+    ScreenshotHistory history(3, unlimited);
+    std::vector<Capture> captures;
+    std::vector<uint64_t> ids;
+    for (unsigned i = 0; i < 5; ++i) {
+        captures.emplace_back(100, 80, i + 1);
+        ids.push_back(captures.back().AddTo(history));
+    }
+
+    CHECK(history.GetIds() == std::vector<uint64_t>(ids.begin() + 2, ids.end()));
+    std::vector<uint8_t> out;
+    int w = 0, h = 0;
+    CHECK(!history.Decode(ids[0], out, w, h));
+    CHECK(captures[4].DecodesFrom(history, ids[4]));
+
+    // Tiles of the dropped entries are gone, the survivors' are all kept
+    const ScreenshotHistory::Stats stats = history.GetStats();
+    CHECK(stats.entries == 3);
+    CHECK(stats.uniqueTiles == 3 * 4);
+    CHECK(stats.tileReferences == 3 * 4);
+}
+
+TEST(screenshot_history, EvictsByBudget) {
+    const Capture sample(128, 128, 99);
+    size_t entryBytes = 0;
+    {
+        ScreenshotHistory measure(16, unlimited);
+        sample.AddTo(measure);
+        entryBytes = measure.GetStats().compressedBytes;
+    }
+
+    // Room for two entries of random content, not three
+    ScreenshotHistory history(16, entryBytes * 5 / 2);
+    std::vector<uint64_t> ids;
+    for (unsigned i = 0; i < 4; ++i) ids.push_back(Capture(128, 128, i + 1).AddTo(history));
+    CHECK(history.GetIds() == std::vector<uint64_t>(ids.begin() + 2, ids.end()));
+    CHECK(history.GetStats().compressedBytes <= entryBytes * 5 / 2);
+
+    // The newest entry is kept even when it alone is over budget
+    ScreenshotHistory tiny(16, 1);
+    sample.AddTo(tiny);
+    const uint64_t last = Capture(128, 128, 7).AddTo(tiny);
+    CHECK(tiny.GetIds() == std::vector<uint64_t>{last});
+    CHECK(tiny.GetStats().compressedBytes > 1);
+}
+
+TEST(screenshot_history, DecodeDuringEviction) {
+    // Tiles held by a Decode while their entry is evicted stay in the map, a later eviction sweeps them
+    constexpr int width = 192, height = 128;
+    ScreenshotHistory history(2, unlimited);
+    std::vector<Capture> captures;
+    for (unsigned i = 0; i < 40; ++i) captures.emplace_back(width, height, i + 1);
+
+    captures[0].AddTo(history);
+    std::atomic<bool> done = false;
+    std::atomic<int> wrongPixels = 0;
+    std::thread reader([&]() {
+        std::vector<uint8_t> out;
+        while (!done) {
+            // The oldest entry, next in line for eviction
+            const std::vector<uint64_t> ids = history.GetIds();
+            int w = 0, h = 0;
+            // Either evicted meanwhile or decoded intact
+            if (history.Decode(ids.front(), out, w, h) && !captures[ids.front() - 1].Matches(out, w, h)) ++wrongPixels;
+        }
+    });
+    for (size_t i = 1; i < captures.size() - 1; ++i) captures[i].AddTo(history);
+    done = true;
+    reader.join();
+    CHECK(wrongPixels == 0);
+
+    // With no Decode running, the next eviction leaves exactly the tiles of the two stored entries
+    captures.back().AddTo(history);
+    ScreenshotHistory expected(2, unlimited);
+    captures[captures.size() - 2].AddTo(expected);
+    captures.back().AddTo(expected);
+    CHECK(history.GetStats().uniqueTiles == expected.GetStats().uniqueTiles);
+    CHECK(history.GetStats().compressedBytes == expected.GetStats().compressedBytes);
+}
+
+TEST(screenshot_history, FindSimilar) {
+    ScreenshotHistory history(8, unlimited);
+    const uint64_t older = Capture(16, 16, 1).AddTo(history, 0xFF00);
+    const uint64_t newer = Capture(16, 16, 2).AddTo(history, 0xFF01);
+    // The newest match wins, distance counts differing bits
+    CHECK(history.FindSimilar(0xFF00, 1) == newer);
+    CHECK(history.FindSimilar(0xFF00, 0) == older);
+    CHECK(history.FindSimilar(0x00FF, 4) == 0);
+    CHECK(history.FindSimilar(0xFF00, -1) == 0);
+}
+
+TEST(screenshot_history, Clear) {
+    ScreenshotHistory history(8, unlimited);
+    const Capture capture(70, 70, 1);
+    capture.AddTo(history);
+    history.Clear();
+    const ScreenshotHistory::Stats stats = history.GetStats();
+    CHECK(stats.entries == 0 && stats.uniqueTiles == 0 && stats.compressedBytes == 0);
+    // Ids keep counting, an old id never names a new entry
+    CHECK(capture.AddTo(history) == 2);
+}
\ No newline at end of file
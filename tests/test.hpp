@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+
+// Minimal test harness. TEST(suite, name) registers a case, CHECK records a
+// failure and carries on so one run reports every broken expectation. Each
+// suite is run as its own ctest test by passing its name to the executable.
+#define TEST(suite, name)                                                                          \
+    static void suite##_##name();                                                                  \
+    static const bool suite##_##name##_registered = Test::Register(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(expression)                                               \
+    do {                                                                \
+        if (!(expression)) Test::Fail(__FILE__, __LINE__, #expression); \
+    } while (0)
+
+namespace Test {
+
+struct Case {
+    const char *suite;
+    const char *name;
+    void (*run)();
+};
+
+std::vector<Case> &GetCases();
+bool Register(const char *suite, const char *name, void (*run)());
+void Fail(const char *file, int line, const char *expression);
+
+} // namespace Test
\ No newline at end of file
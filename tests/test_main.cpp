@@ -0,0 +1,44 @@
+#include "test.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+int failures = 0;
+
+} // namespace
+
+std::vector<Test::Case> &Test::GetCases() {
+    // Function local, registration runs during static initialization of other files
+    static std::vector<Case> cases;
+    return cases;
+}
+
+bool Test::Register(const char *suite, const char *name, void (*run)()) {
+    GetCases().push_back({suite, name, run});
+    return true;
+}
+
+void Test::Fail(const char *file, int line, const char *expression) {
+    ++failures;
+    fprintf(stderr, "%s(%d): CHECK failed: %s\n", file, line, expression);
+}
+
+// Usage: WebFrameTests [suite], runs every suite without an argument
+int main(int argc, char *argv[]) {
+    const char *suite = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    for (const Test::Case &testCase : Test::GetCases()) {
+        if (suite && strcmp(suite, testCase.suite) != 0) continue;
+        const int failuresBefore = failures;
+        testCase.run();
+        ++run;
+        printf("%s %s.%s\n", failures == failuresBefore ? "[ OK ]" : "[FAIL]", testCase.suite, testCase.name);
+    }
+    if (run == 0) {
+        fprintf(stderr, "No tests match \"%s\"\n", suite ? suite : "");
+        return 1;
+    }
+    printf("%d tests, %d failed checks\n", run, failures);
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file